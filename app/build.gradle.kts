@@ -56,6 +56,17 @@ android {
             excludes += "/META-INF/{AL2.0,LGPL2.1}"
         }
     }
+
+    testOptions {
+        // 本地单元测试中 android.util.Log 等桩方法返回默认值而不是抛异常
+        unitTests.isReturnDefaultValues = true
+        unitTests.all {
+            // 主机端基准测试默认跳过，-Pbench 时启用，结果写入 build/bench
+            systemProperty("coughdetect.bench", project.hasProperty("bench").toString())
+            systemProperty("coughdetect.bench.dir", layout.buildDirectory.dir("bench").get().asFile.absolutePath)
+            systemProperty("coughdetect.bench.corpus", project.findProperty("benchCorpus")?.toString() ?: "")
+        }
+    }
     
 
 }
@@ -6,7 +6,9 @@ import android.util.Log
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
+import org.voiddog.coughdetect.data.EventLog
 import java.io.File
+import java.io.FileInputStream
 
 class AudioPlayer(private val context: Context) {
     
@@ -30,7 +32,9 @@ class AudioPlayer(private val context: Context) {
             // 停止当前播放
             stop()
             
-            val file = File(filePath)
+            // 事件日志中的片段以 段文件#偏移+长度 引用
+            val clipRef = EventLog.ClipRef.parse(filePath)
+            val file = clipRef?.file ?: File(filePath)
             Log.d(TAG, "检查音频文件是否存在: $filePath, 文件存在: ${file.exists()}, 文件大小: ${if (file.exists()) file.length() else 0}")
             
             if (!file.exists()) {
@@ -39,7 +43,7 @@ class AudioPlayer(private val context: Context) {
                 return false
             }
             
-            if (file.length() == 0L) {
+            if (file.length() == 0L || (clipRef != null && file.length() < clipRef.offset + clipRef.length)) {
                 Log.w(TAG, "音频文件为空: $filePath")
                 _error.value = "音频文件为空"
                 return false
@@ -48,7 +52,14 @@ class AudioPlayer(private val context: Context) {
             Log.i(TAG, "开始播放音频: $filePath")
             
             mediaPlayer = MediaPlayer().apply {
-                setDataSource(filePath)
+                if (clipRef != null) {
+                    // MediaPlayer 会复制文件描述符，设置完即可关闭
+                    FileInputStream(clipRef.file).use { input ->
+                        setDataSource(input.fd, clipRef.offset, clipRef.length.toLong())
+                    }
+                } else {
+                    setDataSource(filePath)
+                }
                 
                 setOnPreparedListener { mp ->
                     Log.d(TAG, "音频准备完成，开始播放")
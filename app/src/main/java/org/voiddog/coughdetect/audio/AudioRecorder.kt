@@ -4,7 +4,9 @@ import android.Manifest
 import android.content.Context
 import android.content.pm.PackageManager
 import android.media.AudioFormat
+import android.media.AudioManager
 import android.media.AudioRecord
+import android.media.AudioTimestamp
 import android.media.MediaRecorder
 import android.util.Log
 import androidx.core.app.ActivityCompat
@@ -12,46 +14,80 @@ import kotlinx.coroutines.*
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
+import org.voiddog.coughdetect.ml.AudioFeatures
+import org.voiddog.coughdetect.utils.Constants
+import org.voiddog.coughdetect.utils.ThreadPlacement
+import java.util.concurrent.Executors
 import java.util.concurrent.atomic.AtomicBoolean
-import kotlin.math.sqrt
 
-class AudioRecorder(private val context: Context) {
+/**
+ * 麦克风音频源
+ *
+ * 优先以设备原生采样率录音，避开系统的采样率转换和由此带来的额外延迟，再由
+ * [PolyphaseResampler] 降到检测用的 16kHz；原生采样率不可用时退回直接以 16kHz 录音。
+ */
+class AudioRecorder(
+    private val context: Context,
+    private val resamplerQuality: PolyphaseResampler.Quality = PolyphaseResampler.Quality.MEDIUM
+) : AudioSource {
     
     companion object {
         private const val TAG = "AudioRecorder"
-        private const val SAMPLE_RATE = 16000
+        private const val SAMPLE_RATE = Constants.Audio.SAMPLE_RATE
         private const val CHANNEL_CONFIG = AudioFormat.CHANNEL_IN_MONO
         private const val AUDIO_FORMAT = AudioFormat.ENCODING_PCM_16BIT
         private const val BUFFER_SIZE_MULTIPLIER = 4
+        private const val TIMESTAMP_INTERVAL_NS = 1_000_000_000L // Input latency refresh interval
+        private const val RECOVERY_INITIAL_BACKOFF_MS = 100L
+        private const val RECOVERY_MAX_BACKOFF_MS = 5000L
+        private const val RECOVERY_MAX_ATTEMPTS = 12 // About 40 seconds in total before giving up
+        
+        // 录音循环独占一个音频优先级的线程，不占用也不抬高共享的 IO 线程池
+        private val captureDispatcher = Executors.newSingleThreadExecutor { runnable ->
+            Thread({
+                ThreadPlacement.apply(ThreadPlacement.Role.CAPTURE)
+                runnable.run()
+            }, "AudioCapture").apply {
+                isDaemon = true
+            }
+        }.asCoroutineDispatcher()
     }
     
+    // 录音线程在流断开后会替换它
+    @Volatile
     private var audioRecord: AudioRecord? = null
     private var recordingJob: Job? = null
     private val isRecording = AtomicBoolean(false)
     private val isPaused = AtomicBoolean(false)
     
-    private val _audioLevel = MutableStateFlow(0f)
-    val audioLevel: StateFlow<Float> = _audioLevel.asStateFlow()
-    
     private val _isRecordingState = MutableStateFlow(false)
     val isRecordingState: StateFlow<Boolean> = _isRecordingState.asStateFlow()
     
     private val _error = MutableStateFlow<String?>(null)
     val error: StateFlow<String?> = _error.asStateFlow()
     
-    private var audioDataCallback: ((FloatArray, Float) -> Unit)? = null
-    private val bufferSize: Int
+    private var audioDataCallback: AudioDataCallback? = null
+    @Volatile
+    private var pcm16DataCallback: Pcm16DataCallback? = null
+    private var bufferSize = 0
+    // 实际录音采样率；与 SAMPLE_RATE 不同时经 resampler 转换
+    private var captureSampleRate = SAMPLE_RATE
+    private var resampler: PolyphaseResampler? = null
+    private val streamHealth = StreamHealth()
+    @Volatile
+    private var streamGapCallback: StreamGapCallback? = null
     
-    init {
-        bufferSize = AudioRecord.getMinBufferSize(SAMPLE_RATE, CHANNEL_CONFIG, AUDIO_FORMAT) * BUFFER_SIZE_MULTIPLIER
-        Log.d(TAG, "初始化AudioRecorder，缓冲区大小: $bufferSize")
+    override fun setAudioDataCallback(callback: AudioDataCallback) {
+        audioDataCallback = callback
     }
     
-    fun setAudioDataCallback(callback: (FloatArray, Float) -> Unit) {
-        audioDataCallback = callback
+    override fun supportsPcm16(): Boolean = true
+    
+    override fun setPcm16DataCallback(callback: Pcm16DataCallback?) {
+        pcm16DataCallback = callback
     }
     
-    fun initialize(): Boolean {
+    override fun initialize(): Boolean {
         return try {
             if (!checkAudioPermission()) {
                 _error.value = "缺少音频录制权限"
@@ -63,24 +99,27 @@ class AudioRecorder(private val context: Context) {
                 return true
             }
             
-            audioRecord = AudioRecord(
-                MediaRecorder.AudioSource.MIC,
-                SAMPLE_RATE,
-                CHANNEL_CONFIG,
-                AUDIO_FORMAT,
-                bufferSize
-            )
+            val nativeRate = queryNativeSampleRate()
+            audioRecord = if (nativeRate != SAMPLE_RATE) openAudioRecord(nativeRate) else null
+            if (audioRecord == null) {
+                audioRecord = openAudioRecord(SAMPLE_RATE)
+            }
             
-            val state = audioRecord?.state
-            if (state != AudioRecord.STATE_INITIALIZED) {
-                Log.e(TAG, "AudioRecord初始化失败，状态: $state")
+            val record = audioRecord
+            if (record == null) {
+                Log.e(TAG, "AudioRecord初始化失败")
                 _error.value = "AudioRecord初始化失败"
-                audioRecord?.release()
-                audioRecord = null
                 return false
             }
             
-            Log.i(TAG, "✅ AudioRecorder初始化成功")
+            captureSampleRate = record.sampleRate
+            resampler = if (captureSampleRate != SAMPLE_RATE) {
+                PolyphaseResampler(captureSampleRate, SAMPLE_RATE, resamplerQuality)
+            } else {
+                null
+            }
+            
+            Log.i(TAG, "✅ AudioRecorder初始化成功，录音采样率: $captureSampleRate，缓冲区大小: $bufferSize")
             true
         } catch (e: Exception) {
             Log.e(TAG, "初始化AudioRecord时发生异常", e)
@@ -89,7 +128,7 @@ class AudioRecorder(private val context: Context) {
         }
     }
     
-    fun start(): Boolean {
+    override fun start(): Boolean {
         return try {
             if (isRecording.get()) {
                 Log.w(TAG, "录制已在进行中")
@@ -110,6 +149,8 @@ class AudioRecorder(private val context: Context) {
                     return false
                 }
                 
+                resampler?.reset()
+                streamHealth.start(captureSampleRate, bufferSize / 2)
                 isRecording.set(true)
                 isPaused.set(false)
                 _isRecordingState.value = true
@@ -126,7 +167,7 @@ class AudioRecorder(private val context: Context) {
         }
     }
     
-    fun stop() {
+    override fun stop() {
         try {
             if (!isRecording.get()) {
                 Log.w(TAG, "录制未在进行中")
@@ -152,8 +193,9 @@ class AudioRecorder(private val context: Context) {
                 }
             }
             
-            _audioLevel.value = 0f
-            Log.i(TAG, "✅ 音频录制已停止")
+            val health = streamHealth.snapshot()
+            Log.i(TAG, "✅ 音频录制已停止，读取帧数: ${health.framesRead}/${health.framesExpected}, " +
+                    "溢出: ${health.xrunCount}, 输入延迟: ${health.inputLatencyUs}us")
             
         } catch (e: Exception) {
             Log.e(TAG, "停止录制时发生异常", e)
@@ -161,21 +203,21 @@ class AudioRecorder(private val context: Context) {
         }
     }
     
-    fun pause() {
+    override fun pause() {
         if (isRecording.get()) {
             isPaused.set(true)
             Log.i(TAG, "⏸️ 音频录制已暂停")
         }
     }
     
-    fun resume() {
+    override fun resume() {
         if (isRecording.get() && isPaused.get()) {
             isPaused.set(false)
             Log.i(TAG, "▶️ 音频录制已恢复")
         }
     }
     
-    fun release() {
+    override fun release() {
         try {
             stop()
             
@@ -195,65 +237,213 @@ class AudioRecorder(private val context: Context) {
         }
     }
     
-    fun getSampleRate(): Int = SAMPLE_RATE
+    override fun getSampleRate(): Int = SAMPLE_RATE
+    
+    override fun getStreamHealth(): StreamHealth = streamHealth
+    
+    override fun setStreamGapCallback(callback: StreamGapCallback?) {
+        streamGapCallback = callback
+    }
+    
+    /**
+     * 实际的录音采样率（初始化之后有效）
+     */
+    fun getCaptureSampleRate(): Int = captureSampleRate
     
     fun isRecording(): Boolean = isRecording.get()
     
     fun isPaused(): Boolean = isPaused.get()
     
-    fun clearError() {
+    override fun clearError() {
         _error.value = null
     }
     
     private fun startRecordingLoop() {
-        recordingJob = CoroutineScope(Dispatchers.IO).launch {
+        recordingJob = CoroutineScope(captureDispatcher).launch {
+            // 缓冲区在循环外分配一次，稳态下读取循环不分配内存
             val buffer = ShortArray(bufferSize / 2) // 16-bit samples
-            val floatBuffer = FloatArray(bufferSize / 2)
+            val captureBuffer = FloatArray(buffer.size)
+            val resampler = resampler
+            val floatBuffer = if (resampler != null) FloatArray(resampler.maxOutputSize(buffer.size)) else captureBuffer
+            // 重采样后再交给 PCM 回调时使用
+            val pcmBuffer = if (resampler != null) ShortArray(floatBuffer.size) else buffer
+            val timestamp = AudioTimestamp()
+            var lastTimestampNanos = 0L
+            // 最近一次成功读取的时刻，用于计算断开重连的中断时长
+            var lastGoodReadNanos = System.nanoTime()
             
             while (isRecording.get() && isActive) {
                 try {
                     if (isPaused.get()) {
+                        streamHealth.markDiscontinuity()
                         delay(10)
                         continue
                     }
                     
-                    val bytesRead = audioRecord?.read(buffer, 0, buffer.size) ?: 0
+                    val record = audioRecord
+                    val bytesRead = record?.read(buffer, 0, buffer.size) ?: 0
+                    val readNanos = System.nanoTime()
                     
-                    if (bytesRead > 0) {
-                        // Convert short to float and normalize
-                        for (i in 0 until bytesRead) {
-                            floatBuffer[i] = buffer[i] / 32768.0f
+                    if (bytesRead < 0) {
+                        // Typically ERROR_DEAD_OBJECT after a headset unplug or route change
+                        Log.e(TAG, "读取音频数据错误: $bytesRead，尝试重新打开音频流")
+                        if (!recoverStream(lastGoodReadNanos)) {
+                            _error.value = "读取音频数据失败"
+                            break
+                        }
+                        lastGoodReadNanos = System.nanoTime()
+                        continue
+                    }
+                    if (bytesRead == 0) {
+                        continue
+                    }
+                    lastGoodReadNanos = readNanos
+                    
+                    streamHealth.recordRead(bytesRead, buffer.size, readNanos)
+                    // Refresh the timestamp-derived input latency about once a second
+                    if (record != null && readNanos - lastTimestampNanos >= TIMESTAMP_INTERVAL_NS &&
+                        record.getTimestamp(timestamp, AudioTimestamp.TIMEBASE_MONOTONIC) == AudioRecord.SUCCESS
+                    ) {
+                        streamHealth.updateInputLatency(
+                            timestamp.framePosition, timestamp.nanoTime, streamHealth.getFramesRead(), readNanos
+                        )
+                        lastTimestampNanos = readNanos
+                    }
+                    
+                    val pcm16Callback = pcm16DataCallback
+                    if (pcm16Callback != null && resampler == null) {
+                        // Native rate is the detection rate: hand the PCM over without any conversion
+                        val audioLevel = AudioFeatures.rmsPcm16(buffer, 0, bytesRead)
+                        if (!isPaused.get()) {
+                            pcm16Callback.onPcm16Data(buffer, bytesRead, audioLevel)
                         }
+                    } else {
+                        // Convert short to float and normalize
+                        AudioFeatures.pcm16ToFloat(buffer, captureBuffer, bytesRead)
+                        
+                        // Downsample to the detection rate when capturing at the native rate
+                        val count = resampler?.process(captureBuffer, 0, bytesRead, floatBuffer) ?: bytesRead
                         
                         // Calculate audio level (RMS)
-                        val audioLevel = calculateRMS(floatBuffer, bytesRead)
-                        _audioLevel.value = audioLevel
+                        val audioLevel = AudioFeatures.rms(floatBuffer, 0, count)
                         
-                        // Callback with audio data
-                        if (!isPaused.get()) {
-                            audioDataCallback?.invoke(floatBuffer.copyOf(bytesRead), audioLevel)
+                        // Callback with audio data (the buffer is reused, the receiver copies what it keeps)
+                        if (count > 0 && !isPaused.get()) {
+                            if (pcm16Callback != null) {
+                                AudioFeatures.floatToPcm16(floatBuffer, 0, pcmBuffer, 0, count)
+                                pcm16Callback.onPcm16Data(pcmBuffer, count, audioLevel)
+                            } else {
+                                audioDataCallback?.onAudioData(floatBuffer, count, audioLevel)
+                            }
                         }
-                    } else if (bytesRead < 0) {
-                        Log.e(TAG, "读取音频数据错误: $bytesRead")
-                        _error.value = "读取音频数据失败"
-                        break
                     }
+                    streamHealth.recordProcessingTime(System.nanoTime() - readNanos)
                     
+                } catch (e: CancellationException) {
+                    throw e
                 } catch (e: Exception) {
-                    Log.e(TAG, "录制循环中发生异常", e)
-                    _error.value = "录制异常: ${e.message}"
-                    break
+                    Log.e(TAG, "录制循环中发生异常，尝试重新打开音频流", e)
+                    if (!recoverStream(lastGoodReadNanos)) {
+                        _error.value = "录制异常: ${e.message}"
+                        break
+                    }
+                    lastGoodReadNanos = System.nanoTime()
+                }
+            }
+        }
+    }
+    
+    /**
+     * 流断开后以指数退避重新打开，在录音协程（采集线程）上执行。
+     * 成功时通过 [StreamGapCallback] 报告中断期间丢失的音频，返回 false 表示放弃。
+     */
+    private suspend fun recoverStream(lastGoodReadNanos: Long): Boolean {
+        var backoffMs = RECOVERY_INITIAL_BACKOFF_MS
+        for (attempt in 1..RECOVERY_MAX_ATTEMPTS) {
+            closeAudioRecord()
+            delay(backoffMs)
+            if (!isRecording.get()) return false
+            
+            val record = openAudioRecord(captureSampleRate)
+            if (record != null) {
+                try {
+                    record.startRecording()
+                } catch (e: IllegalStateException) {
+                    Log.w(TAG, "重新开始录制失败", e)
                 }
+                if (record.recordingState == AudioRecord.RECORDSTATE_RECORDING && isRecording.get()) {
+                    audioRecord = record
+                    resampler?.reset()
+                    
+                    val gapNanos = System.nanoTime() - lastGoodReadNanos
+                    streamHealth.recordRestart(gapNanos)
+                    streamGapCallback?.onStreamGap(gapNanos * SAMPLE_RATE / 1_000_000_000L, gapNanos)
+                    Log.i(TAG, "✅ 音频流已恢复（第 $attempt 次尝试），中断 ${gapNanos / 1_000_000}ms")
+                    return true
+                }
+                record.release()
+            }
+            
+            backoffMs = minOf(backoffMs * 2, RECOVERY_MAX_BACKOFF_MS)
+            Log.w(TAG, "第 $attempt 次重新打开音频流失败")
+        }
+        Log.e(TAG, "❌ 多次尝试后仍无法恢复音频流")
+        return false
+    }
+    
+    private fun closeAudioRecord() {
+        val record = audioRecord ?: return
+        audioRecord = null
+        try {
+            if (record.recordingState == AudioRecord.RECORDSTATE_RECORDING) {
+                record.stop()
             }
+        } catch (e: Exception) {
+            Log.w(TAG, "关闭断开的AudioRecord时发生异常", e)
         }
+        record.release()
+    }
+    
+    /**
+     * 设备原生采样率，查询不到时按最常见的 48kHz 处理
+     */
+    private fun queryNativeSampleRate(): Int {
+        val audioManager = context.getSystemService(Context.AUDIO_SERVICE) as? AudioManager
+        return audioManager?.getProperty(AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE)?.toIntOrNull()
+            ?: Constants.Audio.PREFERRED_CAPTURE_SAMPLE_RATE
     }
     
-    private fun calculateRMS(data: FloatArray, length: Int): Float {
-        var sum = 0.0
-        for (i in 0 until length) {
-            sum += data[i] * data[i]
+    /**
+     * 以 [sampleRate] 创建 AudioRecord，失败时返回 null
+     */
+    private fun openAudioRecord(sampleRate: Int): AudioRecord? {
+        val minBufferSize = AudioRecord.getMinBufferSize(sampleRate, CHANNEL_CONFIG, AUDIO_FORMAT)
+        if (minBufferSize <= 0) {
+            Log.w(TAG, "不支持的录音采样率: $sampleRate")
+            return null
+        }
+        
+        val record = try {
+            AudioRecord(
+                MediaRecorder.AudioSource.MIC,
+                sampleRate,
+                CHANNEL_CONFIG,
+                AUDIO_FORMAT,
+                minBufferSize * BUFFER_SIZE_MULTIPLIER
+            )
+        } catch (e: IllegalArgumentException) {
+            Log.w(TAG, "以 $sampleRate Hz 创建AudioRecord失败: ${e.message}")
+            return null
+        }
+        
+        if (record.state != AudioRecord.STATE_INITIALIZED) {
+            Log.w(TAG, "以 $sampleRate Hz 初始化AudioRecord失败，状态: ${record.state}")
+            record.release()
+            return null
         }
-        return sqrt(sum / length).toFloat()
+        
+        bufferSize = minBufferSize * BUFFER_SIZE_MULTIPLIER
+        return record
     }
     
     private fun checkAudioPermission(): Boolean {
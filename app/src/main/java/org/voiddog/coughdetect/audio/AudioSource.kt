@@ -0,0 +1,82 @@
+package org.voiddog.coughdetect.audio
+
+/**
+ * 引擎的音频输入
+ *
+ * 设备上由 [AudioRecorder] 实现；主机端测试和基准测试可以换成文件或合成信号，
+ * 以不受实时速度限制的方式驱动完整的 CoughDetectEngine。
+ */
+interface AudioSource {
+
+    fun initialize(): Boolean
+
+    fun start(): Boolean
+
+    fun stop()
+
+    fun pause()
+
+    fun resume()
+
+    fun release()
+
+    fun getSampleRate(): Int
+
+    fun setAudioDataCallback(callback: AudioDataCallback)
+
+    /**
+     * 是否能直接提供 16-bit PCM（[setPcm16DataCallback]）
+     */
+    fun supportsPcm16(): Boolean = false
+
+    /**
+     * 设置后音频源改为回调 16-bit PCM，不再调用 [AudioDataCallback]；传 null 恢复 float 回调。
+     * 不支持的音频源忽略此调用。
+     */
+    fun setPcm16DataCallback(callback: Pcm16DataCallback?) {}
+
+    /**
+     * 采集流的健康统计，不支持的音频源返回 null
+     */
+    fun getStreamHealth(): StreamHealth? = null
+
+    /**
+     * 采集流断开后自动重连时，报告中断期间丢失的音频；不会断开的音频源忽略此调用
+     */
+    fun setStreamGapCallback(callback: StreamGapCallback?) {}
+
+    fun clearError()
+}
+
+/**
+ * 音频数据回调
+ *
+ * [samples] 是音频源复用的缓冲区，只有前 [length] 个样本有效，且只在回调期间有效，
+ * 需要保留时自行复制。参数都是基本类型，调用时不会装箱。
+ */
+fun interface AudioDataCallback {
+    fun onAudioData(samples: FloatArray, length: Int, level: Float)
+}
+
+/**
+ * 16-bit PCM 音频数据回调，缓冲区约定与 [AudioDataCallback] 相同
+ */
+fun interface Pcm16DataCallback {
+    fun onPcm16Data(samples: ShortArray, length: Int, level: Float)
+}
+
+/**
+ * 采集中断回调：流重新打开后、恢复交付数据之前，在录音线程上调用。
+ * [lostSamples] 按 [AudioSource.getSampleRate] 计，[lostNanos] 是中断的时长。
+ */
+fun interface StreamGapCallback {
+    fun onStreamGap(lostSamples: Long, lostNanos: Long)
+}
+
+/**
+ * 引擎历史缓冲区的样本格式
+ */
+enum class SampleFormat(val bytesPerSample: Int) {
+    FLOAT(4),
+    PCM16(2)
+}
@@ -0,0 +1,178 @@
+package org.voiddog.coughdetect.audio
+
+import android.util.Log
+import org.voiddog.coughdetect.utils.ThreadPlacement
+import java.io.Closeable
+import java.io.File
+import java.io.RandomAccessFile
+import java.nio.ByteBuffer
+import java.nio.channels.FileChannel
+import java.util.concurrent.ArrayBlockingQueue
+import java.util.concurrent.CancellationException
+import java.util.concurrent.CompletableFuture
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+
+/**
+ * 片段的异步写入端
+ *
+ * 把一个片段写入文件中从 [startOffset] 开始的区域：调用线程把数据填入预分配的大块直接缓冲区，
+ * 写满后交给共享的后台 I/O 线程落盘；[finish] 时在同一线程上提交剩余数据，然后关闭文件。
+ * 事件日志（[org.voiddog.coughdetect.data.EventLog]）用它把片段追加到段文件，文件中这个区域以外的
+ * 内容不受影响。没有 [finish] 就 [close]（例如写入中途抛出异常）视为放弃，手上的缓冲区归还到池里。
+ * 出错或放弃时已经写入的部分留在文件里，由调用方决定是否引用。
+ */
+internal class ClipFileSink(
+    private val file: File,
+    private val startOffset: Long = 0L
+) : Closeable {
+
+    companion object {
+        private const val TAG = "ClipFileSink"
+        private const val IO_BUFFER_SIZE = 64 * 1024
+        private const val IO_BUFFER_COUNT = 4
+        private const val BUFFER_WAIT_MS = 200L
+
+        // 所有片段共用一个 I/O 线程，保证同一文件的写入顺序，也避免线程数随片段数增长
+        private val ioExecutor: ExecutorService = Executors.newSingleThreadExecutor { runnable ->
+            Thread({
+                ThreadPlacement.apply(ThreadPlacement.Role.IO)
+                runnable.run()
+            }, "ClipFileSink-IO").apply {
+                isDaemon = true
+            }
+        }
+
+        // 预分配的 I/O 缓冲区池；全部在途时调用线程等待，形成背压
+        private val bufferPool = ArrayBlockingQueue<ByteBuffer>(IO_BUFFER_COUNT).apply {
+            repeat(IO_BUFFER_COUNT) {
+                offer(ByteBuffer.allocateDirect(IO_BUFFER_SIZE))
+            }
+        }
+    }
+
+    private val completion = CompletableFuture<Long>()
+    private var current: ByteBuffer? = null
+    private var finished = false
+
+    var bytesWritten = 0L
+        private set
+
+    // 以下字段只在 I/O 线程访问
+    private var channel: FileChannel? = null
+    private var writePosition = startOffset
+    @Volatile private var failure: Throwable? = null
+
+    fun put(bytes: ByteArray, offset: Int = 0, length: Int = bytes.size - offset) {
+        check(!finished) { "ClipFileSink already finished" }
+        var written = 0
+        while (written < length) {
+            val buffer = current ?: acquireBuffer()
+            val n = minOf(buffer.remaining(), length - written)
+            buffer.put(bytes, offset + written, n)
+            written += n
+            bytesWritten += n
+            submitIfFull(buffer)
+        }
+    }
+
+    /**
+     * 提交剩余数据后关闭文件。立即返回，落盘完成后 future 以片段字节数完成，
+     * 回调在 I/O 线程上执行；出错时以异常完成。
+     */
+    fun finish(): CompletableFuture<Long> {
+        if (finished) return completion
+        finished = true
+
+        val last = current
+        current = null
+        if (last != null) {
+            submit(last)
+        }
+
+        val total = bytesWritten
+        ioExecutor.execute {
+            try {
+                val error = failure
+                if (error != null) throw error
+                // 空片段也创建文件，和有数据时一样
+                openChannel().close()
+                channel = null
+                completion.complete(total)
+            } catch (e: Throwable) {
+                Log.e(TAG, "写入片段失败: ${file.absolutePath}@$startOffset", e)
+                closeChannel()
+                completion.completeExceptionally(e)
+            }
+        }
+        return completion
+    }
+
+    /**
+     * 放弃写入：归还手上的缓冲区，已经提交的数据落盘后关闭文件，future 以取消异常完成。
+     * 在 [finish] 之后调用没有效果。
+     */
+    fun abort() {
+        if (finished) return
+        finished = true
+
+        current?.let { bufferPool.offer(it) }
+        current = null
+        ioExecutor.execute {
+            closeChannel()
+            completion.completeExceptionally(CancellationException("clip write aborted: ${file.name}@$startOffset"))
+        }
+    }
+
+    override fun close() {
+        abort()
+    }
+
+    private fun submitIfFull(buffer: ByteBuffer) {
+        if (!buffer.hasRemaining()) {
+            current = null
+            submit(buffer)
+        }
+    }
+
+    private fun acquireBuffer(): ByteBuffer {
+        // 池里的缓冲区都在途时等 I/O 线程归还；等不到就临时分配一个（归还时池已满会被丢弃），
+        // 所以缓冲区即使因为异常没有归还，之后的写入也不会永远阻塞
+        val buffer = bufferPool.poll(BUFFER_WAIT_MS, TimeUnit.MILLISECONDS)
+            ?: ByteBuffer.allocateDirect(IO_BUFFER_SIZE)
+        buffer.clear()
+        current = buffer
+        return buffer
+    }
+
+    private fun submit(buffer: ByteBuffer) {
+        buffer.flip()
+        ioExecutor.execute {
+            try {
+                if (failure == null) {
+                    val fileChannel = openChannel()
+                    while (buffer.hasRemaining()) {
+                        writePosition += fileChannel.write(buffer, writePosition)
+                    }
+                }
+            } catch (e: Throwable) {
+                failure = e
+            } finally {
+                bufferPool.offer(buffer)
+            }
+        }
+    }
+
+    private fun openChannel(): FileChannel {
+        return channel ?: RandomAccessFile(file, "rw").channel.also { channel = it }
+    }
+
+    private fun closeChannel() {
+        try {
+            channel?.close()
+        } catch (ignored: Exception) {
+        }
+        channel = null
+    }
+}
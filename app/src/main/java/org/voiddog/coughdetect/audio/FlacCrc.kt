@@ -0,0 +1,57 @@
+package org.voiddog.coughdetect.audio
+
+import java.nio.ByteBuffer
+
+/**
+ * FLAC 帧头使用的 CRC-8（多项式 0x07）和帧尾使用的 CRC-16（多项式 0x8005）
+ */
+internal object FlacCrc {
+
+    private val CRC8_TABLE = IntArray(256) { index ->
+        var crc = index
+        repeat(8) {
+            crc = if (crc and 0x80 != 0) (crc shl 1) xor 0x07 else crc shl 1
+        }
+        crc and 0xFF
+    }
+
+    private val CRC16_TABLE = IntArray(256) { index ->
+        var crc = index shl 8
+        repeat(8) {
+            crc = if (crc and 0x8000 != 0) (crc shl 1) xor 0x8005 else crc shl 1
+        }
+        crc and 0xFFFF
+    }
+
+    fun crc8(bytes: ByteArray, offset: Int, length: Int): Int {
+        var crc = 0
+        for (i in offset until offset + length) {
+            crc = CRC8_TABLE[crc xor (bytes[i].toInt() and 0xFF)]
+        }
+        return crc
+    }
+
+    fun crc16(bytes: ByteArray, offset: Int, length: Int): Int {
+        var crc = 0
+        for (i in offset until offset + length) {
+            crc = ((crc shl 8) and 0xFFFF) xor CRC16_TABLE[(crc ushr 8) xor (bytes[i].toInt() and 0xFF)]
+        }
+        return crc
+    }
+
+    fun crc8(buffer: ByteBuffer, start: Int, end: Int): Int {
+        var crc = 0
+        for (i in start until end) {
+            crc = CRC8_TABLE[crc xor (buffer.get(i).toInt() and 0xFF)]
+        }
+        return crc
+    }
+
+    fun crc16(buffer: ByteBuffer, start: Int, end: Int): Int {
+        var crc = 0
+        for (i in start until end) {
+            crc = ((crc shl 8) and 0xFFFF) xor CRC16_TABLE[(crc ushr 8) xor (buffer.get(i).toInt() and 0xFF)]
+        }
+        return crc
+    }
+}
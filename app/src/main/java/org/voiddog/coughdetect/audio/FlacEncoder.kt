@@ -0,0 +1,646 @@
+package org.voiddog.coughdetect.audio
+
+import org.voiddog.coughdetect.ml.AudioFeatures
+import java.io.ByteArrayOutputStream
+
+/**
+ * 流式 FLAC 编码器（单声道 16-bit）
+ *
+ * 只使用 FLAC 规范中的一个子集：固定阶多项式预测（FIXED 子帧，0~4 阶）和量化线性预测
+ * （LPC 子帧，1~[maxLpcOrder] 阶，系数 12 位）加分区 Rice 编码，每帧取实际位数最少的一种，
+ * 必要时退化为 CONSTANT / VERBATIM 子帧。输出是标准 FLAC 流，系统 MediaPlayer 可以直接播放。
+ *
+ * 每 [blockSize] 个样本编码为一个独立帧。流头部预留 STREAMINFO 和 SEEKTABLE，
+ * 由于总样本数和帧偏移在编码结束前未知，[finish] 返回最终的元数据字节，
+ * 调用方需要把它覆盖写到流的起始位置。
+ *
+ * @param output 帧数据输出，按顺序调用
+ */
+class FlacEncoder(
+    val sampleRate: Int,
+    val blockSize: Int = DEFAULT_BLOCK_SIZE,
+    private val seekPointCapacity: Int = DEFAULT_SEEK_POINTS,
+    private val maxLpcOrder: Int = DEFAULT_MAX_LPC_ORDER,
+    private val output: (ByteArray, Int, Int) -> Unit
+) {
+
+    companion object {
+        const val DEFAULT_BLOCK_SIZE = 4096
+        const val DEFAULT_SEEK_POINTS = 16
+        const val DEFAULT_MAX_LPC_ORDER = 8
+        const val BITS_PER_SAMPLE = 16
+
+        private const val MAX_FIXED_ORDER = 4
+        // LPC 系数的位数（含符号位）和最大量化移位
+        private const val LPC_PRECISION = 12
+        private const val MAX_LPC_SHIFT = 15
+        private const val MAX_PARTITION_ORDER = 6
+        private const val MAX_RICE_PARAMETER = 14
+        private const val STREAMINFO_LENGTH = 34
+        private const val SEEKPOINT_LENGTH = 18
+        private const val METADATA_TYPE_STREAMINFO = 0
+        private const val METADATA_TYPE_SEEKTABLE = 3
+
+        /**
+         * 一次性把 16-bit 样本编码为完整的 FLAC 字节流
+         */
+        fun encodeToByteArray(
+            samples: ShortArray,
+            sampleRate: Int,
+            blockSize: Int = DEFAULT_BLOCK_SIZE,
+            maxLpcOrder: Int = DEFAULT_MAX_LPC_ORDER
+        ): ByteArray {
+            val stream = ByteArrayOutputStream(samples.size)
+            val encoder = FlacEncoder(sampleRate, blockSize, maxLpcOrder = maxLpcOrder) { bytes, offset, length ->
+                stream.write(bytes, offset, length)
+            }
+            encoder.encode(samples, 0, samples.size)
+            val metadata = encoder.finish()
+            val result = stream.toByteArray()
+            System.arraycopy(metadata, 0, result, 0, metadata.size)
+            return result
+        }
+
+        /**
+         * 一次性把 float 样本（范围 [-1, 1]）编码为完整的 FLAC 字节流
+         */
+        fun encodeToByteArray(samples: FloatArray, sampleRate: Int, blockSize: Int = DEFAULT_BLOCK_SIZE): ByteArray {
+            val pcm = ShortArray(samples.size)
+            AudioFeatures.floatToPcm16(samples, 0, pcm, 0, samples.size)
+            return encodeToByteArray(pcm, sampleRate, blockSize)
+        }
+
+        fun metadataLength(seekPoints: Int): Int {
+            return 4 + 4 + STREAMINFO_LENGTH + if (seekPoints > 0) 4 + SEEKPOINT_LENGTH * seekPoints else 0
+        }
+    }
+
+    init {
+        require(blockSize in 16..65535) { "Unsupported block size: $blockSize" }
+        require(sampleRate in 1..655350) { "Unsupported sample rate: $sampleRate" }
+        require(maxLpcOrder in 0..32) { "Unsupported LPC order: $maxLpcOrder" }
+    }
+
+    private val block = IntArray(blockSize)
+    private var blockFill = 0
+    private var residual = IntArray(blockSize)
+    // LPC 候选阶数的残差，比当前最佳更短时和 residual 交换
+    private var candidate = IntArray(blockSize)
+    private val windowed = DoubleArray(blockSize)
+    private val autocorrelation = DoubleArray(maxLpcOrder + 1)
+    // Levinson-Durbin 递推中的预测系数，下标 1..阶数
+    private val lpc = DoubleArray(maxLpcOrder + 1)
+    private val lpcPrevious = DoubleArray(maxLpcOrder + 1)
+    private val quantized = IntArray(maxLpcOrder)
+    private val bestQuantized = IntArray(maxLpcOrder)
+    // searchLpc 选中的 LPC 子帧参数，lpcOrder 为 0 表示用固定阶预测
+    private var lpcOrder = 0
+    private var lpcShift = 0
+    private var lpcPartitionOrder = 0
+    private val writer = BitWriter(blockSize * 3 + 64)
+    private val partitionSums = LongArray(1 shl MAX_PARTITION_ORDER)
+    private val partitionParams = IntArray(1 shl MAX_PARTITION_ORDER)
+    private val floatScratch = ShortArray(blockSize)
+
+    private val metadataLength = metadataLength(seekPointCapacity)
+    private var frameOffsets = LongArray(64)
+    private var frameCount = 0
+    private var frameBytes = 0L
+    private var totalSamples = 0L
+    private var minFrameSize = Int.MAX_VALUE
+    private var maxFrameSize = 0
+    private var finished = false
+
+    init {
+        // 元数据占位，结束时由调用方用 finish() 的返回值覆盖
+        val placeholder = buildMetadata()
+        output(placeholder, 0, placeholder.size)
+    }
+
+    /**
+     * 编码后的总字节数（含元数据）
+     */
+    val bytesWritten: Long
+        get() = metadataLength + frameBytes
+
+    fun encode(samples: ShortArray, offset: Int = 0, length: Int = samples.size - offset) {
+        check(!finished) { "FlacEncoder already finished" }
+        var position = offset
+        val end = offset + length
+        while (position < end) {
+            val n = minOf(blockSize - blockFill, end - position)
+            for (i in 0 until n) {
+                block[blockFill + i] = samples[position + i].toInt()
+            }
+            blockFill += n
+            position += n
+            if (blockFill == blockSize) {
+                encodeFrame(blockSize)
+            }
+        }
+    }
+
+    fun encode(samples: FloatArray, offset: Int = 0, length: Int = samples.size - offset) {
+        var position = offset
+        val end = offset + length
+        while (position < end) {
+            val n = minOf(floatScratch.size, end - position)
+            AudioFeatures.floatToPcm16(samples, position, floatScratch, 0, n)
+            encode(floatScratch, 0, n)
+            position += n
+        }
+    }
+
+    /**
+     * 编码剩余样本并返回最终的元数据（STREAMINFO + SEEKTABLE），应写到流的偏移 0
+     */
+    fun finish(): ByteArray {
+        if (!finished) {
+            if (blockFill > 0) {
+                encodeFrame(blockFill)
+            }
+            finished = true
+        }
+        return buildMetadata()
+    }
+
+    private fun encodeFrame(size: Int) {
+        writer.reset()
+        writeFrameHeader(size)
+        writeSubframe(size)
+        writer.alignToByte()
+        val crc16 = FlacCrc.crc16(writer.bytes, 0, writer.length)
+        writer.writeBits(crc16, 16)
+
+        if (frameCount == frameOffsets.size) {
+            frameOffsets = frameOffsets.copyOf(frameOffsets.size * 2)
+        }
+        frameOffsets[frameCount] = frameBytes
+        frameCount++
+        frameBytes += writer.length
+        totalSamples += size
+        if (size == blockSize) {
+            minFrameSize = minOf(minFrameSize, writer.length)
+        }
+        maxFrameSize = maxOf(maxFrameSize, writer.length)
+        blockFill = 0
+
+        output(writer.bytes, 0, writer.length)
+    }
+
+    private fun writeFrameHeader(size: Int) {
+        val blockSizeCode = blockSizeCode(size)
+        val sampleRateCode = sampleRateCode(sampleRate)
+
+        writer.writeBits(0xFFF8, 16) // 同步码 + 固定块大小策略
+        writer.writeBits(blockSizeCode, 4)
+        writer.writeBits(sampleRateCode, 4)
+        writer.writeBits(0, 4) // 单声道
+        writer.writeBits(0b100, 3) // 16 bits per sample
+        writer.writeBits(0, 1)
+        writer.writeUtf8(frameCount.toLong())
+
+        when (blockSizeCode) {
+            6 -> writer.writeBits(size - 1, 8)
+            7 -> writer.writeBits(size - 1, 16)
+        }
+        when (sampleRateCode) {
+            12 -> writer.writeBits(sampleRate / 1000, 8)
+            13 -> writer.writeBits(sampleRate, 16)
+            14 -> writer.writeBits(sampleRate / 10, 16)
+        }
+
+        writer.writeBits(FlacCrc.crc8(writer.bytes, 0, writer.length), 8)
+    }
+
+    private fun writeSubframe(size: Int) {
+        val samples = block
+
+        var constant = true
+        for (i in 1 until size) {
+            if (samples[i] != samples[0]) {
+                constant = false
+                break
+            }
+        }
+        if (constant) {
+            writer.writeBits(0, 8) // CONSTANT
+            writer.writeBits(samples[0], BITS_PER_SAMPLE)
+            return
+        }
+
+        val order = chooseFixedOrder(samples, size)
+        computeFixedResidual(samples, size, order)
+        val partitionOrder = choosePartitionOrder(residual, size, order)
+
+        val fixedBits = 8L + order * BITS_PER_SAMPLE + 6 + residualBits(residual, size, order, partitionOrder)
+        val bestBits = searchLpc(samples, size, fixedBits)
+        val verbatimBits = 8L + size.toLong() * BITS_PER_SAMPLE
+        if (bestBits >= verbatimBits) {
+            writer.writeBits(0b00000010, 8) // VERBATIM
+            for (i in 0 until size) {
+                writer.writeBits(samples[i], BITS_PER_SAMPLE)
+            }
+            return
+        }
+
+        if (lpcOrder > 0) {
+            writer.writeBits(0b01000000 or ((lpcOrder - 1) shl 1), 8) // LPC, 阶数减一在第 1~5 位
+            for (i in 0 until lpcOrder) {
+                writer.writeBits(samples[i], BITS_PER_SAMPLE)
+            }
+            writer.writeBits(LPC_PRECISION - 1, 4)
+            writer.writeBits(lpcShift, 5)
+            for (j in 0 until lpcOrder) {
+                writer.writeBits(bestQuantized[j], LPC_PRECISION)
+            }
+            writeResidual(residual, size, lpcOrder, lpcPartitionOrder)
+            return
+        }
+
+        writer.writeBits(0b00010000 or (order shl 1), 8) // FIXED, 阶数在低 3 位
+        for (i in 0 until order) {
+            writer.writeBits(samples[i], BITS_PER_SAMPLE)
+        }
+        writeResidual(residual, size, order, partitionOrder)
+    }
+
+    /**
+     * 逐阶试探量化 LPC：加窗自相关经 Levinson-Durbin 递推出 1~[maxLpcOrder] 阶的预测系数，
+     * 每一阶量化后按实际残差计算编码位数。比 [bestBits]（固定阶预测）更短的一阶把残差换入
+     * [residual] 并记下 [lpcOrder]；返回最终的最少位数。
+     */
+    private fun searchLpc(s: IntArray, size: Int, bestBits: Long): Long {
+        lpcOrder = 0
+        val maxOrder = minOf(maxLpcOrder, size - 1)
+        if (maxOrder <= 0) return bestBits
+
+        // Welch 窗，减小块边缘截断对自相关的影响
+        val half = (size - 1) / 2.0
+        for (i in 0 until size) {
+            val x = (i - half) / half
+            windowed[i] = s[i] * (1.0 - x * x)
+        }
+        for (lag in 0..maxOrder) {
+            var sum = 0.0
+            for (i in lag until size) {
+                sum += windowed[i] * windowed[i - lag]
+            }
+            autocorrelation[lag] = sum
+        }
+        if (autocorrelation[0] <= 0.0) return bestBits
+
+        var best = bestBits
+        var error = autocorrelation[0]
+        for (order in 1..maxOrder) {
+            // 递推一阶：lpc[1..order] 满足 s[i] ≈ Σ lpc[j]·s[i - j]
+            var acc = autocorrelation[order]
+            for (j in 1 until order) {
+                acc -= lpc[j] * autocorrelation[order - j]
+            }
+            val k = acc / error
+            for (j in 1 until order) {
+                lpcPrevious[j] = lpc[j]
+            }
+            for (j in 1 until order) {
+                lpc[j] = lpcPrevious[j] - k * lpcPrevious[order - j]
+            }
+            lpc[order] = k
+            error *= 1.0 - k * k
+
+            val shift = quantizeLpc(order)
+            if (shift >= 0) {
+                computeLpcResidual(s, size, order, shift)
+                val partitionOrder = choosePartitionOrder(candidate, size, order)
+                val bits = 8L + order * BITS_PER_SAMPLE + 4 + 5 + order * LPC_PRECISION + 6 +
+                        residualBits(candidate, size, order, partitionOrder)
+                if (bits < best) {
+                    best = bits
+                    lpcOrder = order
+                    lpcShift = shift
+                    lpcPartitionOrder = partitionOrder
+                    System.arraycopy(quantized, 0, bestQuantized, 0, order)
+                    val swap = residual
+                    residual = candidate
+                    candidate = swap
+                }
+            }
+            // 预测误差已经为零（或数值上不再可靠），更高阶没有意义
+            if (error <= 0.0) break
+        }
+        return best
+    }
+
+    /**
+     * 把 lpc[1..order] 量化为 [LPC_PRECISION] 位整数写入 [quantized]，返回移位；系数无法表示时返回 -1
+     */
+    private fun quantizeLpc(order: Int): Int {
+        var max = 0.0
+        for (j in 1..order) {
+            max = maxOf(max, kotlin.math.abs(lpc[j]))
+        }
+        if (!(max > 0.0)) return -1
+        // 最大的系数占满除符号位以外的全部位
+        val shift = minOf(LPC_PRECISION - 2 - Math.getExponent(max), MAX_LPC_SHIFT)
+        if (shift < 0) return -1
+
+        val qMax = (1 shl (LPC_PRECISION - 1)) - 1
+        val qMin = -(1 shl (LPC_PRECISION - 1))
+        var error = 0.0
+        for (j in 1..order) {
+            // 误差反馈：前面系数的舍入误差计入后面的系数
+            error += lpc[j] * (1 shl shift)
+            val q = Math.round(error).toInt().coerceIn(qMin, qMax)
+            error -= q
+            quantized[j - 1] = q
+        }
+        return shift
+    }
+
+    // 与解码端一致：Σ qlp[j]·s[i - 1 - j] 按 64 位累加后算术右移
+    private fun computeLpcResidual(s: IntArray, size: Int, order: Int, shift: Int) {
+        for (i in order until size) {
+            var sum = 0L
+            for (j in 0 until order) {
+                sum += quantized[j].toLong() * s[i - 1 - j]
+            }
+            candidate[i] = s[i] - (sum shr shift).toInt()
+        }
+    }
+
+    // FLAC 参考实现的做法：比较各阶残差绝对值之和，取最小者
+    private fun chooseFixedOrder(s: IntArray, size: Int): Int {
+        if (size <= MAX_FIXED_ORDER) return 0
+        var e0 = 0L
+        var e1 = 0L
+        var e2 = 0L
+        var e3 = 0L
+        var e4 = 0L
+        for (i in MAX_FIXED_ORDER until size) {
+            val r0 = s[i]
+            val r1 = r0 - s[i - 1]
+            val r2 = r1 - (s[i - 1] - s[i - 2])
+            val r3 = r2 - (s[i - 1] - 2 * s[i - 2] + s[i - 3])
+            val r4 = r3 - (s[i - 1] - 3 * s[i - 2] + 3 * s[i - 3] - s[i - 4])
+            e0 += kotlin.math.abs(r0)
+            e1 += kotlin.math.abs(r1)
+            e2 += kotlin.math.abs(r2)
+            e3 += kotlin.math.abs(r3)
+            e4 += kotlin.math.abs(r4)
+        }
+        var order = 0
+        var best = e0
+        if (e1 < best) { best = e1; order = 1 }
+        if (e2 < best) { best = e2; order = 2 }
+        if (e3 < best) { best = e3; order = 3 }
+        if (e4 < best) { order = 4 }
+        return order
+    }
+
+    private fun computeFixedResidual(s: IntArray, size: Int, order: Int) {
+        when (order) {
+            0 -> for (i in 0 until size) residual[i] = s[i]
+            1 -> for (i in 1 until size) residual[i] = s[i] - s[i - 1]
+            2 -> for (i in 2 until size) residual[i] = s[i] - 2 * s[i - 1] + s[i - 2]
+            3 -> for (i in 3 until size) residual[i] = s[i] - 3 * s[i - 1] + 3 * s[i - 2] - s[i - 3]
+            4 -> for (i in 4 until size) residual[i] = s[i] - 4 * s[i - 1] + 6 * s[i - 2] - 4 * s[i - 3] + s[i - 4]
+        }
+    }
+
+    private fun choosePartitionOrder(residual: IntArray, size: Int, order: Int): Int {
+        var bestOrder = 0
+        var bestBits = Long.MAX_VALUE
+        for (partitionOrder in 0..MAX_PARTITION_ORDER) {
+            val partitions = 1 shl partitionOrder
+            if (size % partitions != 0 || size / partitions <= order) break
+            val bits = residualBits(residual, size, order, partitionOrder)
+            if (bits < bestBits) {
+                bestBits = bits
+                bestOrder = partitionOrder
+            }
+        }
+        return bestOrder
+    }
+
+    /**
+     * 估算给定分区阶数下的残差编码位数，同时把每个分区的最佳 Rice 参数写入 [partitionParams]
+     */
+    private fun residualBits(residual: IntArray, size: Int, order: Int, partitionOrder: Int): Long {
+        val partitions = 1 shl partitionOrder
+        val partitionSize = size shr partitionOrder
+        var index = order
+        for (p in 0 until partitions) {
+            val end = (p + 1) * partitionSize
+            var sum = 0L
+            while (index < end) {
+                val r = residual[index]
+                sum += ((r shl 1) xor (r shr 31)).toLong() and 0xFFFFFFFFL
+                index++
+            }
+            partitionSums[p] = sum
+        }
+
+        var total = 0L
+        for (p in 0 until partitions) {
+            val count = if (p == 0) partitionSize - order else partitionSize
+            var bestParam = 0
+            var bestBits = Long.MAX_VALUE
+            for (k in 0..MAX_RICE_PARAMETER) {
+                val bits = count.toLong() * (k + 1) + (partitionSums[p] shr k)
+                if (bits < bestBits) {
+                    bestBits = bits
+                    bestParam = k
+                }
+            }
+            partitionParams[p] = bestParam
+            total += 4 + bestBits
+        }
+        return total
+    }
+
+    private fun writeResidual(residual: IntArray, size: Int, order: Int, partitionOrder: Int) {
+        // 按所选分区阶数重新算一遍各分区的 Rice 参数，之后可能试探过别的阶数
+        residualBits(residual, size, order, partitionOrder)
+        writer.writeBits(0, 2) // Rice 编码，4-bit 参数
+        writer.writeBits(partitionOrder, 4)
+        val partitions = 1 shl partitionOrder
+        val partitionSize = size shr partitionOrder
+        var index = order
+        for (p in 0 until partitions) {
+            val k = partitionParams[p]
+            writer.writeBits(k, 4)
+            val end = (p + 1) * partitionSize
+            while (index < end) {
+                val r = residual[index]
+                writer.writeRice((r shl 1) xor (r shr 31), k)
+                index++
+            }
+        }
+    }
+
+    private fun buildMetadata(): ByteArray {
+        val meta = BitWriter(metadataLength)
+        meta.writeBits(0x664C6143, 32) // "fLaC"
+
+        meta.writeBits(if (seekPointCapacity > 0) 0 else 1, 1) // last-metadata-block 标志
+        meta.writeBits(METADATA_TYPE_STREAMINFO, 7)
+        meta.writeBits(STREAMINFO_LENGTH, 24)
+        meta.writeBits(blockSize, 16)
+        meta.writeBits(blockSize, 16)
+        meta.writeBits(if (minFrameSize == Int.MAX_VALUE) 0 else minFrameSize, 24)
+        meta.writeBits(maxFrameSize, 24)
+        meta.writeBits(sampleRate, 20)
+        meta.writeBits(0, 3) // channels - 1
+        meta.writeBits(BITS_PER_SAMPLE - 1, 5)
+        meta.writeBits((totalSamples ushr 32).toInt(), 4)
+        meta.writeBits(totalSamples.toInt(), 32)
+        // 未计算 MD5，规范允许全零表示未知
+        for (i in 0 until 4) {
+            meta.writeBits(0, 32)
+        }
+
+        if (seekPointCapacity > 0) {
+            meta.writeBits(1, 1)
+            meta.writeBits(METADATA_TYPE_SEEKTABLE, 7)
+            meta.writeBits(SEEKPOINT_LENGTH * seekPointCapacity, 24)
+            val stride = if (frameCount <= seekPointCapacity) 1 else (frameCount + seekPointCapacity - 1) / seekPointCapacity
+            var written = 0
+            var frame = 0
+            while (frame < frameCount && written < seekPointCapacity) {
+                val sample = frame.toLong() * blockSize
+                meta.writeBits((sample ushr 32).toInt(), 32)
+                meta.writeBits(sample.toInt(), 32)
+                meta.writeBits((frameOffsets[frame] ushr 32).toInt(), 32)
+                meta.writeBits(frameOffsets[frame].toInt(), 32)
+                meta.writeBits(minOf(blockSize.toLong(), totalSamples - sample).toInt(), 16)
+                written++
+                frame += stride
+            }
+            // 未使用的位置填占位点
+            while (written < seekPointCapacity) {
+                meta.writeBits(-1, 32)
+                meta.writeBits(-1, 32)
+                meta.writeBits(0, 32)
+                meta.writeBits(0, 32)
+                meta.writeBits(0, 16)
+                written++
+            }
+        }
+        return meta.bytes.copyOf(meta.length)
+    }
+
+    private fun blockSizeCode(size: Int): Int {
+        return when (size) {
+            192 -> 1
+            576 -> 2
+            1152 -> 3
+            2304 -> 4
+            4608 -> 5
+            256 -> 8
+            512 -> 9
+            1024 -> 10
+            2048 -> 11
+            4096 -> 12
+            8192 -> 13
+            16384 -> 14
+            32768 -> 15
+            else -> if (size <= 256) 6 else 7
+        }
+    }
+
+    private fun sampleRateCode(rate: Int): Int {
+        return when (rate) {
+            88200 -> 1
+            176400 -> 2
+            192000 -> 3
+            8000 -> 4
+            16000 -> 5
+            22050 -> 6
+            24000 -> 7
+            32000 -> 8
+            44100 -> 9
+            48000 -> 10
+            96000 -> 11
+            else -> when {
+                rate % 1000 == 0 && rate / 1000 <= 255 -> 12
+                rate <= 65535 -> 13
+                rate % 10 == 0 && rate / 10 <= 65535 -> 14
+                else -> 0
+            }
+        }
+    }
+
+    /**
+     * 大端位写入器，帧数据在一块复用的字节数组中拼装
+     */
+    private class BitWriter(capacity: Int) {
+        var bytes = ByteArray(capacity)
+            private set
+        var length = 0
+            private set
+        private var accumulator = 0L
+        private var pendingBits = 0
+
+        fun reset() {
+            length = 0
+            accumulator = 0L
+            pendingBits = 0
+        }
+
+        fun writeBits(value: Int, bits: Int) {
+            if (bits == 0) return
+            accumulator = (accumulator shl bits) or (value.toLong() and ((1L shl bits) - 1))
+            pendingBits += bits
+            while (pendingBits >= 8) {
+                pendingBits -= 8
+                putByte((accumulator ushr pendingBits).toInt())
+            }
+        }
+
+        fun writeRice(folded: Int, k: Int) {
+            var quotient = folded ushr k
+            while (quotient >= 31) {
+                writeBits(0, 31)
+                quotient -= 31
+            }
+            writeBits(1, quotient + 1) // quotient 个 0 后跟一个 1
+            writeBits(folded, k)
+        }
+
+        fun writeUtf8(value: Long) {
+            when {
+                value < 0x80 -> writeBits(value.toInt(), 8)
+                value < 0x800 -> {
+                    writeBits(0xC0 or (value ushr 6).toInt(), 8)
+                    writeBits(0x80 or (value and 0x3F).toInt(), 8)
+                }
+                else -> {
+                    val extra = when {
+                        value < 0x10000 -> 2
+                        value < 0x200000 -> 3
+                        value < 0x4000000 -> 4
+                        else -> 5
+                    }
+                    val lead = (0xFF00 ushr (extra + 1)) and 0xFF
+                    writeBits(lead or (value ushr (6 * extra)).toInt(), 8)
+                    for (i in extra - 1 downTo 0) {
+                        writeBits(0x80 or ((value ushr (6 * i)) and 0x3F).toInt(), 8)
+                    }
+                }
+            }
+        }
+
+        fun alignToByte() {
+            if (pendingBits > 0) {
+                writeBits(0, 8 - pendingBits)
+            }
+        }
+
+        private fun putByte(value: Int) {
+            if (length == bytes.size) {
+                bytes = bytes.copyOf(bytes.size * 2)
+            }
+            bytes[length++] = value.toByte()
+        }
+    }
+}
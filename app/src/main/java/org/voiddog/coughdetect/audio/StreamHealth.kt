@@ -0,0 +1,214 @@
+package org.voiddog.coughdetect.audio
+
+import java.util.concurrent.atomic.AtomicLongArray
+import kotlin.math.abs
+
+/**
+ * 采集流的健康统计
+ *
+ * 记录读取的帧数与按时间推算应到的帧数、疑似溢出（xrun）次数、读取间隔抖动和
+ * 每次读取后处理耗时的直方图、断开重连的次数和中断时长，以及由 AudioRecord 时间戳推算的输入延迟。
+ * 用来把漏检的咳嗽和特定机型上的采集异常对应起来。
+ *
+ * 只有录音线程写入（单写者），计数器都是 volatile 字段或原子数组，任意线程无锁读取；
+ * [snapshot] 各字段之间不保证严格一致，统计用途足够。
+ */
+class StreamHealth {
+
+    /**
+     * 固定桶的直方图，桶上界单位为微秒，最后一个桶收纳超过全部上界的值
+     */
+    class Histogram(val bucketUpperBoundsUs: LongArray) {
+
+        private val counts = AtomicLongArray(bucketUpperBoundsUs.size + 1)
+
+        fun record(valueUs: Long) {
+            var bucket = 0
+            while (bucket < bucketUpperBoundsUs.size && valueUs > bucketUpperBoundsUs[bucket]) {
+                bucket++
+            }
+            counts.incrementAndGet(bucket)
+        }
+
+        fun counts(): LongArray = LongArray(counts.length()) { counts.get(it) }
+
+        fun clear() {
+            for (i in 0 until counts.length()) {
+                counts.set(i, 0L)
+            }
+        }
+    }
+
+    data class Snapshot(
+        val sampleRate: Int,
+        val framesRead: Long,
+        val framesExpected: Long,
+        val reads: Long,
+        val shortReads: Long,
+        val xrunCount: Long,
+        val inputLatencyUs: Long,
+        val restarts: Long,
+        val gapNanos: Long,
+        val bucketUpperBoundsUs: LongArray,
+        val intervalJitterHistogram: LongArray,
+        val processingTimeHistogram: LongArray
+    ) {
+        override fun equals(other: Any?): Boolean {
+            if (this === other) return true
+            if (other !is Snapshot) return false
+            return sampleRate == other.sampleRate &&
+                framesRead == other.framesRead &&
+                framesExpected == other.framesExpected &&
+                reads == other.reads &&
+                shortReads == other.shortReads &&
+                xrunCount == other.xrunCount &&
+                inputLatencyUs == other.inputLatencyUs &&
+                restarts == other.restarts &&
+                gapNanos == other.gapNanos &&
+                bucketUpperBoundsUs.contentEquals(other.bucketUpperBoundsUs) &&
+                intervalJitterHistogram.contentEquals(other.intervalJitterHistogram) &&
+                processingTimeHistogram.contentEquals(other.processingTimeHistogram)
+        }
+
+        override fun hashCode(): Int {
+            var result = framesRead.hashCode()
+            result = 31 * result + framesExpected.hashCode()
+            result = 31 * result + xrunCount.hashCode()
+            result = 31 * result + intervalJitterHistogram.contentHashCode()
+            result = 31 * result + processingTimeHistogram.contentHashCode()
+            return result
+        }
+    }
+
+    companion object {
+        // 0.1ms ~ 100ms，覆盖从正常抖动到明显卡顿
+        val BUCKET_UPPER_BOUNDS_US = longArrayOf(100, 250, 500, 1_000, 2_500, 5_000, 10_000, 25_000, 50_000, 100_000)
+
+        const val UNKNOWN_LATENCY = -1L
+    }
+
+    private val intervalJitter = Histogram(BUCKET_UPPER_BOUNDS_US)
+    private val processingTime = Histogram(BUCKET_UPPER_BOUNDS_US)
+
+    @Volatile private var sampleRate = 0
+    @Volatile private var bufferFrames = 0
+    @Volatile private var framesRead = 0L
+    @Volatile private var framesExpected = 0L
+    @Volatile private var reads = 0L
+    @Volatile private var shortReads = 0L
+    @Volatile private var xrunCount = 0L
+    @Volatile private var inputLatencyUs = UNKNOWN_LATENCY
+    @Volatile private var restarts = 0L
+    @Volatile private var gapNanos = 0L
+
+    // 上一次读取返回的时刻；0 表示刚开始或刚从暂停恢复，不计算间隔
+    private var lastReadNanos = 0L
+    // 按到达速率估算的、底层缓冲区中尚未读取的帧数
+    private var backlogFrames = 0L
+
+    /**
+     * 开始录音时调用，[bufferFrames] 是 AudioRecord 缓冲区能容纳的帧数
+     */
+    fun start(sampleRate: Int, bufferFrames: Int) {
+        this.sampleRate = sampleRate
+        this.bufferFrames = bufferFrames
+        framesRead = 0L
+        framesExpected = 0L
+        reads = 0L
+        shortReads = 0L
+        xrunCount = 0L
+        inputLatencyUs = UNKNOWN_LATENCY
+        restarts = 0L
+        gapNanos = 0L
+        intervalJitter.clear()
+        processingTime.clear()
+        lastReadNanos = 0L
+        backlogFrames = 0L
+    }
+
+    /**
+     * 暂停期间不读取，恢复后的第一次间隔不计入统计
+     */
+    fun markDiscontinuity() {
+        lastReadNanos = 0L
+        backlogFrames = 0L
+    }
+
+    /**
+     * 一次读取返回了 [frames] 帧（请求 [requested] 帧），[nowNanos] 是返回时刻
+     */
+    fun recordRead(frames: Int, requested: Int, nowNanos: Long) {
+        val rate = sampleRate
+        reads++
+        framesRead += frames
+        if (frames < requested) {
+            shortReads++
+        }
+
+        if (lastReadNanos != 0L && rate > 0) {
+            val intervalNanos = nowNanos - lastReadNanos
+            val arrived = intervalNanos * rate / 1_000_000_000L
+            framesExpected += arrived
+            // 阻塞读取的理想间隔是这次读到的帧数对应的时长
+            val idealNanos = frames * 1_000_000_000L / rate
+            intervalJitter.record(abs(intervalNanos - idealNanos) / 1000)
+            // 到达的帧比读走的多，积压超过缓冲区容量时底层必然丢过数据
+            backlogFrames = maxOf(0L, backlogFrames + arrived - frames)
+            if (bufferFrames > 0 && backlogFrames > bufferFrames) {
+                xrunCount++
+                backlogFrames = bufferFrames.toLong()
+            }
+        } else {
+            framesExpected += frames
+        }
+        lastReadNanos = nowNanos
+    }
+
+    /**
+     * 读取之后的处理（转换、重采样、回调）耗时
+     */
+    fun recordProcessingTime(nanos: Long) {
+        processingTime.record(nanos / 1000)
+    }
+
+    /**
+     * 由 AudioRecord 时间戳推算：第 [framePosition] 帧在 [frameTimeNanos] 被采集，
+     * 已读到第 [framesReadTotal] 帧，此刻为 [nowNanos]
+     */
+    fun updateInputLatency(framePosition: Long, frameTimeNanos: Long, framesReadTotal: Long, nowNanos: Long) {
+        val rate = sampleRate
+        if (rate <= 0) return
+        val newestFrameTime = frameTimeNanos + (framesReadTotal - framePosition) * 1_000_000_000L / rate
+        inputLatencyUs = maxOf(0L, nowNanos - newestFrameTime) / 1000
+    }
+
+    /**
+     * 流断开后重新打开，中断了 [nanos]；之后的第一次读取不计算间隔
+     */
+    fun recordRestart(nanos: Long) {
+        restarts++
+        gapNanos += nanos
+        markDiscontinuity()
+    }
+
+    fun getFramesRead(): Long = framesRead
+
+    fun getXrunCount(): Long = xrunCount
+
+    fun getInputLatencyUs(): Long = inputLatencyUs
+
+    fun snapshot(): Snapshot = Snapshot(
+        sampleRate = sampleRate,
+        framesRead = framesRead,
+        framesExpected = framesExpected,
+        reads = reads,
+        shortReads = shortReads,
+        xrunCount = xrunCount,
+        inputLatencyUs = inputLatencyUs,
+        restarts = restarts,
+        gapNanos = gapNanos,
+        bucketUpperBoundsUs = BUCKET_UPPER_BOUNDS_US.copyOf(),
+        intervalJitterHistogram = intervalJitter.counts(),
+        processingTimeHistogram = processingTime.counts()
+    )
+}
@@ -53,4 +53,7 @@ interface CoughRecordDao {
 
     @Query("UPDATE cough_records SET audioFilePath = '' WHERE audioFilePath IN (:filePaths)")
     suspend fun clearAudioFilePaths(filePaths: List<String>): Int
+
+    @Query("UPDATE cough_records SET audioFilePath = '' WHERE substr(audioFilePath, 1, length(:prefix)) = :prefix")
+    suspend fun clearAudioFilePathsWithPrefix(prefix: String): Int
 }
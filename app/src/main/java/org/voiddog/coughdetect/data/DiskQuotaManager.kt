@@ -0,0 +1,305 @@
+package org.voiddog.coughdetect.data
+
+import android.content.Context
+import android.util.Log
+import org.voiddog.coughdetect.utils.Constants
+import org.voiddog.coughdetect.utils.isAudioFile
+import java.io.BufferedInputStream
+import java.io.BufferedOutputStream
+import java.io.DataInputStream
+import java.io.DataOutputStream
+import java.io.EOFException
+import java.io.File
+import java.io.FileInputStream
+import java.io.FileOutputStream
+import java.io.IOException
+
+/**
+ * 音频存储配额管理器
+ *
+ * 在内存中维护所有已存储音频（事件日志段，以及旧版本按事件保存的音频文件）的大小和
+ * 访问顺序索引：按访问顺序排列的 LinkedHashMap 头部就是最久未使用的条目，总大小随增删
+ * 增量更新，所以每次保存时的淘汰只是从头部弹出条目，与历史记录的数量无关。
+ *
+ * 索引的每次变更以追加方式记入紧凑的清单文件，启动时重放一次即可重建，不需要扫描目录；
+ * 清单里的冗余操作积累过多时整体重写压缩。
+ */
+class DiskQuotaManager(private val manifestFile: File) {
+
+    companion object {
+        private const val TAG = "DiskQuotaManager"
+
+        private const val MANIFEST_MAGIC = 0x51554F54 // "QUOT"
+        private const val MANIFEST_VERSION = 1
+        private const val OP_PUT: Byte = 1
+        private const val OP_REMOVE: Byte = 2
+        private const val COMPACT_SLACK = 256
+
+        @Volatile
+        private var INSTANCE: DiskQuotaManager? = null
+
+        fun getInstance(context: Context): DiskQuotaManager {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: create(context.applicationContext).also { INSTANCE = it }
+            }
+        }
+
+        private fun create(context: Context): DiskQuotaManager {
+            val manager = DiskQuotaManager(File(context.filesDir, Constants.Storage.QUOTA_MANIFEST_FILE))
+            if (!manager.loadedFromManifest) {
+                // 首次启动或清单丢失：唯一一次扫描旧版本的单事件音频目录
+                val legacyFiles = File(context.filesDir, Constants.Storage.LEGACY_AUDIO_DIRECTORY)
+                    .listFiles { file -> file.isAudioFile() }
+                legacyFiles?.sortedBy { it.lastModified() }?.forEach { file ->
+                    manager.put(file.absolutePath, file.length(), file.lastModified())
+                }
+                Log.i(TAG, "清单不存在，已从旧音频目录重建: ${legacyFiles?.size ?: 0}个文件")
+            }
+            // 事件日志的段列表本来就在内存中，对账的开销只和段数有关
+            val eventLog = EventLog.getInstance(context)
+            manager.sync(eventLog.directory, eventLog.segmentSizes())
+            return manager
+        }
+    }
+
+    private class Entry(var size: Long, var lastAccess: Long)
+
+    // accessOrder = true：迭代顺序从最久未使用到最近使用
+    private val entries = LinkedHashMap<String, Entry>(64, 0.75f, true)
+    private var journal: DataOutputStream? = null
+    private var journalOps = 0
+
+    /**
+     * 所有条目的总字节数
+     */
+    var totalBytes = 0L
+        private set
+
+    /**
+     * 是否从已有的清单重建了索引
+     */
+    var loadedFromManifest = false
+        private set
+
+    val size: Int
+        @Synchronized get() = entries.size
+
+    init {
+        load()
+    }
+
+    /**
+     * 添加条目或更新已有条目的大小，同时把它标记为最近使用
+     */
+    @Synchronized
+    fun put(path: String, size: Long, lastAccess: Long = System.currentTimeMillis()) {
+        val entry = entries[path]
+        if (entry == null) {
+            entries[path] = Entry(size, lastAccess)
+            totalBytes += size
+        } else {
+            totalBytes += size - entry.size
+            entry.size = size
+            entry.lastAccess = lastAccess
+        }
+        appendPut(path, size, lastAccess)
+    }
+
+    /**
+     * 标记条目为最近使用（例如回放时）
+     */
+    @Synchronized
+    fun touch(path: String) {
+        val entry = entries[path] ?: return
+        entry.lastAccess = System.currentTimeMillis()
+        appendPut(path, entry.size, entry.lastAccess)
+    }
+
+    @Synchronized
+    fun remove(path: String): Boolean {
+        val entry = entries.remove(path) ?: return false
+        totalBytes -= entry.size
+        appendRemove(path)
+        return true
+    }
+
+    @Synchronized
+    fun contains(path: String): Boolean = entries.containsKey(path)
+
+    /**
+     * 从最久未使用的条目开始移出索引，直到总大小不超过 [maxBytes]，
+     * 返回被移出的路径，由调用方删除对应的文件或日志段
+     */
+    @Synchronized
+    fun evict(maxBytes: Long): List<String> {
+        val evicted = ArrayList<String>()
+        val iterator = entries.entries.iterator()
+        while (totalBytes > maxBytes && iterator.hasNext()) {
+            val (path, entry) = iterator.next()
+            iterator.remove()
+            totalBytes -= entry.size
+            appendRemove(path)
+            evicted.add(path)
+        }
+        return evicted
+    }
+
+    /**
+     * 用 [current] 对账 [directory] 下的条目：补上缺失的，移除已不存在的
+     */
+    @Synchronized
+    fun sync(directory: File, current: Map<String, Long>) {
+        val prefix = directory.absolutePath + File.separator
+        val stale = entries.keys.filter { it.startsWith(prefix) && !current.containsKey(it) }
+        for (path in stale) {
+            remove(path)
+        }
+        for ((path, size) in current) {
+            val entry = entries[path]
+            if (entry == null || entry.size != size) {
+                put(path, size, entry?.lastAccess ?: System.currentTimeMillis())
+            }
+        }
+    }
+
+    @Synchronized
+    fun clear() {
+        entries.clear()
+        totalBytes = 0L
+        compact()
+    }
+
+    @Synchronized
+    fun close() {
+        closeJournal()
+    }
+
+    private fun appendPut(path: String, size: Long, lastAccess: Long) {
+        appendOp {
+            writeByte(OP_PUT.toInt())
+            writeUTF(path)
+            writeLong(size)
+            writeLong(lastAccess)
+        }
+    }
+
+    private fun appendRemove(path: String) {
+        appendOp {
+            writeByte(OP_REMOVE.toInt())
+            writeUTF(path)
+        }
+    }
+
+    private inline fun appendOp(write: DataOutputStream.() -> Unit) {
+        try {
+            val output = journal ?: openJournal()
+            output.write()
+            output.flush()
+            journalOps++
+            if (journalOps > entries.size * 2 + COMPACT_SLACK) {
+                compact()
+            }
+        } catch (e: IOException) {
+            // 清单只是索引的持久化副本，写失败不影响内存中的配额计算
+            Log.e(TAG, "写入配额清单失败", e)
+            closeJournal()
+        }
+    }
+
+    private fun openJournal(): DataOutputStream {
+        val output = DataOutputStream(BufferedOutputStream(FileOutputStream(manifestFile, true)))
+        journal = output
+        return output
+    }
+
+    private fun closeJournal() {
+        try {
+            journal?.close()
+        } catch (e: IOException) {
+            Log.w(TAG, "关闭配额清单失败", e)
+        }
+        journal = null
+    }
+
+    /**
+     * 以当前索引重写清单，按最久未使用到最近使用的顺序写出，重放时顺序不变
+     */
+    private fun compact() {
+        closeJournal()
+        val temp = File(manifestFile.path + ".tmp")
+        try {
+            DataOutputStream(BufferedOutputStream(FileOutputStream(temp))).use { output ->
+                output.writeInt(MANIFEST_MAGIC)
+                output.writeInt(MANIFEST_VERSION)
+                for ((path, entry) in entries) {
+                    output.writeByte(OP_PUT.toInt())
+                    output.writeUTF(path)
+                    output.writeLong(entry.size)
+                    output.writeLong(entry.lastAccess)
+                }
+            }
+            if (!temp.renameTo(manifestFile)) {
+                throw IOException("Failed to replace ${manifestFile.path}")
+            }
+            journalOps = 0
+        } catch (e: IOException) {
+            Log.e(TAG, "压缩配额清单失败", e)
+            temp.delete()
+        }
+    }
+
+    private fun load() {
+        if (!manifestFile.exists()) {
+            compact()
+            return
+        }
+        var torn = false
+        try {
+            DataInputStream(BufferedInputStream(FileInputStream(manifestFile))).use { input ->
+                if (input.readInt() != MANIFEST_MAGIC || input.readInt() != MANIFEST_VERSION) {
+                    throw IOException("Unrecognized manifest header")
+                }
+                while (true) {
+                    val op = try {
+                        input.readByte()
+                    } catch (e: EOFException) {
+                        break
+                    }
+                    try {
+                        val path = input.readUTF()
+                        when (op) {
+                            OP_PUT -> {
+                                val size = input.readLong()
+                                val lastAccess = input.readLong()
+                                val entry = entries[path]
+                                if (entry == null) {
+                                    entries[path] = Entry(size, lastAccess)
+                                    totalBytes += size
+                                } else {
+                                    totalBytes += size - entry.size
+                                    entry.size = size
+                                    entry.lastAccess = lastAccess
+                                }
+                            }
+                            OP_REMOVE -> entries.remove(path)?.let { totalBytes -= it.size }
+                            else -> throw IOException("Unknown manifest op $op")
+                        }
+                        journalOps++
+                    } catch (e: EOFException) {
+                        torn = true // 最后一条操作只写了一半
+                        break
+                    }
+                }
+            }
+            loadedFromManifest = true
+        } catch (e: IOException) {
+            Log.e(TAG, "读取配额清单失败，将重建索引", e)
+            entries.clear()
+            totalBytes = 0L
+        }
+        if (torn || !loadedFromManifest) {
+            compact()
+        }
+        Log.d(TAG, "配额索引已加载: ${entries.size}个条目, 总大小: ${totalBytes / 1024}KB")
+    }
+}
@@ -0,0 +1,551 @@
+package org.voiddog.coughdetect.data
+
+import android.content.Context
+import android.util.Log
+import org.voiddog.coughdetect.audio.ClipFileSink
+import org.voiddog.coughdetect.utils.Constants
+import java.io.Closeable
+import java.io.File
+import java.io.IOException
+import java.io.RandomAccessFile
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.channels.FileChannel
+import java.util.Arrays
+import java.util.concurrent.CompletableFuture
+import java.util.concurrent.CompletionException
+import java.util.zip.CRC32
+
+/**
+ * 追加写的分段事件日志
+ *
+ * 每个事件的音频片段（一段完整的 FLAC 流）顺序追加到当前段的数据文件 `NNNNNNNN.seg`，
+ * 事件元数据以定长记录追加到同名的索引文件 `NNNNNNNN.idx`。查询时把索引文件映射到内存，
+ * 在段内按时间戳二分查找；段内时间戳单调不减，乱序到达的事件会开启新段。
+ * 段写满 [segmentSizeLimit] 后封存，超出配额时整段删除最旧的段，不再扫描目录。
+ *
+ * 片段用 [ClipRef] 引用（`段文件路径#偏移+长度`），存入数据库的 audioFilePath 字段，
+ * 播放时以文件描述符加偏移交给 MediaPlayer。
+ *
+ * 追加时调用线程只在段内分配片段的位置，片段和索引记录都由 [ClipFileSink] 的后台 I/O 线程写入，
+ * 按分配的顺序落盘；索引记录写完后事件才能被查询到。
+ */
+class EventLog(
+    val directory: File,
+    private val segmentSizeLimit: Long = Constants.Storage.EVENT_LOG_SEGMENT_SIZE_MB * 1024L * 1024L
+) : Closeable {
+
+    companion object {
+        private const val TAG = "EventLog"
+
+        private const val DATA_SUFFIX = ".seg"
+        private const val INDEX_SUFFIX = ".idx"
+        private const val REF_SEPARATOR = '#'
+
+        // 索引记录布局（小端序）
+        const val RECORD_SIZE = 48
+        private const val TIMESTAMP_OFFSET = 0
+        private const val CLIP_OFFSET_OFFSET = 8
+        private const val CLIP_LENGTH_OFFSET = 16
+        private const val DURATION_OFFSET = 20
+        private const val CONFIDENCE_OFFSET = 24
+        private const val AMPLITUDE_OFFSET = 28
+        private const val EVENT_TYPE_OFFSET = 32
+        private const val CRC_OFFSET = 36 // CRC32 覆盖 [0, 36)
+        private const val FLAGS_OFFSET = 40 // 删除标记不参与 CRC，可以原地改写
+        private const val FLAG_DELETED = 0x01
+
+        @Volatile
+        private var INSTANCE: EventLog? = null
+
+        fun getInstance(context: Context): EventLog {
+            return INSTANCE ?: synchronized(this) {
+                INSTANCE ?: EventLog(
+                    File(context.applicationContext.filesDir, Constants.Storage.EVENT_LOG_DIRECTORY)
+                ).also { INSTANCE = it }
+            }
+        }
+
+        fun isClipRef(path: String): Boolean = ClipRef.parse(path) != null
+
+        /**
+         * 某个段内所有片段引用的公共前缀，段被淘汰时用来批量清理数据库中的引用
+         */
+        fun refPrefix(segmentFile: File): String = "${segmentFile.absolutePath}$REF_SEPARATOR"
+    }
+
+    data class Entry(
+        val timestamp: Long,
+        val durationMs: Int,
+        val confidence: Float,
+        val amplitude: Float,
+        val eventType: Int,
+        val clip: ClipRef,
+        val isDeleted: Boolean
+    )
+
+    /**
+     * 片段在段文件中的位置
+     */
+    data class ClipRef(val file: File, val offset: Long, val length: Int) {
+
+        override fun toString(): String = "${refPrefix(file)}$offset+$length"
+
+        companion object {
+            fun parse(path: String): ClipRef? {
+                val separator = path.lastIndexOf(REF_SEPARATOR)
+                if (separator < 0 || !path.regionMatches(separator - DATA_SUFFIX.length, DATA_SUFFIX, 0, DATA_SUFFIX.length)) {
+                    return null
+                }
+                val plus = path.indexOf('+', separator)
+                if (plus < 0) return null
+                val offset = path.substring(separator + 1, plus).toLongOrNull() ?: return null
+                val length = path.substring(plus + 1).toIntOrNull() ?: return null
+                return ClipRef(File(path.substring(0, separator)), offset, length)
+            }
+        }
+    }
+
+    private class Segment(val id: Long, val dataFile: File, val indexFile: File) {
+        var dataLength = 0L
+        var recordCount = 0
+        // 已分配位置、还在 I/O 线程上写入的记录
+        var pendingRecords = 0
+        var firstTimestamp = Long.MAX_VALUE
+        var lastTimestamp = Long.MIN_VALUE
+        var mappedIndex: ByteBuffer? = null
+        var mappedCount = 0
+
+        val sizeBytes: Long
+            get() = dataLength + (recordCount + pendingRecords).toLong() * RECORD_SIZE
+    }
+
+    // 按段号升序，头部是最旧的段，尾部是正在写入的段
+    private val segments = ArrayDeque<Segment>()
+    private val segmentsById = HashMap<Long, Segment>()
+    private var nextSegmentId = 1L
+
+    // 正在追加索引的段；只在 I/O 线程上追加，[markDeleted] 也会改写它的删除标记
+    private var activeId = -1L
+    private var indexChannel: FileChannel? = null
+
+    private val record = ByteBuffer.allocate(RECORD_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+    private val crc = CRC32()
+
+    /**
+     * 所有段的数据和索引总字节数，追加和淘汰时增量维护
+     */
+    var totalBytes = 0L
+        private set
+
+    init {
+        if (!directory.exists()) {
+            directory.mkdirs()
+        }
+        recover()
+    }
+
+    /**
+     * 追加一个事件及其音频片段。立即返回，片段和索引记录在后台 I/O 线程上落盘后
+     * future 以写入的条目完成；写入失败时以异常完成，这个事件不会出现在查询结果里。
+     */
+    fun append(
+        timestamp: Long,
+        durationMs: Int,
+        confidence: Float,
+        amplitude: Float,
+        eventType: Int,
+        clip: ByteArray,
+        offset: Int = 0,
+        length: Int = clip.size - offset
+    ): CompletableFuture<Entry> {
+        synchronized(this) {
+            val last = segments.lastOrNull()
+            val segment = if (last == null ||
+                (last.recordCount + last.pendingRecords > 0 && last.dataLength + length > segmentSizeLimit) ||
+                timestamp < last.lastTimestamp
+            ) {
+                startSegment()
+            } else {
+                last
+            }
+
+            // 先分配位置，I/O 线程按分配的顺序写入，段内片段偏移和时间戳都保持递增
+            val clipOffset = segment.dataLength
+            segment.dataLength += length
+            segment.pendingRecords++
+            if (segment.firstTimestamp == Long.MAX_VALUE) {
+                segment.firstTimestamp = timestamp
+            }
+            segment.lastTimestamp = timestamp
+            totalBytes += length.toLong() + RECORD_SIZE
+
+            val entry = Entry(timestamp, durationMs, confidence, amplitude, eventType,
+                ClipRef(segment.dataFile, clipOffset, length), false)
+            val sink = ClipFileSink(segment.dataFile, clipOffset)
+            try {
+                sink.put(clip, offset, length)
+            } catch (e: Exception) {
+                sink.abort()
+                segment.pendingRecords--
+                totalBytes -= RECORD_SIZE
+                throw e
+            }
+            // 先写片段再写索引：崩溃时最多留下没有索引的尾部数据，重启恢复时截掉。
+            // 在锁内登记回调，保证索引记录按分配的顺序追加
+            return sink.finish().handle { _, error -> commit(segment, entry, error) }
+        }
+    }
+
+    // 片段已经落盘（或失败），在 I/O 线程上追加索引记录
+    @Synchronized
+    private fun commit(segment: Segment, entry: Entry, error: Throwable?): Entry {
+        segment.pendingRecords--
+        if (segmentsById[segment.id] !== segment) {
+            // 写入期间段被淘汰（大小已随段扣除）：片段写入时可能重新创建了数据文件
+            segment.dataFile.delete()
+            throw CompletionException(IOException("event log segment ${segment.dataFile.name} removed while appending"))
+        }
+        if (error != null) {
+            // 片段所在的区域留空，随段一起回收
+            totalBytes -= RECORD_SIZE
+            throw CompletionException(error)
+        }
+
+        openForAppend(segment)
+        record.clear()
+        Arrays.fill(record.array(), 0.toByte())
+        record.putLong(TIMESTAMP_OFFSET, entry.timestamp)
+        record.putLong(CLIP_OFFSET_OFFSET, entry.clip.offset)
+        record.putInt(CLIP_LENGTH_OFFSET, entry.clip.length)
+        record.putInt(DURATION_OFFSET, entry.durationMs)
+        record.putFloat(CONFIDENCE_OFFSET, entry.confidence)
+        record.putFloat(AMPLITUDE_OFFSET, entry.amplitude)
+        record.put(EVENT_TYPE_OFFSET, entry.eventType.toByte())
+        record.putInt(CRC_OFFSET, recordCrc(record, 0))
+        try {
+            writeFully(indexChannel!!, record, segment.recordCount.toLong() * RECORD_SIZE)
+        } catch (e: IOException) {
+            totalBytes -= RECORD_SIZE
+            throw CompletionException(e)
+        }
+        segment.recordCount++
+        return entry
+    }
+
+    /**
+     * 查询 [startTime, endTime] 内未删除的事件，按写入顺序返回
+     */
+    @Synchronized
+    fun query(startTime: Long, endTime: Long): List<Entry> {
+        val result = ArrayList<Entry>()
+        forEachInRange(startTime, endTime) { segment, index, base ->
+            result.add(readEntry(segment, index, base))
+        }
+        return result
+    }
+
+    @Synchronized
+    fun countInRange(startTime: Long, endTime: Long): Int {
+        var count = 0
+        forEachInRange(startTime, endTime) { _, _, _ -> count++ }
+        return count
+    }
+
+    /**
+     * 标记片段已删除。空间在所在段被整体淘汰时回收。
+     */
+    @Synchronized
+    fun markDeleted(ref: ClipRef): Boolean {
+        val segment = segmentFor(ref.file) ?: return false
+        val index = mapIndex(segment)
+        // 段内片段偏移严格递增，按偏移二分定位记录
+        var low = 0
+        var high = segment.recordCount - 1
+        while (low <= high) {
+            val mid = (low + high) ushr 1
+            val clipOffset = index.getLong(mid * RECORD_SIZE + CLIP_OFFSET_OFFSET)
+            when {
+                clipOffset < ref.offset -> low = mid + 1
+                clipOffset > ref.offset -> high = mid - 1
+                else -> {
+                    val flag = ByteBuffer.wrap(byteArrayOf(FLAG_DELETED.toByte()))
+                    val position = mid.toLong() * RECORD_SIZE + FLAGS_OFFSET
+                    if (segment.id == activeId) {
+                        writeFully(indexChannel!!, flag, position)
+                    } else {
+                        RandomAccessFile(segment.indexFile, "rw").use { writeFully(it.channel, flag, position) }
+                    }
+                    return true
+                }
+            }
+        }
+        return false
+    }
+
+    /**
+     * 删除指定的段（由配额管理器按最久未使用选出），返回是否存在该段
+     */
+    @Synchronized
+    fun removeSegment(dataFile: File): Boolean {
+        val segment = segmentFor(dataFile) ?: return false
+        segments.remove(segment)
+        removeSegment(segment)
+        Log.d(TAG, "删除事件日志段: ${segment.dataFile.name}, 事件数: ${segment.recordCount}, 大小: ${segment.sizeBytes / 1024}KB")
+        return true
+    }
+
+    /**
+     * 段的数据加索引字节数，段不存在时返回 -1
+     */
+    @Synchronized
+    fun segmentSize(dataFile: File): Long = segmentFor(dataFile)?.sizeBytes ?: -1L
+
+    /**
+     * 所有段的数据文件路径及其大小
+     */
+    @Synchronized
+    fun segmentSizes(): Map<String, Long> {
+        val sizes = LinkedHashMap<String, Long>(segments.size)
+        for (segment in segments) {
+            sizes[segment.dataFile.absolutePath] = segment.sizeBytes
+        }
+        return sizes
+    }
+
+    /**
+     * 读取片段字节
+     */
+    @Synchronized
+    fun readClip(ref: ClipRef): ByteArray {
+        val bytes = ByteArray(ref.length)
+        RandomAccessFile(ref.file, "r").use { raf ->
+            raf.seek(ref.offset)
+            raf.readFully(bytes)
+        }
+        return bytes
+    }
+
+    @Synchronized
+    fun clear() {
+        while (segments.isNotEmpty()) {
+            removeSegment(segments.removeFirst())
+        }
+        totalBytes = 0L
+    }
+
+    @Synchronized
+    override fun close() {
+        closeChannels()
+    }
+
+    private inline fun forEachInRange(
+        startTime: Long,
+        endTime: Long,
+        action: (Segment, ByteBuffer, Int) -> Unit
+    ) {
+        for (segment in segments) {
+            if (segment.recordCount == 0 || segment.lastTimestamp < startTime || segment.firstTimestamp > endTime) {
+                continue
+            }
+            val index = mapIndex(segment)
+            var i = lowerBound(index, segment.recordCount, startTime)
+            while (i < segment.recordCount) {
+                val base = i * RECORD_SIZE
+                if (index.getLong(base + TIMESTAMP_OFFSET) > endTime) break
+                if (index.get(base + FLAGS_OFFSET).toInt() and FLAG_DELETED == 0) {
+                    action(segment, index, base)
+                }
+                i++
+            }
+        }
+    }
+
+    private fun lowerBound(index: ByteBuffer, count: Int, timestamp: Long): Int {
+        var low = 0
+        var high = count
+        while (low < high) {
+            val mid = (low + high) ushr 1
+            if (index.getLong(mid * RECORD_SIZE + TIMESTAMP_OFFSET) < timestamp) {
+                low = mid + 1
+            } else {
+                high = mid
+            }
+        }
+        return low
+    }
+
+    private fun readEntry(segment: Segment, index: ByteBuffer, base: Int): Entry {
+        return Entry(
+            timestamp = index.getLong(base + TIMESTAMP_OFFSET),
+            durationMs = index.getInt(base + DURATION_OFFSET),
+            confidence = index.getFloat(base + CONFIDENCE_OFFSET),
+            amplitude = index.getFloat(base + AMPLITUDE_OFFSET),
+            eventType = index.get(base + EVENT_TYPE_OFFSET).toInt(),
+            clip = ClipRef(
+                segment.dataFile,
+                index.getLong(base + CLIP_OFFSET_OFFSET),
+                index.getInt(base + CLIP_LENGTH_OFFSET)
+            ),
+            isDeleted = index.get(base + FLAGS_OFFSET).toInt() and FLAG_DELETED != 0
+        )
+    }
+
+    // 已封存段的映射一直复用；正在写入的段在记录数变化后重新映射
+    private fun mapIndex(segment: Segment): ByteBuffer {
+        val mapped = segment.mappedIndex
+        if (mapped != null && segment.mappedCount == segment.recordCount) {
+            return mapped
+        }
+        val length = segment.recordCount.toLong() * RECORD_SIZE
+        val buffer = RandomAccessFile(segment.indexFile, "r").use { raf ->
+            raf.channel.map(FileChannel.MapMode.READ_ONLY, 0, length)
+        }.order(ByteOrder.LITTLE_ENDIAN)
+        segment.mappedIndex = buffer
+        segment.mappedCount = segment.recordCount
+        return buffer
+    }
+
+    private fun segmentFor(file: File): Segment? {
+        if (file.parentFile?.absolutePath != directory.absolutePath) return null
+        val id = file.name.removeSuffix(DATA_SUFFIX).toLongOrNull() ?: return null
+        return segmentsById[id]
+    }
+
+    private fun startSegment(): Segment {
+        val id = nextSegmentId++
+        val segment = Segment(id, File(directory, segmentName(id) + DATA_SUFFIX), File(directory, segmentName(id) + INDEX_SUFFIX))
+        segments.addLast(segment)
+        segmentsById[id] = segment
+        return segment
+    }
+
+    private fun openForAppend(segment: Segment) {
+        if (activeId == segment.id) return
+        closeChannels()
+        indexChannel = RandomAccessFile(segment.indexFile, "rw").channel
+        activeId = segment.id
+    }
+
+    private fun closeChannels() {
+        try {
+            indexChannel?.close()
+        } catch (e: IOException) {
+            Log.w(TAG, "关闭事件日志段失败", e)
+        }
+        indexChannel = null
+        activeId = -1L
+    }
+
+    private fun removeSegment(segment: Segment) {
+        if (segment.id == activeId) {
+            closeChannels()
+        }
+        segmentsById.remove(segment.id)
+        totalBytes -= segment.sizeBytes
+        segment.mappedIndex = null
+        if (!segment.dataFile.delete() && segment.dataFile.exists()) {
+            Log.w(TAG, "删除事件日志段失败: ${segment.dataFile.absolutePath}")
+        }
+        segment.indexFile.delete()
+    }
+
+    /**
+     * 启动时唯一一次列目录：加载已有段，丢弃写了一半的尾部记录和孤立的数据文件
+     */
+    private fun recover() {
+        val files = directory.listFiles() ?: return
+        val indexIds = files
+            .filter { it.name.endsWith(INDEX_SUFFIX) }
+            .mapNotNull { it.name.removeSuffix(INDEX_SUFFIX).toLongOrNull() }
+            .sorted()
+
+        for (id in indexIds) {
+            try {
+                val segment = loadSegment(id) ?: continue
+                segments.addLast(segment)
+                segmentsById[id] = segment
+                totalBytes += segment.sizeBytes
+            } catch (e: IOException) {
+                Log.e(TAG, "加载事件日志段失败: ${segmentName(id)}", e)
+            }
+        }
+        for (file in files) {
+            if (file.name.endsWith(DATA_SUFFIX)) {
+                val id = file.name.removeSuffix(DATA_SUFFIX).toLongOrNull()
+                if (id == null || !segmentsById.containsKey(id)) {
+                    file.delete()
+                }
+            }
+        }
+        nextSegmentId = (indexIds.lastOrNull() ?: 0L) + 1
+        Log.d(TAG, "事件日志已加载: ${segments.size}个段, 总大小: ${totalBytes / 1024}KB")
+    }
+
+    private fun loadSegment(id: Long): Segment? {
+        val segment = Segment(id, File(directory, segmentName(id) + DATA_SUFFIX), File(directory, segmentName(id) + INDEX_SUFFIX))
+        if (!segment.dataFile.exists()) {
+            segment.indexFile.delete()
+            return null
+        }
+        val dataLength = segment.dataFile.length()
+
+        RandomAccessFile(segment.indexFile, "rw").use { raf ->
+            val channel = raf.channel
+            var count = (raf.length() / RECORD_SIZE).toInt()
+            // 从尾部向前丢弃校验失败或指向缺失数据的记录
+            while (count > 0) {
+                readRecord(channel, count - 1)
+                val end = record.getLong(CLIP_OFFSET_OFFSET) + record.getInt(CLIP_LENGTH_OFFSET)
+                if (record.getInt(CRC_OFFSET) == recordCrc(record, 0) && end <= dataLength) break
+                count--
+            }
+            raf.setLength(count.toLong() * RECORD_SIZE)
+            segment.recordCount = count
+            if (count > 0) {
+                segment.dataLength = record.getLong(CLIP_OFFSET_OFFSET) + record.getInt(CLIP_LENGTH_OFFSET)
+                segment.lastTimestamp = record.getLong(TIMESTAMP_OFFSET)
+                readRecord(channel, 0)
+                segment.firstTimestamp = record.getLong(TIMESTAMP_OFFSET)
+            }
+        }
+
+        if (segment.recordCount == 0) {
+            segment.dataFile.delete()
+            segment.indexFile.delete()
+            return null
+        }
+        if (segment.dataLength < dataLength) {
+            RandomAccessFile(segment.dataFile, "rw").use { it.setLength(segment.dataLength) }
+        }
+        return segment
+    }
+
+    private fun readRecord(channel: FileChannel, position: Int) {
+        record.clear()
+        var offset = position.toLong() * RECORD_SIZE
+        while (record.hasRemaining()) {
+            val n = channel.read(record, offset)
+            if (n < 0) throw IOException("Unexpected end of index")
+            offset += n
+        }
+        record.flip()
+    }
+
+    private fun recordCrc(buffer: ByteBuffer, base: Int): Int {
+        crc.reset()
+        val slice = buffer.duplicate()
+        slice.limit(base + CRC_OFFSET).position(base)
+        crc.update(slice)
+        return crc.value.toInt()
+    }
+
+    private fun writeFully(channel: FileChannel, buffer: ByteBuffer, position: Long) {
+        var offset = position
+        while (buffer.hasRemaining()) {
+            offset += channel.write(buffer, offset)
+        }
+    }
+
+    private fun segmentName(id: Long): String = String.format("%08d", id)
+}
@@ -3,6 +3,7 @@ package org.voiddog.coughdetect.data
 import android.content.Context
 import android.content.SharedPreferences
 import androidx.core.content.edit
+import org.voiddog.coughdetect.utils.Constants
 
 class SettingsManager private constructor(context: Context) {
     private val prefs: SharedPreferences = context.getSharedPreferences("cough_detect_settings", Context.MODE_PRIVATE)
@@ -29,6 +30,11 @@ class SettingsManager private constructor(context: Context) {
         get() = prefs.getString(KEY_GAODE_API_KEY, "") ?: ""
         set(value) = prefs.edit { putString(KEY_GAODE_API_KEY, value) }
     
+    // 检测灵敏度 0..1，默认 0.5 对应引擎的默认参数
+    var detectionSensitivity: Float
+        get() = prefs.getFloat(Constants.PreferenceKeys.DETECTION_SENSITIVITY, 0.5f)
+        set(value) = prefs.edit { putFloat(Constants.PreferenceKeys.DETECTION_SENSITIVITY, value.coerceIn(0f, 1f)) }
+    
     fun getSettings(): Settings {
         return Settings(
             maxAudioCacheSizeMB = maxAudioCacheSizeMB,
@@ -0,0 +1,48 @@
+package org.voiddog.coughdetect.engine
+
+/**
+ * 事件音频缓冲区池
+ *
+ * 每个咳嗽事件都要带上检测窗口的音频（16000 个样本，64KB）。缓冲区从池中取出，
+ * 事件的消费者处理完（编码写盘）后通过 CoughDetectEngine.releaseAudioEvent 归还，
+ * 稳态下事件路径不再分配大数组。池为空时直接分配新的缓冲区，所以没有归还的事件
+ * 只会让池退化为普通分配，不会出错。
+ */
+class AudioBufferPool(
+    val bufferSize: Int,
+    private val capacity: Int
+) {
+
+    private val free = ArrayList<FloatArray>(capacity)
+
+    /**
+     * 池为空时新分配的次数
+     */
+    var misses = 0
+        private set
+
+    @Synchronized
+    fun acquire(): FloatArray {
+        if (free.isEmpty()) {
+            misses++
+            return FloatArray(bufferSize)
+        }
+        return free.removeAt(free.size - 1)
+    }
+
+    /**
+     * 归还缓冲区；归还后调用方不能再读写它
+     */
+    @Synchronized
+    fun release(buffer: FloatArray) {
+        if (buffer.size != bufferSize || free.size >= capacity) return
+        // 防止重复归还导致同一个缓冲区被两个事件共用
+        for (existing in free) {
+            if (existing === buffer) return
+        }
+        free.add(buffer)
+    }
+
+    val available: Int
+        @Synchronized get() = free.size
+}
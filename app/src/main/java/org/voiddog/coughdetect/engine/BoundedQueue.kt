@@ -0,0 +1,92 @@
+package org.voiddog.coughdetect.engine
+
+import java.util.concurrent.atomic.AtomicLong
+import java.util.concurrent.atomic.AtomicReferenceArray
+
+/**
+ * 有界无锁队列，连接流水线的相邻阶段
+ *
+ * 只允许一个线程 [offer]（单生产者）；出队用 CAS 推进队头，所以除了下游消费者，生产者自己也可以
+ * 在队列满时用 [evictIfFull] 取出最旧的元素丢掉。槽位预先分配，入队出队都不分配对象。
+ */
+class BoundedQueue<T : Any>(val capacity: Int) {
+
+    private val slots = AtomicReferenceArray<T?>(capacity)
+    private val head = AtomicLong(0L)
+    @Volatile
+    private var tail = 0L
+    @Volatile
+    private var highWater = 0
+
+    init {
+        require(capacity > 0) { "capacity must be positive" }
+    }
+
+    /**
+     * 当前长度；和其他线程的出入队并发时只是近似值
+     */
+    val size: Int
+        get() = (tail - head.get()).toInt().coerceIn(0, capacity)
+
+    val isFull: Boolean
+        get() = tail - head.get() >= capacity
+
+    /**
+     * 自创建（或上次 [clear]）以来达到过的最大长度
+     */
+    val highWaterMark: Int
+        get() = highWater
+
+    /**
+     * 入队，队列已满时返回 false；只能由生产者线程调用
+     */
+    fun offer(item: T): Boolean {
+        val t = tail
+        if (t - head.get() >= capacity) return false
+        slots.set(index(t), item)
+        tail = t + 1
+        val depth = (t + 1 - head.get()).toInt()
+        if (depth > highWater) {
+            highWater = depth
+        }
+        return true
+    }
+
+    /**
+     * 取出最旧的元素，队列为空时返回 null；可以和 [evictIfFull] 并发
+     */
+    fun poll(): T? = take(1L)
+
+    /**
+     * 队列已满时取出最旧的元素让出位置，否则返回 null
+     */
+    fun evictIfFull(): T? = take(capacity.toLong())
+
+    /**
+     * 清空队列；调用时不能有其他线程在使用它
+     */
+    fun clear() {
+        for (i in 0 until capacity) {
+            slots.set(i, null)
+        }
+        head.set(tail)
+        highWater = 0
+    }
+
+    // 至少有 [minSize] 个元素时取出队头
+    private fun take(minSize: Long): T? {
+        while (true) {
+            val h = head.get()
+            if (tail - h < minSize) return null
+            val item = slots.get(index(h))
+            // 队头推进之前生产者不会覆盖这个槽位，CAS 成功就独占了读到的元素
+            if (head.compareAndSet(h, h + 1)) {
+                // 生产者可能已经在这个槽位写入了新元素，只清除自己取走的那个
+                slots.compareAndSet(index(h), item, null)
+                return item
+            }
+        }
+    }
+
+    private fun index(position: Long): Int = (position % capacity).toInt()
+}
@@ -1,36 +1,125 @@
 package org.voiddog.coughdetect.engine
 
 import android.content.Context
+import android.os.Debug
 import android.util.Log
 import kotlinx.coroutines.*
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.flow.receiveAsFlow
 import org.voiddog.coughdetect.audio.AudioRecorder
+import org.voiddog.coughdetect.audio.AudioSource
+import org.voiddog.coughdetect.audio.SampleFormat
+import org.voiddog.coughdetect.audio.StreamHealth
 import org.voiddog.coughdetect.ml.TensorFlowLiteDetector
+import org.voiddog.coughdetect.utils.ThreadPlacement
 import java.util.concurrent.atomic.AtomicBoolean
 
-class CoughDetectEngine(private val context: Context) {
+class CoughDetectEngine(
+    private val context: Context,
+    // 默认从麦克风采集；测试和基准测试可以注入文件或合成信号
+    private val audioSource: AudioSource = AudioRecorder(context),
+    // 历史缓冲区的存储格式：PCM16 占用一半内存，取窗口时才转换成 float
+    private val historyFormat: SampleFormat = SampleFormat.PCM16
+) {
 
     companion object {
         private const val TAG = "CoughDetectEngine"
-        private const val AUDIO_BUFFER_DURATION_MS = 1000 // 1 second buffers
-        private const val AUDIO_DETECT_OVERLAP = 200; // 200ms cache for detection overlap
-        private const val MIN_CONFIDENCE_THRESHOLD = 0.6f
-        private const val AUDIO_LEVEL_LOG_INTERVAL_MS = 100L // Log audio level every 100ms
+        private const val LOG_INTERVAL_MS = 100L // Rate-limit warnings from the audio thread
+        private const val AUDIO_EVENT_POOL_SIZE = 4 // Events whose audio may be in flight at once
+        private const val MAX_GAP_MARKERS = 64 // Most recent capture gaps kept for inspection
+        private const val WINDOW_QUEUE_CAPACITY = 4 // Windows cut ahead of scoring
+        private const val EVENT_QUEUE_CAPACITY = 8 // Detected events waiting for dispatch
+        private const val EVENT_CHANNEL_CAPACITY = 16 // Dispatched events waiting for the audioEvents consumer
+        private const val STAGE_IDLE_WAIT_NANOS = 500_000_000L // Idle stages are woken by their neighbours; this is a safety net
+        private const val STAGE_STOP_TIMEOUT_MS = 1000L
+        private const val BURST_TARGET_LOAD = 0.5f // Inference should take at most this share of a window's budget
+        private const val MAX_EVENT_RUN_MS = 3000L // Longest run of overlapping positive windows merged into one event
+
+        // Pipeline stage threads are named with this prefix
+        internal const val PIPELINE_THREAD_PREFIX = "CoughPipeline-"
     }
 
-    private val audioRecorder = AudioRecorder(context)
     private val tensorFlowDetector = TensorFlowLiteDetector(context)
 
-    private var detectionJob: Job? = null
     private val isInitialized = AtomicBoolean(false)
 
-    // Audio buffer for accumulating samples
-    private val audioBuffer = mutableListOf<Float>()
+    private val sampleRate = audioSource.getSampleRate()
+    private val maxWindowSize = (sampleRate * EngineConfig.MAX_WINDOW_MS) / 1000
+
+    // 当前生效的配置；新配置先放在 pendingConfig，由分帧阶段在窗口边界整体切换
+    @Volatile
+    private var config = EngineConfig()
+    @Volatile
+    private var pendingConfig: EngineConfig? = null
+    private val configLock = Any()
+    // 由配置推导出的窗口参数，只在分帧阶段（或未录音时）修改
+    private var targetBufferSize = (sampleRate * config.windowMs) / 1000
+    private var overlapBufferSize = (sampleRate * config.overlapMs) / 1000
+    private var preRollSize = (sampleRate * config.preRollMs) / 1000
+    private var fineHopSize = (sampleRate * config.fineHopMs) / 1000
+    private var coarseHopSize = (sampleRate * minOf(config.coarseHopMs, config.windowMs)) / 1000
+
+    // Audio buffer for accumulating samples (holds up to two of the longest windows,
+    // so the window length can change at runtime without reallocating or losing audio)
+    private val audioBuffer: SampleRingBuffer = when (historyFormat) {
+        SampleFormat.FLOAT -> FloatRingBuffer(maxWindowSize * 2)
+        SampleFormat.PCM16 -> ShortRingBuffer(maxWindowSize * 2)
+    }
     private val bufferLock = Any()
-    private val targetBufferSize = (audioRecorder.getSampleRate() * AUDIO_BUFFER_DURATION_MS) / 1000
-    private val overlapBufferSize = (audioRecorder.getSampleRate() * AUDIO_DETECT_OVERLAP) / 1000
+    // 已收到的样本数（采样时间轴）和把样本序号换算成采集时刻的采样时钟，由录音线程在 bufferLock 内更新
+    @Volatile
+    private var samplesReceived = 0L
+    private val sampleClock = SampleClock(sampleRate)
+    // 采集中断在时间轴上的位置，受 bufferLock 保护
+    private val gapMarkers = ArrayDeque<GapMarker>()
+    // 检测流水线：分帧 → 打分（特征 + 模型/规则）→ 分段 → 分发，各阶段一个线程，之间用有界无锁队列连接。
+    // 窗口帧预先分配：队列容量加上分帧、打分两端各持有的一个，分帧填充，打分用完后归还
+    private val windowFrames = Array(WINDOW_QUEUE_CAPACITY + 2) { WindowFrame(maxWindowSize) }
+    private val windowQueue = BoundedQueue<WindowFrame>(WINDOW_QUEUE_CAPACITY)
+    private val freeFrames = BoundedQueue<WindowFrame>(windowFrames.size)
+    private val eventQueue = BoundedQueue<AudioEvent>(EVENT_QUEUE_CAPACITY)
+    private val pipelineStats = PipelineStats(arrayOf<BoundedQueue<*>>(windowQueue, eventQueue))
+    // 只在分帧阶段使用：BLOCK 策略下本轮等待是否已经计数
+    private var framingBlocked = false
+    // 只在分帧阶段使用：自适应步长下，历史缓冲区开头是否保留着上一个窗口
+    private var windowCut = false
+    // 只在打分阶段使用：检测器当前参数对应的配置，以及事件队列满时暂存的事件
+    private var scoringConfig: EngineConfig? = null
+    private var pendingEvent: AudioEvent? = null
+    // 只在打分阶段使用：自适应步长下连续重叠的阳性窗口中置信度最高的一个，这段结束时才发出；
+    // 这段的第一个样本和最后一个阳性窗口的最后一个样本
+    private var heldEvent: AudioEvent? = null
+    private var runStartSample = 0L
+    private var runEndSample = 0L
+    private val maxEventRunSamples = sampleRate.toLong() * MAX_EVENT_RUN_MS / 1000
+    // 只在打分阶段使用：最近一次完整打分的耗时，用来预估窗口能否在截止时间前出结果
+    private var lastScoringNanos = 0L
+    // 只在打分阶段使用：按 CPU 余量选择检测档位，当前档位发布到 detectionTier
+    private var governor = LoadGovernor(config.governor)
+    // 窗口长度变化时由打分阶段换一个池，旧尺寸的缓冲区归还时会被忽略
+    @Volatile
+    private var audioBufferPool = AudioBufferPool(targetBufferSize, AUDIO_EVENT_POOL_SIZE)
+    // 低功耗监听：录音线程上只跑能量门限，有活动时才做完整的分窗检测
+    @Volatile
+    private var lowPowerMode = false
+    @Volatile
+    private var energyGate = EnergyGate(sampleRate, config.energyGate)
+    // 自适应步长的活动检测，同样在录音线程上运行，分帧阶段读取它的状态
+    @Volatile
+    private var activityGate = EnergyGate(sampleRate, config.activityGate)
+    private val powerMeter = PowerMeter()
+    // 分帧紧跟采集；打分稳态留在能效核，模型推理时提升；分发交给后台优先级，不和采集线程争抢
+    private val framingStage = PipelineStage(PIPELINE_THREAD_PREFIX + "framing", ThreadPlacement.Role.FRAMING, powerMeter, ::onPipelineError) { runFraming() }
+    private val scoringStage = PipelineStage(PIPELINE_THREAD_PREFIX + "scoring", ThreadPlacement.Role.ANALYSIS, powerMeter, ::onPipelineError) { runScoring() }
+    private val dispatchStage = PipelineStage(PIPELINE_THREAD_PREFIX + "dispatch", ThreadPlacement.Role.IO, powerMeter, ::onPipelineError) { runDispatch() }
+    // 只在打分阶段使用：完整检测期间的优先级提升和性能提示
+    private val inferenceBurst = ThreadPlacement.Burst(context, ThreadPlacement.Role.ANALYSIS)
+    // 只在分发阶段使用
+    private val eventTimeFormat = java.text.SimpleDateFormat("HH:mm:ss.SSS", java.util.Locale.getDefault())
 
     // Engine states
     enum class EngineState(val value: Int) {
@@ -44,7 +133,7 @@ class CoughDetectEngine(private val context: Context) {
     enum class AudioEventType(val value: Int) {
         COUGH_DETECTED(0),
         SNORING_DETECTED(1),
-        AUDIO_LEVEL_CHANGED(2),
+        AUDIO_LEVEL_CHANGED(2), // 不再由引擎发出：电平通过 getTelemetry() 轮询
         ERROR_OCCURRED(3)
     }
 
@@ -54,7 +143,16 @@ class CoughDetectEngine(private val context: Context) {
         val confidence: Float,
         val amplitude: Float,
         val timestamp: Long,
-        val audioData: FloatArray? = null
+        val audioData: FloatArray? = null,
+        // 产生这个事件时的检测档位
+        val tier: LoadGovernor.Tier = LoadGovernor.Tier.FULL,
+        // 事件所在窗口第一个和最后一个样本在采样时间轴上的序号和采集时刻（System.nanoTime 时基），
+        // 以及检测出结果的时刻；不对应窗口的事件为 -1 / 0
+        val startSample: Long = -1L,
+        val endSample: Long = -1L,
+        val startNanos: Long = 0L,
+        val endNanos: Long = 0L,
+        val detectedNanos: Long = 0L
     ) {
         // Override equals and hashCode to handle FloatArray properly
         override fun equals(other: Any?): Boolean {
@@ -67,6 +165,10 @@ class CoughDetectEngine(private val context: Context) {
             if (confidence != other.confidence) return false
             if (amplitude != other.amplitude) return false
             if (timestamp != other.timestamp) return false
+            if (tier != other.tier) return false
+            if (startSample != other.startSample || endSample != other.endSample) return false
+            if (startNanos != other.startNanos || endNanos != other.endNanos) return false
+            if (detectedNanos != other.detectedNanos) return false
             if (audioData != null) {
                 if (other.audioData == null) return false
                 if (!audioData.contentEquals(other.audioData)) return false
@@ -81,104 +183,217 @@ class CoughDetectEngine(private val context: Context) {
             result = 31 * result + amplitude.hashCode()
             result = 31 * result + timestamp.hashCode()
             result = 31 * result + (audioData?.contentHashCode() ?: 0)
+            result = 31 * result + tier.hashCode()
+            result = 31 * result + startSample.hashCode()
+            result = 31 * result + endNanos.hashCode()
             return result
         }
     }
 
+    // A window cut from the history, passed from the framing to the scoring stage
+    private class WindowFrame(maxSize: Int) {
+        val samples = FloatArray(maxSize)
+        var length = 0
+        // 切窗口时生效的配置，打分阶段据此在同一个窗口边界切换检测参数
+        lateinit var config: EngineConfig
+        // 第一个样本在采样时间轴上的序号；第一个和最后一个样本的采集时刻，以及必须出结果的截止时刻（System.nanoTime）
+        var startSample = 0L
+        var startNanos = 0L
+        var endNanos = 0L
+        var deadlineNanos = 0L
+        // 距上一个窗口的步长对应的实时时长，打分要在这之内完成才跟得上
+        var budgetNanos = 0L
+    }
+
+    // Capture gap in the sample timeline: [lostSamples] are missing just before sample [position]
+    data class GapMarker(
+        val position: Long,
+        val lostSamples: Long
+    )
+
     // State flows
     private val _engineState = MutableStateFlow(EngineState.IDLE)
     val engineState: StateFlow<EngineState> = _engineState.asStateFlow()
+    // 所有状态写入都在此锁内完成，评分线程用比较后写入，不会覆盖 pause()/stop() 的结果
+    private val stateLock = Any()
 
-    private val _audioLevel = MutableStateFlow(0f)
-    val audioLevel: StateFlow<Float> = _audioLevel.asStateFlow()
+    // 每个 COUGH_DETECTED 事件恰好送达一次，不会像 StateFlow 那样被合并；
+    // 只能有一个消费者，处理完（编码写盘）后用 releaseAudioEvent 归还事件的音频缓冲区
+    private val audioEventChannel = Channel<AudioEvent>(EVENT_CHANNEL_CAPACITY)
+    val audioEvents: Flow<AudioEvent> = audioEventChannel.receiveAsFlow()
 
+    // 最近一次咳嗽事件，供界面展示；不带音频，音频缓冲区归还后会被别的事件复用
     private val _lastAudioEvent = MutableStateFlow<AudioEvent?>(null)
     val lastAudioEvent: StateFlow<AudioEvent?> = _lastAudioEvent.asStateFlow()
 
+    // 当前检测档位，CPU 余量变化时由打分阶段更新
+    private val _detectionTier = MutableStateFlow(LoadGovernor.Tier.FULL)
+    val detectionTier: StateFlow<LoadGovernor.Tier> = _detectionTier.asStateFlow()
+
     private val _error = MutableStateFlow<String?>(null)
     val error: StateFlow<String?> = _error.asStateFlow()
 
+    // 同步事件回调，在分发线程上按顺序收到每个事件（如基准测试）；事件的音频只在回调期间有效
+    @Volatile
+    private var audioEventListener: ((AudioEvent) -> Unit)? = null
+
+    // 供 UI 轮询的遥测数据块，避免每次读取电平/状态都经过 StateFlow
+    private val telemetry = EngineTelemetry()
+
     // 统计变量
     private var coughDetectionCount = 0
     private var firstCoughTime = 0L
-    private var lastAudioEventSentTime = 0L
     private var lastLogErrorTime = 0L
 
     init {
         // Set up audio data callback
-        audioRecorder.setAudioDataCallback { audioData, amplitude ->
-            onAudioData(audioData, amplitude)
+        audioSource.setAudioDataCallback { audioData, length, amplitude ->
+            onAudioData(audioData, length, amplitude)
+        }
+        // 采集流断开重连后报告中断，窗口状态保持不变
+        audioSource.setStreamGapCallback { lostSamples, lostNanos ->
+            onStreamGap(lostSamples, lostNanos)
+        }
+        // PCM 历史直接接收音频源的 16-bit 数据，音频线程上不做格式转换
+        val pcm16History = audioBuffer as? ShortRingBuffer
+        if (pcm16History != null && audioSource.supportsPcm16()) {
+            audioSource.setPcm16DataCallback { samples, length, amplitude ->
+                onPcm16Data(pcm16History, samples, length, amplitude)
+            }
         }
     }
 
-    // Callback for audio data from AudioRecorder
-    private fun onAudioData(audioData: FloatArray, amplitude: Float) {
-        // Limit frequency of audio level change events
-        val currentTime = System.currentTimeMillis()
-        val shouldEmitAudioLevelEvent = currentTime - lastAudioEventSentTime >= AUDIO_LEVEL_LOG_INTERVAL_MS
-        var canLog = currentTime - lastLogErrorTime >= AUDIO_LEVEL_LOG_INTERVAL_MS
+    // Callback for audio data from the audio source.
+    // Runs on the audio thread for every chunk: nothing here may allocate in steady state.
+    // The UI polls the level from the telemetry block, so no event is emitted per chunk.
+    private fun onAudioData(audioData: FloatArray, length: Int, amplitude: Float) {
+        val startNanos = System.nanoTime()
+        val cpuStart = Debug.threadCpuTimeNanos()
         try {
             // Update audio level
-            _audioLevel.value = amplitude
+            telemetry.updateAudioLevel(amplitude)
 
-            if (shouldEmitAudioLevelEvent) {
-                // Emit audio level change event
-                val event = AudioEvent(
-                    type = AudioEventType.AUDIO_LEVEL_CHANGED,
-                    confidence = 1.0f,
-                    amplitude = amplitude,
-                    timestamp = currentTime // Use current time for the event
-                )
-                _lastAudioEvent.value = event
-                lastAudioEventSentTime = currentTime // Update last log time
+            // 低功耗监听时只有能量门限打开才唤醒分帧，否则分帧阶段按轮询周期自己检查
+            val wakeFraming = !lowPowerMode || energyGate.process(audioData, 0, length)
+            if (config.adaptiveHop) {
+                activityGate.process(audioData, 0, length)
             }
 
-            // Add to buffer for cough detection
-            synchronized(bufferLock) {
-                audioBuffer.addAll(audioData.toList())
-
-                // Keep buffer size manageable
-                val currentSize = audioBuffer.size
-                val maxSize = targetBufferSize * 2
-                if (currentSize > maxSize) {
-                    // Efficiently remove excess elements
-                    val elementsToRemove = currentSize - maxSize
-                    audioBuffer.subList(0, elementsToRemove).clear()
-                    if (canLog) {
-                        Log.w(TAG, "音频缓冲区已满，已删除${elementsToRemove}个元素")
-                        lastLogErrorTime = currentTime // Update last log time
-                    }
+            // Add to buffer for cough detection; the oldest samples are dropped when full
+            val dropped = synchronized(bufferLock) {
+                samplesReceived += length
+                sampleClock.onChunk(samplesReceived, length, startNanos - inputLatencyNanos())
+                audioBuffer.write(audioData, 0, length)
+            }
+            if (dropped > 0) {
+                telemetry.recordDroppedSamples(dropped)
+                val currentTime = System.currentTimeMillis()
+                if (currentTime - lastLogErrorTime >= LOG_INTERVAL_MS) {
+                    Log.w(TAG, "音频缓冲区已满，已删除${dropped}个元素")
+                    lastLogErrorTime = currentTime // Update last log time
                 }
             }
+            if (wakeFraming) {
+                framingStage.wake()
+            }
 
         } catch (e: Exception) {
-            if (canLog) {
+            val currentTime = System.currentTimeMillis()
+            if (currentTime - lastLogErrorTime >= LOG_INTERVAL_MS) {
                 Log.e(TAG, "处理音频数据时发生异常", e)
                 lastLogErrorTime = currentTime // Update last log time
             }
             _error.value = "音频处理异常: ${e.message}"
+        } finally {
+            powerMeter.addCpu(Debug.threadCpuTimeNanos() - cpuStart)
+            pipelineStats.recordStage(PipelineStats.Stage.CAPTURE, System.nanoTime() - startNanos)
         }
     }
 
-    // Callback for cough detection results
-    private fun onCoughDetected(confidence: Float, amplitude: Float, detectedAudioData: FloatArray) {
+    // Capture-to-callback latency derived from the AudioRecord timestamp, 0 when the source has none
+    private fun inputLatencyNanos(): Long {
+        val latencyUs = audioSource.getStreamHealth()?.getInputLatencyUs() ?: StreamHealth.UNKNOWN_LATENCY
+        return if (latencyUs > 0L) latencyUs * 1000L else 0L
+    }
+
+    // 16-bit PCM variant of [onAudioData]; same rules apply
+    private fun onPcm16Data(history: ShortRingBuffer, samples: ShortArray, length: Int, amplitude: Float) {
+        val startNanos = System.nanoTime()
+        val cpuStart = Debug.threadCpuTimeNanos()
         try {
+            telemetry.updateAudioLevel(amplitude)
+
+            val wakeFraming = !lowPowerMode || energyGate.process(samples, 0, length)
+            if (config.adaptiveHop) {
+                activityGate.process(samples, 0, length)
+            }
+
+            val dropped = synchronized(bufferLock) {
+                samplesReceived += length
+                sampleClock.onChunk(samplesReceived, length, startNanos - inputLatencyNanos())
+                history.writePcm16(samples, 0, length)
+            }
+            if (dropped > 0) {
+                telemetry.recordDroppedSamples(dropped)
+                val currentTime = System.currentTimeMillis()
+                if (currentTime - lastLogErrorTime >= LOG_INTERVAL_MS) {
+                    Log.w(TAG, "音频缓冲区已满，已删除${dropped}个元素")
+                    lastLogErrorTime = currentTime
+                }
+            }
+            if (wakeFraming) {
+                framingStage.wake()
+            }
+
+        } catch (e: Exception) {
             val currentTime = System.currentTimeMillis()
-            val timeStr = java.text.SimpleDateFormat("HH:mm:ss.SSS", java.util.Locale.getDefault())
-                .format(java.util.Date(currentTime))
-
-            Log.i(TAG, "🎯 咳嗽检测成功! 时间: $timeStr, 置信度: ${String.format("%.3f", confidence)}, " +
-                    "振幅: ${String.format("%.3f", amplitude)}, 音频数据长度: ${detectedAudioData.size}")
-
-            // Use the exact audio data that was used for detection
-            val event = AudioEvent(
-                type = AudioEventType.COUGH_DETECTED,
-                confidence = confidence,
-                amplitude = amplitude,
-                timestamp = currentTime,
-                audioData = detectedAudioData // 使用实际检测的音频数据
-            )
-            _lastAudioEvent.value = event
+            if (currentTime - lastLogErrorTime >= LOG_INTERVAL_MS) {
+                Log.e(TAG, "处理音频数据时发生异常", e)
+                lastLogErrorTime = currentTime
+            }
+            _error.value = "音频处理异常: ${e.message}"
+        } finally {
+            powerMeter.addCpu(Debug.threadCpuTimeNanos() - cpuStart)
+            pipelineStats.recordStage(PipelineStats.Stage.CAPTURE, System.nanoTime() - startNanos)
+        }
+    }
+
+    // The audio source reopened its stream after a disconnect. The history ring and the
+    // windowing position are kept, so the next window simply spans the gap; the gap is
+    // recorded as a marker in the sample timeline and counted as lost audio.
+    private fun onStreamGap(lostSamples: Long, lostNanos: Long) {
+        telemetry.recordGap(lostSamples)
+        synchronized(bufferLock) {
+            if (gapMarkers.size >= MAX_GAP_MARKERS) {
+                gapMarkers.removeFirst()
+            }
+            gapMarkers.addLast(GapMarker(samplesReceived, lostSamples))
+        }
+        Log.w(TAG, "⚠️ 音频采集中断 ${lostNanos / 1_000_000}ms，累计丢失 ${getLostAudioMs()}ms")
+    }
+
+    // Deliver a detected event (dispatch stage)
+    private fun dispatchEvent(event: AudioEvent) {
+        try {
+            val currentTime = event.timestamp
+            val timeStr = eventTimeFormat.format(java.util.Date(currentTime))
+
+            // Capture -> detect -> dispatch latency of the window's last sample
+            val dispatchLatencyNanos = System.nanoTime() - event.endNanos
+            pipelineStats.recordEventLatency(event.detectedNanos - event.endNanos, dispatchLatencyNanos)
+
+            Log.i(TAG, "🎯 咳嗽检测成功! 时间: $timeStr, 置信度: ${String.format("%.3f", event.confidence)}, " +
+                    "振幅: ${String.format("%.3f", event.amplitude)}, 音频数据长度: ${event.audioData?.size ?: 0}, " +
+                    "检测延迟: ${dispatchLatencyNanos / 1_000_000}ms")
+
+            _lastAudioEvent.value = event.copy(audioData = null)
+            telemetry.recordEvent()
+            audioEventListener?.invoke(event)
+            if (!audioEventChannel.trySend(event).isSuccess) {
+                // 消费者跟不上或者没有消费者：事件不再保存，音频缓冲区立即归还
+                Log.w(TAG, "⚠️ 事件消费者积压，丢弃 $timeStr 的咳嗽事件音频")
+                releaseAudioEvent(event)
+            }
 
             // 统计咳嗽检测频率
             coughDetectionCount++
@@ -209,7 +424,7 @@ class CoughDetectEngine(private val context: Context) {
             }
 
             // Initialize audio recorder
-            if (!audioRecorder.initialize()) {
+            if (!audioSource.initialize()) {
                 Log.e(TAG, "❌ 音频录制器初始化失败")
                 _error.value = "音频录制器初始化失败"
                 return false
@@ -223,7 +438,16 @@ class CoughDetectEngine(private val context: Context) {
 
             val initTime = System.currentTimeMillis() - startTime
             isInitialized.set(true)
-            _engineState.value = EngineState.IDLE
+            telemetry.reset()
+            powerMeter.reset()
+            pipelineStats.reset()
+            samplesReceived = 0L
+            synchronized(bufferLock) {
+                gapMarkers.clear()
+                sampleClock.reset()
+            }
+            telemetry.updateReady(true)
+            setState(EngineState.IDLE)
 
             // 重置统计
             coughDetectionCount = 0
@@ -260,17 +484,25 @@ class CoughDetectEngine(private val context: Context) {
                 return true
             }
 
+            energyGate.reset()
+            activityGate.reset()
+
             // Start audio recording
-            if (!audioRecorder.start()) {
+            if (!audioSource.start()) {
                 Log.e(TAG, "❌ 音频录制启动失败")
                 _error.value = "音频录制启动失败"
                 return false
             }
 
-            // Start detection job
-            startDetectionJob()
+            // Start the detection pipeline
+            if (!startPipeline()) {
+                audioSource.stop()
+                Log.e(TAG, "❌ 上次停止的检测线程还没有退出，无法启动检测")
+                _error.value = "检测线程仍在退出中"
+                return false
+            }
 
-            _engineState.value = EngineState.RECORDING
+            setState(EngineState.RECORDING)
             val startDuration = System.currentTimeMillis() - startTime
 
             Log.i(TAG, "✅ 检测启动成功! 耗时: ${startDuration}ms")
@@ -291,19 +523,20 @@ class CoughDetectEngine(private val context: Context) {
             val currentState = getState()
             Log.d(TAG, "停止前状态: ${currentState.name}")
 
-            // Stop detection job
-            detectionJob?.cancel()
-            detectionJob = null
+            // Stop the detection pipeline
+            stopPipeline()
 
             // Stop audio recording
-            audioRecorder.stop()
+            audioSource.stop()
+            powerMeter.switchTo(null, System.nanoTime())
 
             // Clear audio buffer
             synchronized(bufferLock) {
                 audioBuffer.clear()
             }
 
-            _engineState.value = EngineState.IDLE
+            telemetry.updateAudioLevel(0f)
+            setState(EngineState.IDLE)
 
             Log.i(TAG, "✅ 检测已停止，新状态: ${getState().name}")
 
@@ -323,9 +556,18 @@ class CoughDetectEngine(private val context: Context) {
     // Pause detection
     fun pause() {
         try {
-            if (getState() == EngineState.RECORDING) {
-                audioRecorder.pause()
-                _engineState.value = EngineState.PAUSED
+            // 评分线程正在处理窗口（PROCESSING）时同样可以暂停
+            val paused = synchronized(stateLock) {
+                val state = getState()
+                if (state == EngineState.RECORDING || state == EngineState.PROCESSING) {
+                    audioSource.pause()
+                    setState(EngineState.PAUSED)
+                    true
+                } else {
+                    false
+                }
+            }
+            if (paused) {
                 Log.i(TAG, "⏸️ 检测已暂停")
             }
         } catch (e: Exception) {
@@ -337,9 +579,16 @@ class CoughDetectEngine(private val context: Context) {
     // Resume detection
     fun resume() {
         try {
-            if (getState() == EngineState.PAUSED) {
-                audioRecorder.resume()
-                _engineState.value = EngineState.RECORDING
+            val resumed = synchronized(stateLock) {
+                if (getState() == EngineState.PAUSED) {
+                    audioSource.resume()
+                    setState(EngineState.RECORDING)
+                    true
+                } else {
+                    false
+                }
+            }
+            if (resumed) {
                 Log.i(TAG, "▶️ 检测已恢复")
             }
         } catch (e: Exception) {
@@ -350,28 +599,161 @@ class CoughDetectEngine(private val context: Context) {
 
     // Get current engine state
     fun getState(): EngineState {
-        return _engineState.value
+        return telemetry.getState()
     }
 
     // Get current audio level
     fun getAudioLevel(): Float {
-        return _audioLevel.value
+        return telemetry.getAudioLevel()
     }
 
     // Get sample rate
     fun getSampleRate(): Int {
-        return audioRecorder.getSampleRate()
+        return sampleRate
+    }
+
+    // Memory held by the sample history ring, in bytes
+    fun getHistoryBytes(): Int {
+        return audioBuffer.capacity * audioBuffer.bytesPerSample
     }
 
     // Check if engine is ready
     fun isReady(): Boolean {
-        return isInitialized.get()
+        return telemetry.isReady()
+    }
+
+    // Telemetry block shared with the UI; hand it out once and poll it directly.
+    // The primitive getters above and the is*() checks below are single volatile
+    // reads of this block, cheap enough to call from UI polling loops.
+    fun getTelemetry(): EngineTelemetry {
+        return telemetry
+    }
+
+    // Capture stream health (frames read vs expected, xruns, jitter and processing
+    // histograms, input latency) from the audio source; null if it doesn't track it.
+    // Lock-free reads, safe from any thread.
+    fun getStreamHealth(): StreamHealth.Snapshot? {
+        return audioSource.getStreamHealth()?.snapshot()
+    }
+
+    // Return an event's audio buffer to the pool once the audioEvents consumer is done with it
+    // (encoded/saved). The event's audioData must not be used afterwards.
+    fun releaseAudioEvent(event: AudioEvent) {
+        event.audioData?.let { audioBufferPool.release(it) }
+    }
+
+    // Validate and set the engine configuration. While recording it takes effect at the
+    // next window boundary, without restarting the audio stream or dropping buffered audio.
+    // An invalid configuration is rejected with false; it is not an engine error, so the
+    // current configuration and an active recording carry on untouched.
+    fun setConfig(newConfig: EngineConfig): Boolean {
+        val errors = newConfig.validate()
+        if (errors.isNotEmpty()) {
+            Log.w(TAG, "⚠️ 引擎配置无效，保持当前配置: ${errors.joinToString("; ")}")
+            return false
+        }
+
+        pendingConfig = newConfig
+        if (!framingStage.isRunning) {
+            applyPendingConfig()
+        }
+        Log.i(TAG, "⚙️ 引擎配置已更新: $newConfig")
+        return true
+    }
+
+    // The configuration in effect, or the one about to take effect
+    fun getConfig(): EngineConfig {
+        return pendingConfig ?: config
+    }
+
+    private fun applyPendingConfig() {
+        synchronized(configLock) {
+            val next = pendingConfig ?: return
+            pendingConfig = null
+
+            // 检测器参数和事件缓冲区池随第一个按新配置切出的窗口在打分阶段切换
+            targetBufferSize = (sampleRate * next.windowMs) / 1000
+            overlapBufferSize = (sampleRate * next.overlapMs) / 1000
+            preRollSize = (sampleRate * next.preRollMs) / 1000
+            fineHopSize = (sampleRate * next.fineHopMs) / 1000
+            coarseHopSize = (sampleRate * minOf(next.coarseHopMs, next.windowMs)) / 1000
+            if (next.activityGate != config.activityGate) {
+                activityGate = EnergyGate(sampleRate, next.activityGate)
+            }
+            if (next.adaptiveHop != config.adaptiveHop) {
+                windowCut = false
+            }
+            if (next.energyGate != config.energyGate) {
+                energyGate = EnergyGate(sampleRate, next.energyGate)
+            }
+            config = next
+        }
+    }
+
+    // Per-stage timing and queue depths/drops of the detection pipeline
+    fun getPipelineStats(): PipelineStats.Snapshot {
+        return pipelineStats.snapshot()
+    }
+
+    // Wakeups, migrations and current core of the capture, pipeline and I/O threads
+    fun getThreadStats(): List<ThreadPlacement.ThreadStats> {
+        return ThreadPlacement.snapshot()
+    }
+
+    // Total audio lost to capture gaps (stream disconnects), in milliseconds
+    fun getLostAudioMs(): Long {
+        return telemetry.getSamplesLost() * 1000 / sampleRate
+    }
+
+    // Most recent capture gaps, oldest first
+    fun getGapMarkers(): List<GapMarker> {
+        return synchronized(bufferLock) { gapMarkers.toList() }
+    }
+
+    // Low-power listening: only a decimated energy gate runs until activity crosses
+    // its threshold, then full analysis resumes (starting with the pre-roll) until a
+    // quiet period has passed. Can be toggled while recording.
+    fun setLowPowerMode(enabled: Boolean) {
+        if (lowPowerMode == enabled) return
+        energyGate.reset()
+        lowPowerMode = enabled
+        Log.i(TAG, if (enabled) "🌙 进入低功耗监听模式" else "☀️ 退出低功耗监听模式")
+    }
+
+    fun isLowPowerMode(): Boolean {
+        return lowPowerMode
+    }
+
+    // CPU and wall time accumulated in full analysis versus low-power listening
+    fun getPowerUsage(): PowerMeter.Usage {
+        return powerMeter.usage(System.nanoTime())
+    }
+
+    // Receive every COUGH_DETECTED event on the dispatch stage thread, in order
+    fun setAudioEventListener(listener: ((AudioEvent) -> Unit)?) {
+        audioEventListener = listener
+    }
+
+    private fun setState(state: EngineState) {
+        synchronized(stateLock) {
+            telemetry.updateState(state)
+            _engineState.value = state
+        }
+    }
+
+    // Move to the given state only if the engine is still in the expected one
+    private fun compareAndSetState(expected: EngineState, state: EngineState): Boolean {
+        synchronized(stateLock) {
+            if (getState() != expected) return false
+            setState(state)
+            return true
+        }
     }
 
     // Clear error
     fun clearError() {
         _error.value = null
-        audioRecorder.clearError()
+        audioSource.clearError()
     }
 
     // Release resources
@@ -383,7 +765,7 @@ class CoughDetectEngine(private val context: Context) {
             stop()
 
             // Release audio recorder
-            audioRecorder.release()
+            audioSource.release()
 
             // Release TensorFlow detector
             tensorFlowDetector.cleanup()
@@ -394,7 +776,8 @@ class CoughDetectEngine(private val context: Context) {
             }
 
             isInitialized.set(false)
-            _engineState.value = EngineState.IDLE
+            telemetry.updateReady(false)
+            setState(EngineState.IDLE)
 
             Log.i(TAG, "✅ 引擎资源已释放")
 
@@ -403,63 +786,372 @@ class CoughDetectEngine(private val context: Context) {
         }
     }
 
-    // Start detection job
-    private fun startDetectionJob() {
-        detectionJob = CoroutineScope(Dispatchers.Default).launch {
-            while (isActive && getState() == EngineState.RECORDING) {
-                try {
-                    // Get audio data for detection
-                    val audioData = synchronized(bufferLock) {
-                        if (audioBuffer.size >= targetBufferSize) {
-                            val data = audioBuffer.take(targetBufferSize).toFloatArray()
-                            val removeCount = targetBufferSize - overlapBufferSize
-                            // Efficiently remove elements
-                            if (removeCount > 0 && removeCount <= audioBuffer.size) {
-                                audioBuffer.subList(0, removeCount).clear()
-                            }
-                            data
-                        } else {
-                            null
-                        }
-                    }
+    // Returns false while a stage stopped earlier is still finishing: it still owns the queues
+    // and the events it holds, so nothing is reset and no second loop is started next to it.
+    private fun startPipeline(): Boolean {
+        if (framingStage.isStopping || scoringStage.isStopping || dispatchStage.isStopping) {
+            return false
+        }
+        // 上次停止时留在队列里的窗口和事件作废，所有帧放回空闲队列
+        windowQueue.clear()
+        eventQueue.clear()
+        freeFrames.clear()
+        for (frame in windowFrames) {
+            freeFrames.offer(frame)
+        }
+        framingBlocked = false
+        windowCut = false
+        pendingEvent = null
+        heldEvent = null
+        lastScoringNanos = 0L
+        if (governor.rulesTier != tensorFlowDetector.isModelLoaded()) {
+            resetGovernor(governor.config)
+        }
+        // A session left over from a scoring thread that exited late is bound to that thread
+        inferenceBurst.close()
+        return dispatchStage.start() && scoringStage.start() && framingStage.start()
+    }
+
+    // Stop upstream stages first. Events already detected are still delivered, on the calling
+    // thread, once the stages that own them have exited: the event queue is consumed by the
+    // dispatch stage and the held-back event belongs to the scoring stage.
+    private fun stopPipeline() {
+        framingStage.stop(STAGE_STOP_TIMEOUT_MS)
+        val scoringStopped = scoringStage.stop(STAGE_STOP_TIMEOUT_MS)
+        val dispatchStopped = dispatchStage.stop(STAGE_STOP_TIMEOUT_MS)
+        Log.i(TAG, "🧵 流水线线程唤醒次数 - 分帧: ${framingStage.getWakeups()}, 打分: ${scoringStage.getWakeups()}, " +
+                "分发: ${dispatchStage.getWakeups()}")
+        if (!scoringStopped || !dispatchStopped) {
+            Log.w(TAG, "⚠️ 检测线程未能及时退出，尚未分发的事件在下次启动时丢弃")
+            return
+        }
+        // The hint session is bound to the scoring thread, a new one is created with the next thread
+        inferenceBurst.close()
+        while (true) {
+            val event = eventQueue.poll() ?: break
+            dispatchEvent(event)
+        }
+        pendingEvent?.let { dispatchEvent(it) }
+        pendingEvent = null
+        heldEvent?.let { dispatchEvent(it) }
+        heldEvent = null
+    }
+
+    private fun onPipelineError(e: Exception) {
+        Log.e(TAG, "检测任务中发生异常", e)
+        _error.value = "检测异常: ${e.message}"
+    }
+
+    // Framing stage: cut windows from the history ring and queue them for scoring.
+    // Configuration changes and low-power transitions take effect here, at a window boundary.
+    private fun runFraming(): Long {
+        if (pendingConfig != null) {
+            applyPendingConfig()
+        }
+        val current = config
 
-                    audioData?.let { data ->
-                        _engineState.value = EngineState.PROCESSING
+        val fullAnalysis = !lowPowerMode || energyGate.isActive
+        val mode = if (fullAnalysis) PowerMeter.Mode.FULL else PowerMeter.Mode.LISTENING
+        if (mode != powerMeter.getMode()) {
+            if (lowPowerMode) {
+                Log.i(TAG, if (fullAnalysis) "🔊 检测到声音活动，切换到全速分析" else "🌙 持续安静，回到低功耗监听")
+            }
+            powerMeter.switchTo(mode, System.nanoTime())
+        }
 
-                        // Run cough detection
-                        val result = tensorFlowDetector.detectCough(data)
+        if (!fullAnalysis) {
+            // Keep only the pre-roll so the first window after wake-up contains the onset
+            synchronized(bufferLock) {
+                if (audioBuffer.size > preRollSize) {
+                    audioBuffer.discard(audioBuffer.size - preRollSize)
+                }
+            }
+            windowCut = false
+            return current.lowPowerPollMs * 1_000_000L
+        }
 
-                        if (result.isCough && result.confidence >= MIN_CONFIDENCE_THRESHOLD) {
-                            val amplitude = _audioLevel.value
-                            // Pass the actual audio data that was used for detection
-                            onCoughDetected(result.confidence, amplitude, data)
-                        }
+        val buffered = synchronized(bufferLock) { audioBuffer.size }
+        val advance = windowAdvance(buffered, current)
+        if (advance < 0) {
+            return STAGE_IDLE_WAIT_NANOS
+        }
 
-                        _engineState.value = EngineState.RECORDING
+        // Scoring can't keep up: apply the overload policy. The audio thread is never blocked;
+        // under BLOCK the audio waits in the history ring, which drops its oldest samples once full.
+        var evicted: WindowFrame? = null
+        if (windowQueue.isFull) {
+            when (current.overloadPolicy) {
+                EngineConfig.OverloadPolicy.BLOCK -> {
+                    if (!framingBlocked) {
+                        pipelineStats.recordBlocked(PipelineStats.Queue.WINDOWS)
+                        framingBlocked = true
                     }
+                    return STAGE_IDLE_WAIT_NANOS
+                }
+                EngineConfig.OverloadPolicy.DROP_OLDEST -> {
+                    evicted = windowQueue.evictIfFull()
+                    if (evicted != null) {
+                        pipelineStats.recordDrop(PipelineStats.Queue.WINDOWS)
+                    }
+                }
+            }
+        }
+        // The evicted window's frame is refilled right away
+        val frame = evicted ?: freeFrames.poll() ?: return STAGE_IDLE_WAIT_NANOS
+
+        // Get audio data for detection (a PCM16 history is converted to float here)
+        val start = System.nanoTime()
+        synchronized(bufferLock) {
+            audioBuffer.discard(advance)
+            // The window ends this many samples before the newest one received
+            val end = samplesReceived - (audioBuffer.size - targetBufferSize)
+            frame.startSample = end - targetBufferSize
+            frame.startNanos = sampleClock.captureNanosAt(frame.startSample)
+            frame.endNanos = sampleClock.captureNanosAt(end - 1)
+            audioBuffer.peek(frame.samples, 0, targetBufferSize)
+            if (!current.adaptiveHop) {
+                // Keep the overlap for the next window
+                audioBuffer.discard(targetBufferSize - overlapBufferSize)
+            }
+        }
+        val hop = when {
+            !current.adaptiveHop -> targetBufferSize - overlapBufferSize
+            windowCut -> advance
+            else -> coarseHopSize
+        }
+        frame.budgetNanos = hop * 1_000_000_000L / sampleRate
+        windowCut = true
+        frame.length = targetBufferSize
+        frame.config = current
+        frame.deadlineNanos = frame.endNanos + current.deadlineMs * 1_000_000L
+        windowQueue.offer(frame)
+        framingBlocked = false
+        pipelineStats.recordStage(PipelineStats.Stage.FRAMING, System.nanoTime() - start)
+        scoringStage.wake()
+        return 0L
+    }
+
+    // Samples to skip before cutting the next window, or -1 if none is due yet.
+    // Fixed hop: the hop was discarded right after the previous window, so the next window is
+    // simply the oldest one. Adaptive hop: the history still starts with the previous window,
+    // and the next one is due after the fine hop while the activity gate sees onsets or rising
+    // energy, after the coarse hop otherwise. A late window jumps ahead in fine-hop steps, at
+    // most one coarse hop, so the analysis stays current without leaving audio unanalyzed.
+    private fun windowAdvance(buffered: Int, current: EngineConfig): Int {
+        if (!current.adaptiveHop || !windowCut) {
+            return if (buffered >= targetBufferSize) 0 else -1
+        }
+        val newSamples = buffered - targetBufferSize
+        val hop = if (activityGate.isActive) fineHopSize else coarseHopSize
+        if (newSamples < hop) {
+            return -1
+        }
+        return minOf(newSamples / fineHopSize * fineHopSize, coarseHopSize)
+    }
 
-                } catch (e: Exception) {
-                    Log.e(TAG, "检测任务中发生异常", e)
-                    _error.value = "检测异常: ${e.message}"
-                    delay(1000) // Wait before retrying
+    // Scoring stage: features and scores for one window, then segmentation into events.
+    // When behind, a window whose full score would land past its deadline is only covered
+    // coarsely as long as a newer window is waiting, so a backlog is worked off quickly and the
+    // newest window is always scored in full: detection latency stays bounded by the deadline
+    // plus one scoring pass instead of growing with the backlog.
+    private fun runScoring(): Long {
+        // An event that did not fit into the dispatch queue goes first; no new window until it does
+        val waiting = pendingEvent
+        if (waiting != null) {
+            if (!eventQueue.offer(waiting)) {
+                return STAGE_IDLE_WAIT_NANOS
+            }
+            pendingEvent = null
+            dispatchStage.wake()
+        }
+
+        val frame = windowQueue.poll() ?: return STAGE_IDLE_WAIT_NANOS
+        // The queue has room again for a framing stage waiting under BLOCK
+        framingStage.wake()
+        try {
+            if (frame.config !== scoringConfig) {
+                applyScoringConfig(frame.config)
+            }
+            compareAndSetState(EngineState.RECORDING, EngineState.PROCESSING)
+
+            // Run cough detection synchronously on this thread; the result object is reused
+            val scoringStart = System.nanoTime()
+            val result: TensorFlowLiteDetector.DetectionResult
+            val tier: LoadGovernor.Tier
+            if (scoringStart + lastScoringNanos > frame.deadlineNanos && windowQueue.size > 0) {
+                tier = LoadGovernor.Tier.ENERGY
+                result = tensorFlowDetector.detectCoarse(frame.samples, frame.length)
+                telemetry.recordSkippedWindow()
+                pipelineStats.recordStage(PipelineStats.Stage.COARSE_SCORING, System.nanoTime() - scoringStart)
+            } else {
+                // The governor picks the tier from the CPU headroom measured on earlier windows
+                tier = governor.nextTier()
+                result = when (tier) {
+                    LoadGovernor.Tier.FULL -> {
+                        // Burst to a faster core for the model; steady state stays on an efficient one
+                        inferenceBurst.begin()
+                        tensorFlowDetector.detect(frame.samples, frame.length)
+                    }
+                    LoadGovernor.Tier.RULES -> tensorFlowDetector.detectRules(frame.samples, frame.length)
+                    LoadGovernor.Tier.ENERGY -> tensorFlowDetector.detectCoarse(frame.samples, frame.length)
+                }
+                lastScoringNanos = System.nanoTime() - scoringStart
+                if (tier == LoadGovernor.Tier.FULL) {
+                    inferenceBurst.end(lastScoringNanos, (frame.budgetNanos * BURST_TARGET_LOAD).toLong())
+                }
+                telemetry.recordWindow(lastScoringNanos / 1000)
+                pipelineStats.recordStage(PipelineStats.Stage.SCORING, lastScoringNanos)
+                pipelineStats.recordTierWindow(tier)
+                if (scoringStart + lastScoringNanos > frame.deadlineNanos) {
+                    telemetry.recordDeadlineMiss()
+                }
+                if (governor.onWindow(tier, lastScoringNanos, frame.budgetNanos)) {
+                    onTierChanged(governor.loadOf(tier))
                 }
             }
+            pipelineStats.recordWindowLatency(System.nanoTime() - frame.endNanos)
+
+            val segmentationStart = System.nanoTime()
+            segment(frame, result.isCough && result.confidence >= frame.config.minConfidence, result.confidence, tier)
+            pipelineStats.recordStage(PipelineStats.Stage.SEGMENTATION, System.nanoTime() - segmentationStart)
+
+            compareAndSetState(EngineState.PROCESSING, EngineState.RECORDING)
+        } finally {
+            freeFrames.offer(frame)
         }
+        return 0L
+    }
+
+    // Turn scored windows into events (scoring stage). Fixed-hop windows overlap only by the
+    // configured overlap, and each positive one is an event. The adaptive hop cuts a window every
+    // fine hop while a sound goes on, so a single cough is positive in up to a window's worth of
+    // overlapping windows: those form one run, and only its most confident window is emitted, once
+    // the run ends (a negative or non-overlapping window, a switch to the fixed hop, or the run
+    // reaching MAX_EVENT_RUN_MS). Runs of sustained sound therefore still yield an event regularly.
+    private fun segment(frame: WindowFrame, positive: Boolean, confidence: Float, tier: LoadGovernor.Tier) {
+        val adaptive = frame.config.adaptiveHop
+        val held = heldEvent
+        if (held != null && (!positive || !adaptive || frame.startSample > runEndSample ||
+                    frame.startSample + frame.length - runStartSample > maxEventRunSamples)
+        ) {
+            heldEvent = null
+            queueEvent(held)
+        }
+        if (!positive) return
+
+        if (!adaptive) {
+            // pendingEvent is only taken here when the held event of an adaptive run just went into it;
+            // hold this one instead, outside any run, and let the next window (or stopPipeline) queue it
+            val event = createEvent(frame, confidence, tier)
+            if (pendingEvent == null) {
+                queueEvent(event)
+            } else {
+                heldEvent = event
+                runEndSample = -1L
+            }
+            return
+        }
+        val current = heldEvent
+        if (current == null) {
+            runStartSample = frame.startSample
+            heldEvent = createEvent(frame, confidence, tier)
+        } else if (confidence > current.confidence) {
+            current.audioData?.let { audioBufferPool.release(it) }
+            heldEvent = createEvent(frame, confidence, tier)
+        }
+        runEndSample = frame.startSample + frame.length - 1
+    }
+
+    private fun createEvent(frame: WindowFrame, confidence: Float, tier: LoadGovernor.Tier): AudioEvent {
+        // Pass a pooled copy of the audio data that was used for detection
+        val eventAudio = audioBufferPool.acquire()
+        frame.samples.copyInto(eventAudio, 0, 0, frame.length)
+        val detectedNanos = System.nanoTime()
+        return AudioEvent(
+            type = AudioEventType.COUGH_DETECTED,
+            confidence = confidence,
+            amplitude = telemetry.getAudioLevel(),
+            // Wall-clock time the window's first sample was captured, not the time of detection
+            timestamp = System.currentTimeMillis() - (detectedNanos - frame.startNanos) / 1_000_000L,
+            audioData = eventAudio, // 使用实际检测的音频数据
+            tier = tier,
+            startSample = frame.startSample,
+            endSample = frame.startSample + frame.length - 1,
+            startNanos = frame.startNanos,
+            endNanos = frame.endNanos,
+            detectedNanos = detectedNanos
+        )
+    }
+
+    private fun queueEvent(event: AudioEvent) {
+        if (eventQueue.offer(event)) {
+            dispatchStage.wake()
+        } else {
+            // Events are never dropped: hold this one and stop taking windows until it fits
+            pipelineStats.recordBlocked(PipelineStats.Queue.EVENTS)
+            pendingEvent = event
+        }
+    }
+
+    // Switch detector parameters and the event buffer size with the first window cut under [next]
+    private fun applyScoringConfig(next: EngineConfig) {
+        tensorFlowDetector.setConfig(next.coughThreshold, next.rules)
+        val windowSize = (sampleRate * next.windowMs) / 1000
+        if (windowSize != audioBufferPool.bufferSize) {
+            audioBufferPool = AudioBufferPool(windowSize, AUDIO_EVENT_POOL_SIZE)
+        }
+        if (next.governor != governor.config) {
+            // 新的调节参数从完整检测重新开始
+            resetGovernor(next.governor)
+        }
+        scoringConfig = next
+    }
+
+    // 没有模型时完整检测跑的就是规则检测，规则档和完整档没有区别，不作为单独的一档
+    private fun resetGovernor(governorConfig: LoadGovernor.Config) {
+        val previous = governor.tier
+        governor = LoadGovernor(governorConfig, rulesTier = tensorFlowDetector.isModelLoaded())
+        if (governor.tier != previous) {
+            onTierChanged(-1f)
+        }
+    }
+
+    // [load] is the smoothed load that triggered the switch, negative if it was not load-driven
+    private fun onTierChanged(load: Float) {
+        val tier = governor.tier
+        pipelineStats.recordTierSwitch(tier)
+        _detectionTier.value = tier
+        if (load >= 0f) {
+            Log.i(TAG, "⚖️ 检测负载 ${String.format("%.2f", load)}，切换到 $tier 档")
+        } else {
+            Log.i(TAG, "⚖️ 检测档位切换到 $tier 档")
+        }
+    }
+
+    // Dispatch stage: deliver detected events to the state flow and the listener, in order
+    private fun runDispatch(): Long {
+        val event = eventQueue.poll() ?: return STAGE_IDLE_WAIT_NANOS
+        // Room for an event the scoring stage may be holding
+        scoringStage.wake()
+        val start = System.nanoTime()
+        dispatchEvent(event)
+        pipelineStats.recordStage(PipelineStats.Stage.DISPATCH, System.nanoTime() - start)
+        return 0L
     }
 
     // Check if recording
     fun isRecording(): Boolean {
-        return engineState.value == EngineState.RECORDING
+        return telemetry.getState() == EngineState.RECORDING
     }
 
     // Check if paused
     fun isPaused(): Boolean {
-        return engineState.value == EngineState.PAUSED
+        return telemetry.getState() == EngineState.PAUSED
     }
 
     // Check if processing
     fun isProcessing(): Boolean {
-        return engineState.value == EngineState.PROCESSING
+        return telemetry.getState() == EngineState.PROCESSING
     }
 
     fun getError(): String? {
@@ -0,0 +1,103 @@
+package org.voiddog.coughdetect.engine
+
+import kotlin.math.sqrt
+
+/**
+ * 低功耗监听模式下的能量/起始点检测
+ *
+ * 只在抽取后的音频上计算每块的 RMS（每 [Config.decimation] 个样本取一个，估计能量不需要抗混叠），
+ * 并以慢速指数平均跟踪背景噪声。某块的 RMS 同时超过噪声的 [Config.onsetRatio] 倍和
+ * [Config.minRms] 时视为有活动，进入激活状态；连续 [Config.quietPeriodMs] 没有活动后退回监听。
+ *
+ * 由录音线程调用 process，[isActive] 可在任意线程读取。
+ */
+class EnergyGate(
+    private val sampleRate: Int,
+    private val config: Config = Config()
+) {
+
+    data class Config(
+        val decimation: Int = 4,
+        val onsetRatio: Float = 3f,
+        val minRms: Float = 0.02f,
+        val quietPeriodMs: Long = 5000L,
+        // 每块更新背景噪声的比例
+        val floorAdaptation: Float = 0.05f
+    )
+
+    private val quietPeriodSamples = sampleRate * config.quietPeriodMs / 1000
+
+    private var noiseFloor = -1f
+    private var samplesSinceActivity = 0L
+
+    @Volatile
+    var isActive = false
+        private set
+
+    /**
+     * 最近一块的 RMS，便于调试和标定阈值
+     */
+    @Volatile
+    var lastRms = 0f
+        private set
+
+    fun process(samples: FloatArray, offset: Int, length: Int): Boolean {
+        if (length <= 0) return isActive
+        var sum = 0.0
+        var count = 0
+        var i = offset
+        val end = offset + length
+        while (i < end) {
+            val value = samples[i]
+            sum += value * value
+            count++
+            i += config.decimation
+        }
+        return update(sqrt(sum / count).toFloat(), length)
+    }
+
+    fun process(samples: ShortArray, offset: Int, length: Int): Boolean {
+        if (length <= 0) return isActive
+        var sum = 0L
+        var count = 0
+        var i = offset
+        val end = offset + length
+        while (i < end) {
+            val value = samples[i].toLong()
+            sum += value * value
+            count++
+            i += config.decimation
+        }
+        return update((sqrt(sum.toDouble() / count) / 32768.0).toFloat(), length)
+    }
+
+    fun reset() {
+        noiseFloor = -1f
+        samplesSinceActivity = 0L
+        isActive = false
+        lastRms = 0f
+    }
+
+    private fun update(rms: Float, length: Int): Boolean {
+        lastRms = rms
+        if (noiseFloor < 0f) {
+            noiseFloor = rms
+        }
+
+        val activity = rms >= config.minRms && rms >= noiseFloor * config.onsetRatio
+        if (activity) {
+            // 持续变吵的环境（比如开了风扇）也要慢慢跟上，否则会一直停在激活状态
+            noiseFloor += config.floorAdaptation * 0.1f * (rms - noiseFloor)
+            samplesSinceActivity = 0L
+            isActive = true
+        } else {
+            // 背景噪声主要由安静的块决定，活动期间只以十分之一的速度跟随
+            noiseFloor += config.floorAdaptation * (rms - noiseFloor)
+            samplesSinceActivity += length
+            if (isActive && samplesSinceActivity >= quietPeriodSamples) {
+                isActive = false
+            }
+        }
+        return isActive
+    }
+}
@@ -0,0 +1,115 @@
+package org.voiddog.coughdetect.engine
+
+import org.voiddog.coughdetect.ml.RuleBasedDetector
+
+/**
+ * 检测引擎的可调参数
+ *
+ * 通过 [CoughDetectEngine.setConfig] 设置。录音过程中新配置在下一个窗口边界整体生效，
+ * 不需要重启音频流，也不会丢失已缓冲的音频。默认值即原来写死在引擎和检测器中的参数。
+ */
+data class EngineConfig(
+    // 检测窗口长度和相邻窗口的重叠（关闭自适应步长时使用）
+    val windowMs: Int = 1000,
+    val overlapMs: Int = 200,
+    // 自适应步长：安静或平稳噪声时用粗步长（不超过窗口长度，不留空隙），
+    // 能量门限检测到起始点或能量上升时改用细步长，提高时间精度
+    val adaptiveHop: Boolean = true,
+    val fineHopMs: Int = 100,
+    val coarseHopMs: Int = 1000,
+    val activityGate: EnergyGate.Config = EnergyGate.Config(quietPeriodMs = 1000L),
+    // 模型输出的咳嗽概率超过该值判为咳嗽
+    val coughThreshold: Float = 0.5f,
+    // 判为咳嗽且置信度不低于该值时才上报事件
+    val minConfidence: Float = 0.6f,
+    // 没有模型时规则检测的阈值和特征权重
+    val rules: RuleBasedDetector.Config = RuleBasedDetector.Config(),
+    // 低功耗监听的能量门限和唤醒前保留的音频
+    val energyGate: EnergyGate.Config = EnergyGate.Config(),
+    val preRollMs: Int = 500,
+    // 低功耗监听时分帧阶段的轮询周期
+    val lowPowerPollMs: Long = 100L,
+    // 打分跟不上时窗口队列满了怎么办
+    val overloadPolicy: OverloadPolicy = OverloadPolicy.BLOCK,
+    // 窗口最后一个样本采集之后多久必须出检测结果；来不及完整打分的窗口只做粗略判定，检测延迟因此有上界
+    val deadlineMs: Int = 1500,
+    // 按 CPU 余量在完整检测、只用规则、只用能量筛查三档之间切换
+    val governor: LoadGovernor.Config = LoadGovernor.Config()
+) {
+
+    enum class OverloadPolicy {
+        // 分帧暂停，音频留在历史缓冲区里；缓冲区也满了才由音频线程丢弃最旧的样本（计入 samplesDropped）
+        BLOCK,
+        // 丢弃队列中最旧的窗口，保证检测跟上实时音频
+        DROP_OLDEST
+    }
+
+    companion object {
+        // 历史缓冲区按最长窗口分配，运行时调整窗口不需要重新分配
+        const val MAX_WINDOW_MS = 2000
+        const val MIN_WINDOW_MS = 250
+
+        /**
+         * 按灵敏度（0 最不灵敏，1 最灵敏，0.5 为默认参数）生成配置：
+         * 灵敏度越高，上报所需的置信度和规则检测的能量阈值越低
+         */
+        fun forSensitivity(sensitivity: Float, base: EngineConfig = EngineConfig()): EngineConfig {
+            val s = sensitivity.coerceIn(0f, 1f)
+            // 0.5 时系数为 1，两端分别放大/缩小一倍
+            val scale = if (s >= 0.5f) 1f - (s - 0.5f) else 1f + (0.5f - s) * 2f
+            return base.copy(
+                minConfidence = (base.minConfidence + (0.5f - s) * 0.4f).coerceIn(0.3f, 0.9f),
+                rules = base.rules.copy(
+                    loudRmsThreshold = base.rules.loudRmsThreshold * scale,
+                    moderateRmsThreshold = base.rules.moderateRmsThreshold * scale
+                )
+            )
+        }
+    }
+
+    /**
+     * 检查参数是否合法，返回错误描述，合法时返回空列表
+     */
+    fun validate(): List<String> {
+        val errors = ArrayList<String>()
+        if (windowMs !in MIN_WINDOW_MS..MAX_WINDOW_MS) {
+            errors.add("窗口长度 ${windowMs}ms 超出范围 $MIN_WINDOW_MS..$MAX_WINDOW_MS")
+        }
+        if (overlapMs < 0 || overlapMs >= windowMs) {
+            errors.add("窗口重叠 ${overlapMs}ms 必须在 0 和窗口长度之间")
+        }
+        if (fineHopMs <= 0 || fineHopMs > windowMs || coarseHopMs < fineHopMs) {
+            errors.add("步长 ${fineHopMs}ms/${coarseHopMs}ms 不合法：细步长必须在 0 和窗口长度之间，粗步长不小于细步长")
+        }
+        if (coughThreshold !in 0f..1f) {
+            errors.add("咳嗽阈值 $coughThreshold 必须在 0..1 之间")
+        }
+        if (minConfidence !in 0f..1f) {
+            errors.add("最小置信度 $minConfidence 必须在 0..1 之间")
+        }
+        if (rules.loudRmsThreshold <= 0f || rules.moderateRmsThreshold <= 0f || rules.zeroCrossingThreshold < 0f) {
+            errors.add("规则检测阈值必须为正数")
+        }
+        for (gate in listOf(energyGate, activityGate)) {
+            if (gate.decimation < 1 || gate.onsetRatio < 1f || gate.quietPeriodMs <= 0L) {
+                errors.add("能量门限参数不合法")
+                break
+            }
+        }
+        if (preRollMs < 0 || preRollMs >= windowMs) {
+            errors.add("预卷 ${preRollMs}ms 必须在 0 和窗口长度之间")
+        }
+        if (deadlineMs <= 0) {
+            errors.add("截止时间 ${deadlineMs}ms 必须为正数")
+        }
+        if (governor.upgradeLoad <= 0f || governor.degradeLoad <= governor.upgradeLoad ||
+            governor.smoothing !in 0.01f..1f || governor.probeWindows < 1 || governor.maxProbeWindows < governor.probeWindows
+        ) {
+            errors.add("负载调节参数不合法：降档负载必须高于升档负载")
+        }
+        if (lowPowerPollMs <= 0L) {
+            errors.add("轮询周期必须为正数")
+        }
+        return errors
+    }
+}
@@ -0,0 +1,188 @@
+package org.voiddog.coughdetect.engine
+
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * 引擎遥测数据块
+ *
+ * 录音线程和检测线程写入，UI 以 [org.voiddog.coughdetect.utils.Constants.UI.AUDIO_LEVEL_UPDATE_INTERVAL_MS]
+ * 的间隔轮询读取。多字段快照通过 seqlock 保证一致性：写者把序号置为奇数后修改字段，
+ * 写完再置回偶数；读者在前后两次读到相同的偶数序号时才接受快照。
+ * 单字段读取（电平、状态、就绪）只是一次 volatile 读，不需要重试。
+ *
+ * 字段按写者分成两组，各有一个序号：电平、丢弃和中断计数只由录音线程写入，单写者直接递增序号，
+ * 音频线程上的写入不会等待其他线程；其余字段由检测、分发和控制线程写入，写者之间用 CAS 串行化。
+ * 录音线程的字段只在采集停止后（[reset]、停止时清零电平）才由其他线程改写。
+ */
+class EngineTelemetry {
+
+    data class Snapshot(
+        val audioLevel: Float,
+        val state: CoughDetectEngine.EngineState,
+        val isReady: Boolean,
+        val windowsProcessed: Long,
+        val eventsEmitted: Long,
+        val samplesDropped: Long,
+        val gapCount: Long,
+        val samplesLost: Long,
+        val windowsSkipped: Long,
+        val deadlineMisses: Long,
+        val lastInferenceTimeUs: Long
+    )
+
+    companion object {
+        private val STATES = CoughDetectEngine.EngineState.values()
+    }
+
+    // 录音线程独占写入的字段的序号
+    private val captureSequence = AtomicLong(0L)
+    // 检测、分发和控制线程写入的字段的序号
+    private val sequence = AtomicLong(0L)
+
+    @Volatile private var audioLevel = 0f
+    @Volatile private var state = CoughDetectEngine.EngineState.IDLE.ordinal
+    @Volatile private var ready = false
+    @Volatile private var windowsProcessed = 0L
+    @Volatile private var eventsEmitted = 0L
+    @Volatile private var samplesDropped = 0L
+    @Volatile private var gapCount = 0L
+    @Volatile private var samplesLost = 0L
+    @Volatile private var windowsSkipped = 0L
+    @Volatile private var deadlineMisses = 0L
+    @Volatile private var lastInferenceTimeUs = 0L
+
+    fun getAudioLevel(): Float = audioLevel
+
+    fun getState(): CoughDetectEngine.EngineState = STATES[state]
+
+    fun isReady(): Boolean = ready
+
+    // 单字段读取不分配对象，适合在循环中轮询；需要多个字段一致时用 snapshot()
+    fun getWindowsProcessed(): Long = windowsProcessed
+
+    fun getSamplesDropped(): Long = samplesDropped
+
+    // 采集中断（断开重连）丢失的样本，和缓冲区溢出丢弃的 samplesDropped 分开统计
+    fun getSamplesLost(): Long = samplesLost
+
+    fun getGapCount(): Long = gapCount
+
+    // 来不及完整打分、只做了粗略判定的窗口（也计入 windowsProcessed）；
+    // 截止时间前没有完整结果的窗口，包括这些粗略判定的和完整打分超时的
+    fun getWindowsSkipped(): Long = windowsSkipped
+
+    fun getDeadlineMisses(): Long = deadlineMisses
+
+    fun updateAudioLevel(level: Float) = writeCapture {
+        audioLevel = level
+    }
+
+    fun updateState(newState: CoughDetectEngine.EngineState) = write {
+        state = newState.ordinal
+    }
+
+    fun updateReady(isReady: Boolean) = write {
+        ready = isReady
+    }
+
+    fun recordWindow(inferenceTimeUs: Long) = write {
+        windowsProcessed++
+        lastInferenceTimeUs = inferenceTimeUs
+    }
+
+    fun recordSkippedWindow() = write {
+        windowsProcessed++
+        windowsSkipped++
+        deadlineMisses++
+    }
+
+    fun recordDeadlineMiss() = write {
+        deadlineMisses++
+    }
+
+    fun recordEvent() = write {
+        eventsEmitted++
+    }
+
+    fun recordDroppedSamples(count: Int) = writeCapture {
+        samplesDropped += count
+    }
+
+    fun recordGap(lostSamples: Long) = writeCapture {
+        gapCount++
+        samplesLost += lostSamples
+    }
+
+    // 只在采集停止时调用
+    fun reset() {
+        writeCapture {
+            audioLevel = 0f
+            samplesDropped = 0L
+            gapCount = 0L
+            samplesLost = 0L
+        }
+        write {
+            windowsProcessed = 0L
+            eventsEmitted = 0L
+            windowsSkipped = 0L
+            deadlineMisses = 0L
+            lastInferenceTimeUs = 0L
+        }
+    }
+
+    /**
+     * 读取一致的快照，写者正在写入时自旋重试
+     */
+    fun snapshot(): Snapshot {
+        while (true) {
+            val captureBefore = captureSequence.get()
+            val before = sequence.get()
+            if ((captureBefore or before) and 1L != 0L) {
+                Thread.yield()
+                continue
+            }
+            val snapshot = Snapshot(
+                audioLevel = audioLevel,
+                state = STATES[state],
+                isReady = ready,
+                windowsProcessed = windowsProcessed,
+                eventsEmitted = eventsEmitted,
+                samplesDropped = samplesDropped,
+                gapCount = gapCount,
+                samplesLost = samplesLost,
+                windowsSkipped = windowsSkipped,
+                deadlineMisses = deadlineMisses,
+                lastInferenceTimeUs = lastInferenceTimeUs
+            )
+            if (captureSequence.get() == captureBefore && sequence.get() == before) {
+                return snapshot
+            }
+        }
+    }
+
+    // 录音线程只有一个写者，不需要抢占序号
+    private inline fun writeCapture(block: () -> Unit) {
+        captureSequence.incrementAndGet()
+        try {
+            block()
+        } finally {
+            captureSequence.incrementAndGet()
+        }
+    }
+
+    // 检测、分发和控制线程都会写入，用 CAS 抢占奇数序号来串行化写者；录音线程从不在这里等待
+    private inline fun write(block: () -> Unit) {
+        while (true) {
+            val seq = sequence.get()
+            if (seq and 1L == 0L && sequence.compareAndSet(seq, seq + 1)) {
+                break
+            }
+            Thread.yield()
+        }
+        try {
+            block()
+        } finally {
+            sequence.incrementAndGet()
+        }
+    }
+}
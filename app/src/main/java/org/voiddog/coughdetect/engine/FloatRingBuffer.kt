@@ -0,0 +1,78 @@
+package org.voiddog.coughdetect.engine
+
+/**
+ * 固定容量的 float 环形缓冲区
+ *
+ * 替代引擎原来的 MutableList<Float>：样本不装箱，写入和取窗口都是数组拷贝，
+ * 容量在构造时一次分配，稳态下不产生任何内存分配。写满时丢弃最旧的样本。
+ *
+ * 非线程安全，由调用方加锁。
+ */
+class FloatRingBuffer(override val capacity: Int) : SampleRingBuffer {
+
+    private val data = FloatArray(capacity)
+    private var head = 0 // 最旧样本的位置
+
+    override var size = 0
+        private set
+
+    override val bytesPerSample: Int
+        get() = 4
+
+    /**
+     * 追加 [length] 个样本，空间不足时覆盖最旧的样本，返回被丢弃的样本数
+     */
+    override fun write(source: FloatArray, offset: Int, length: Int): Int {
+        var sourceOffset = offset
+        var count = length
+        var dropped = 0
+        if (count > capacity) {
+            // 只保留最后 capacity 个样本
+            dropped += count - capacity
+            sourceOffset += count - capacity
+            count = capacity
+        }
+        val overflow = size + count - capacity
+        if (overflow > 0) {
+            discard(overflow)
+            dropped += overflow
+        }
+
+        var tail = head + size
+        if (tail >= capacity) tail -= capacity
+        val firstPart = minOf(count, capacity - tail)
+        System.arraycopy(source, sourceOffset, data, tail, firstPart)
+        if (count > firstPart) {
+            System.arraycopy(source, sourceOffset + firstPart, data, 0, count - firstPart)
+        }
+        size += count
+        return dropped
+    }
+
+    /**
+     * 复制最旧的 [count] 个样本到 [target]，不移除
+     */
+    override fun peek(target: FloatArray, targetOffset: Int, count: Int) {
+        require(count <= size) { "peek $count of $size" }
+        val firstPart = minOf(count, capacity - head)
+        System.arraycopy(data, head, target, targetOffset, firstPart)
+        if (count > firstPart) {
+            System.arraycopy(data, 0, target, targetOffset + firstPart, count - firstPart)
+        }
+    }
+
+    /**
+     * 移除最旧的 [count] 个样本
+     */
+    override fun discard(count: Int) {
+        val removed = minOf(count, size)
+        head += removed
+        if (head >= capacity) head -= capacity
+        size -= removed
+    }
+
+    override fun clear() {
+        head = 0
+        size = 0
+    }
+}
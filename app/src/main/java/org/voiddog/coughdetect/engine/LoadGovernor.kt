@@ -0,0 +1,114 @@
+package org.voiddog.coughdetect.engine
+
+/**
+ * 按 CPU 余量在检测档位之间切换
+ *
+ * 每个完整打分的窗口记录一次负载：打分耗时除以这个窗口的步长对应的实时时长（下一个窗口到来之前的预算）。
+ * 各档位的负载分别做指数平均；当前档位的平滑负载超过 [Config.degradeLoad] 降一档。
+ * 降档后每隔一段窗口用上一档试探一个窗口，负载低于 [Config.upgradeLoad] 才升档，
+ * 试探失败则间隔加倍，所以在两个阈值之间的负载不会来回切换。
+ *
+ * 没有模型时完整检测跑的就是规则检测，[rulesTier] 为 false 时跳过规则档，直接在完整检测和能量筛查之间切换。
+ *
+ * 只由打分阶段调用 [nextTier] 和 [onWindow]；[tier] 和 [loadOf] 可在任意线程读取。
+ */
+class LoadGovernor(val config: Config = Config(), val rulesTier: Boolean = true) {
+
+    enum class Tier {
+        // 模型（没有模型时为规则检测），含频谱特征
+        FULL,
+        // 只用规则检测，不经过模型
+        RULES,
+        // 只做抽样能量筛查，通过的窗口才跑规则检测
+        ENERGY
+    }
+
+    data class Config(
+        val enabled: Boolean = true,
+        // 当前档位的平滑负载超过该值降一档
+        val degradeLoad: Float = 0.7f,
+        // 试探上一档时负载低于该值才升档
+        val upgradeLoad: Float = 0.35f,
+        // 负载指数平均的系数
+        val smoothing: Float = 0.2f,
+        // 降档后多少个窗口试探一次上一档；试探失败则加倍，最多 maxProbeWindows
+        val probeWindows: Int = 50,
+        val maxProbeWindows: Int = 1600
+    )
+
+    companion object {
+        private val TIERS = Tier.values()
+        // 进入一个档位后至少打分这么多窗口才会再降档
+        private const val MIN_WINDOWS_BEFORE_DEGRADE = 3
+    }
+
+    // 可用的档位，从高到低
+    private val tiers = if (rulesTier) TIERS else arrayOf(Tier.FULL, Tier.ENERGY)
+    // 各档位的平滑负载，负数表示还没有测量过
+    private val loads = FloatArray(TIERS.size) { -1f }
+    private var windowsAtTier = 0
+    private var probeInterval = config.probeWindows
+    private var probing = false
+
+    @Volatile
+    var tier = Tier.FULL
+        private set
+
+    /**
+     * 下一个窗口用哪一档打分；到了试探时间返回上一档
+     */
+    fun nextTier(): Tier {
+        val current = tier
+        if (!config.enabled || current == Tier.FULL || windowsAtTier < probeInterval) {
+            return current
+        }
+        probing = true
+        return tiers[tiers.indexOf(current) - 1]
+    }
+
+    /**
+     * 记录按 [used] 档打分的一个窗口，耗时 [costNanos]，实时预算 [budgetNanos]；档位变化时返回 true
+     */
+    fun onWindow(used: Tier, costNanos: Long, budgetNanos: Long): Boolean {
+        if (!config.enabled || budgetNanos <= 0L) return false
+        val load = costNanos.toFloat() / budgetNanos
+        val i = used.ordinal
+        // 新档位从 0 开始平均：需要连续几个慢窗口才会降档，单个慢窗口（比如首次推理的预热）不会
+        val previous = maxOf(loads[i], 0f)
+        loads[i] = previous + config.smoothing * (load - previous)
+
+        if (probing) {
+            probing = false
+            windowsAtTier = 0
+            // 升档只看这一次试探：这一档的平滑负载还停留在降档时的高位
+            if (load < config.upgradeLoad) {
+                loads[i] = load
+                probeInterval = config.probeWindows
+                tier = used
+                return true
+            }
+            probeInterval = minOf(probeInterval * 2, config.maxProbeWindows)
+            return false
+        }
+
+        windowsAtTier++
+        val current = tier
+        if (used == current && current != Tier.ENERGY &&
+            windowsAtTier >= MIN_WINDOWS_BEFORE_DEGRADE && loads[i] > config.degradeLoad
+        ) {
+            windowsAtTier = 0
+            probeInterval = config.probeWindows
+            // 下一档按新的测量重新平均，不沿用可能早已过时的值
+            val next = tiers[tiers.indexOf(current) + 1]
+            loads[next.ordinal] = -1f
+            tier = next
+            return true
+        }
+        return false
+    }
+
+    /**
+     * [tier] 档最近的平滑负载，没有测量过时为负数
+     */
+    fun loadOf(tier: Tier): Float = loads[tier.ordinal]
+}
@@ -0,0 +1,118 @@
+package org.voiddog.coughdetect.engine
+
+import android.os.Debug
+import android.util.Log
+import org.voiddog.coughdetect.utils.ThreadPlacement
+import java.util.concurrent.locks.LockSupport
+
+/**
+ * 检测流水线的一个阶段，运行在自己的线程上
+ *
+ * 线程循环调用 [work]：返回 0 表示可能还有待处理的数据，立即再调用；否则返回最多等待的纳秒数，
+ * 线程挂起直到上下游调用 [wake] 或超时。挂起和唤醒基于 LockSupport 的许可，不分配对象，
+ * 唤醒先于挂起发生也不会丢失。每次调用消耗的线程 CPU 时间记到 [powerMeter] 上。
+ * 线程启动时按 [role] 设置优先级（见 [ThreadPlacement]），并记录挂起后被唤醒的次数。
+ */
+class PipelineStage(
+    private val name: String,
+    private val role: ThreadPlacement.Role,
+    private val powerMeter: PowerMeter?,
+    private val onError: (Exception) -> Unit,
+    private val work: Work
+) {
+
+    fun interface Work {
+        fun run(): Long
+    }
+
+    companion object {
+        private const val TAG = "PipelineStage"
+        private const val ERROR_BACKOFF_NANOS = 1_000_000_000L // Wait before retrying after an exception
+    }
+
+    @Volatile
+    private var thread: Thread? = null
+    @Volatile
+    private var running = false
+    @Volatile
+    private var wakeups = 0L
+
+    val isRunning: Boolean
+        get() = running
+
+    /**
+     * 上次 [stop] 超时、线程还在执行最后一次 [work]；这期间不能重新 [start]
+     */
+    val isStopping: Boolean
+        get() = !running && thread?.isAlive == true
+
+    fun getThread(): Thread? = thread
+
+    fun getWakeups(): Long = wakeups
+
+    /**
+     * 启动线程，已经在运行时什么也不做。上次停止的线程还没有退出时返回 false，
+     * 不会再起一个线程和它同时运行
+     */
+    fun start(): Boolean {
+        val previous = thread
+        if (previous != null && previous.isAlive) {
+            if (running) return true
+            Log.w(TAG, "⚠️ $name 上一个线程还没有退出，不能重新启动")
+            return false
+        }
+        running = true
+        thread = Thread({ loop() }, name).apply {
+            isDaemon = true
+            start()
+        }
+        return true
+    }
+
+    fun wake() {
+        thread?.let { LockSupport.unpark(it) }
+    }
+
+    /**
+     * 停止并等待线程退出（最多 [timeoutMs]），正在进行的一次 [work] 会执行完。
+     * 返回线程是否已经退出；没有退出时保留线程引用，直到它退出之前 [start] 都会拒绝
+     */
+    fun stop(timeoutMs: Long): Boolean {
+        val current = thread ?: return true
+        running = false
+        LockSupport.unpark(current)
+        if (current === Thread.currentThread()) {
+            // 在自己的线程上停止：这次 work 返回后循环结束
+            return false
+        }
+        try {
+            current.join(timeoutMs)
+        } catch (e: InterruptedException) {
+            Thread.currentThread().interrupt()
+        }
+        if (current.isAlive) {
+            Log.w(TAG, "⚠️ $name 未能在 ${timeoutMs}ms 内退出")
+            return false
+        }
+        thread = null
+        return true
+    }
+
+    private fun loop() {
+        ThreadPlacement.apply(role)
+        while (running) {
+            val cpuStart = Debug.threadCpuTimeNanos()
+            val waitNanos = try {
+                work.run()
+            } catch (e: Exception) {
+                onError(e)
+                ERROR_BACKOFF_NANOS
+            }
+            powerMeter?.addCpu(Debug.threadCpuTimeNanos() - cpuStart)
+            if (waitNanos > 0 && running) {
+                LockSupport.parkNanos(this, waitNanos)
+                wakeups++
+            }
+        }
+    }
+}
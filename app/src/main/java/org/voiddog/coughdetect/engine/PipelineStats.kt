@@ -0,0 +1,244 @@
+package org.voiddog.coughdetect.engine
+
+import org.voiddog.coughdetect.audio.StreamHealth
+import java.util.concurrent.atomic.AtomicLongArray
+
+/**
+ * 检测流水线各阶段的耗时和各队列的状态
+ *
+ * 每个阶段记录处理次数、总耗时、最大耗时和耗时直方图（桶和 [StreamHealth] 相同）；
+ * 每个队列记录当前深度、最高水位、因 DROP_OLDEST 丢弃的窗口数，以及因 BLOCK 让上游等待的次数。
+ * 另外记录每个窗口从最后一个样本采集到出结果的检测延迟，每个事件从采集到检测、到分发的延迟
+ * （按采样时钟换算的采集时刻），以及 [LoadGovernor] 的当前档位、切换次数和各档位完整打分的窗口数。
+ * 各阶段线程无锁写入，任意线程读取；[snapshot] 各字段之间不保证严格一致。
+ */
+class PipelineStats(private val queues: Array<BoundedQueue<*>>) {
+
+    enum class Stage {
+        // 录音回调：写入历史缓冲区（音频线程）
+        CAPTURE,
+        // 从历史缓冲区切出窗口
+        FRAMING,
+        // 特征提取和打分，在检测器的一次调用中完成
+        SCORING,
+        // 过期窗口的粗略判定
+        COARSE_SCORING,
+        // 置信度判定和事件音频的复制
+        SEGMENTATION,
+        // 事件分发给监听者
+        DISPATCH
+    }
+
+    enum class Queue {
+        // 分帧 → 打分
+        WINDOWS,
+        // 分段 → 分发
+        EVENTS
+    }
+
+    data class StageSnapshot(
+        val stage: Stage,
+        val count: Long,
+        val totalNanos: Long,
+        val maxNanos: Long,
+        val histogram: LongArray
+    ) {
+        val meanNanos: Long
+            get() = if (count > 0) totalNanos / count else 0L
+
+        override fun equals(other: Any?): Boolean {
+            if (this === other) return true
+            if (other !is StageSnapshot) return false
+            return stage == other.stage &&
+                count == other.count &&
+                totalNanos == other.totalNanos &&
+                maxNanos == other.maxNanos &&
+                histogram.contentEquals(other.histogram)
+        }
+
+        override fun hashCode(): Int {
+            var result = stage.hashCode()
+            result = 31 * result + count.hashCode()
+            result = 31 * result + totalNanos.hashCode()
+            result = 31 * result + histogram.contentHashCode()
+            return result
+        }
+    }
+
+    data class QueueSnapshot(
+        val queue: Queue,
+        val depth: Int,
+        val capacity: Int,
+        val highWater: Int,
+        val dropped: Long,
+        val blocked: Long
+    )
+
+    data class Snapshot(
+        val bucketUpperBoundsUs: List<Long>,
+        val stages: List<StageSnapshot>,
+        val queues: List<QueueSnapshot>,
+        val maxWindowLatencyNanos: Long,
+        val windowLatencyHistogram: List<Long>,
+        val eventDetectLatencyHistogram: List<Long>,
+        val eventDispatchLatencyHistogram: List<Long>,
+        val maxEventDispatchLatencyNanos: Long,
+        val tier: LoadGovernor.Tier,
+        val tierSwitches: Long,
+        val windowsPerTier: List<Long>
+    ) {
+        fun stage(stage: Stage): StageSnapshot = stages[stage.ordinal]
+
+        fun queue(queue: Queue): QueueSnapshot = queues[queue.ordinal]
+
+        fun windows(tier: LoadGovernor.Tier): Long = windowsPerTier[tier.ordinal]
+    }
+
+    companion object {
+        private val STAGES = Stage.values()
+        private val QUEUES = Queue.values()
+        private val TIERS = LoadGovernor.Tier.values()
+
+        // 检测延迟以百毫秒计，桶另外定义
+        val LATENCY_BUCKET_UPPER_BOUNDS_US = longArrayOf(
+            50_000, 100_000, 250_000, 500_000, 1_000_000, 1_500_000, 2_000_000, 3_000_000, 5_000_000
+        )
+    }
+
+    private val histograms = Array(STAGES.size) { StreamHealth.Histogram(StreamHealth.BUCKET_UPPER_BOUNDS_US) }
+    private val counts = AtomicLongArray(STAGES.size)
+    private val totalNanos = AtomicLongArray(STAGES.size)
+    private val maxNanos = AtomicLongArray(STAGES.size)
+    private val dropped = AtomicLongArray(QUEUES.size)
+    private val blocked = AtomicLongArray(QUEUES.size)
+    private val windowLatency = StreamHealth.Histogram(LATENCY_BUCKET_UPPER_BOUNDS_US)
+    @Volatile
+    private var maxWindowLatencyNanos = 0L
+    private val eventDetectLatency = StreamHealth.Histogram(LATENCY_BUCKET_UPPER_BOUNDS_US)
+    private val eventDispatchLatency = StreamHealth.Histogram(LATENCY_BUCKET_UPPER_BOUNDS_US)
+    @Volatile
+    private var maxEventDispatchLatencyNanos = 0L
+    private val tierWindows = AtomicLongArray(TIERS.size)
+    @Volatile
+    private var tier = LoadGovernor.Tier.FULL
+    @Volatile
+    private var tierSwitches = 0L
+
+    init {
+        require(queues.size == QUEUES.size) { "one queue per PipelineStats.Queue" }
+    }
+
+    fun recordStage(stage: Stage, nanos: Long) {
+        val i = stage.ordinal
+        counts.incrementAndGet(i)
+        totalNanos.addAndGet(i, nanos)
+        // 每个阶段只有一个写者，不需要 CAS 循环
+        if (nanos > maxNanos.get(i)) {
+            maxNanos.set(i, nanos)
+        }
+        histograms[i].record(nanos / 1000)
+    }
+
+    /**
+     * 一个窗口从最后一个样本采集到打分（完整或粗略）结束经过了 [nanos]；只由打分阶段调用
+     */
+    fun recordWindowLatency(nanos: Long) {
+        if (nanos > maxWindowLatencyNanos) {
+            maxWindowLatencyNanos = nanos
+        }
+        windowLatency.record(nanos / 1000)
+    }
+
+    /**
+     * 一个事件所在窗口的最后一个样本采集之后 [detectNanos] 出了检测结果、[dispatchNanos] 交给了监听者；
+     * 只由分发阶段调用（停止时由停止流水线的线程补发剩余事件）
+     */
+    fun recordEventLatency(detectNanos: Long, dispatchNanos: Long) {
+        if (dispatchNanos > maxEventDispatchLatencyNanos) {
+            maxEventDispatchLatencyNanos = dispatchNanos
+        }
+        eventDetectLatency.record(detectNanos / 1000)
+        eventDispatchLatency.record(dispatchNanos / 1000)
+    }
+
+    /**
+     * 按 [tier] 档完整打分了一个窗口；只由打分阶段调用
+     */
+    fun recordTierWindow(tier: LoadGovernor.Tier) {
+        tierWindows.incrementAndGet(tier.ordinal)
+    }
+
+    /**
+     * 负载调节切换到了 [tier] 档；只由打分阶段调用
+     */
+    fun recordTierSwitch(tier: LoadGovernor.Tier) {
+        this.tier = tier
+        tierSwitches++
+    }
+
+    fun getTier(): LoadGovernor.Tier = tier
+
+    fun recordDrop(queue: Queue) {
+        dropped.incrementAndGet(queue.ordinal)
+    }
+
+    fun recordBlocked(queue: Queue) {
+        blocked.incrementAndGet(queue.ordinal)
+    }
+
+    fun getDropped(queue: Queue): Long = dropped.get(queue.ordinal)
+
+    fun getBlocked(queue: Queue): Long = blocked.get(queue.ordinal)
+
+    fun getDepth(queue: Queue): Int = queues[queue.ordinal].size
+
+    fun reset() {
+        for (i in STAGES.indices) {
+            counts.set(i, 0L)
+            totalNanos.set(i, 0L)
+            maxNanos.set(i, 0L)
+            histograms[i].clear()
+        }
+        for (i in QUEUES.indices) {
+            dropped.set(i, 0L)
+            blocked.set(i, 0L)
+        }
+        windowLatency.clear()
+        maxWindowLatencyNanos = 0L
+        eventDetectLatency.clear()
+        eventDispatchLatency.clear()
+        maxEventDispatchLatencyNanos = 0L
+        for (i in TIERS.indices) {
+            tierWindows.set(i, 0L)
+        }
+        tier = LoadGovernor.Tier.FULL
+        tierSwitches = 0L
+    }
+
+    fun snapshot(): Snapshot = Snapshot(
+        bucketUpperBoundsUs = StreamHealth.BUCKET_UPPER_BOUNDS_US.toList(),
+        stages = STAGES.map { stage ->
+            val i = stage.ordinal
+            StageSnapshot(stage, counts.get(i), totalNanos.get(i), maxNanos.get(i), histograms[i].counts())
+        },
+        queues = QUEUES.map { queue ->
+            val i = queue.ordinal
+            QueueSnapshot(
+                queue = queue,
+                depth = queues[i].size,
+                capacity = queues[i].capacity,
+                highWater = queues[i].highWaterMark,
+                dropped = dropped.get(i),
+                blocked = blocked.get(i)
+            )
+        },
+        maxWindowLatencyNanos = maxWindowLatencyNanos,
+        windowLatencyHistogram = windowLatency.counts().toList(),
+        eventDetectLatencyHistogram = eventDetectLatency.counts().toList(),
+        eventDispatchLatencyHistogram = eventDispatchLatency.counts().toList(),
+        maxEventDispatchLatencyNanos = maxEventDispatchLatencyNanos,
+        tier = tier,
+        tierSwitches = tierSwitches,
+        windowsPerTier = TIERS.map { tierWindows.get(it.ordinal) }
+    )
+}
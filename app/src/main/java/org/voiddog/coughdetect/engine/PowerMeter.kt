@@ -0,0 +1,99 @@
+package org.voiddog.coughdetect.engine
+
+import java.util.concurrent.atomic.AtomicLongArray
+
+/**
+ * 按运行模式累计引擎的 CPU 时间和墙钟时间，用来比较全速分析和低功耗监听每小时的 CPU 开销
+ *
+ * 录音线程和检测流水线的各阶段都会累加 CPU 时间（原子数组，无锁）；模式切换由分帧阶段完成。
+ */
+class PowerMeter {
+
+    enum class Mode {
+        // 完整的分窗检测
+        FULL,
+        // 低功耗监听：只运行能量门限
+        LISTENING
+    }
+
+    data class Usage(
+        val mode: Mode?,
+        val cpuNanos: LongArray,
+        val wallNanos: LongArray
+    ) {
+        /**
+         * [mode] 下每小时音频消耗的 CPU 秒数；该模式还没有运行过时为 0
+         */
+        fun cpuSecondsPerHour(mode: Mode): Double {
+            val wall = wallNanos[mode.ordinal]
+            return if (wall > 0) cpuNanos[mode.ordinal] / 1e9 * (3600e9 / wall) else 0.0
+        }
+
+        override fun equals(other: Any?): Boolean {
+            if (this === other) return true
+            if (other !is Usage) return false
+            return mode == other.mode &&
+                cpuNanos.contentEquals(other.cpuNanos) &&
+                wallNanos.contentEquals(other.wallNanos)
+        }
+
+        override fun hashCode(): Int {
+            var result = mode?.hashCode() ?: 0
+            result = 31 * result + cpuNanos.contentHashCode()
+            result = 31 * result + wallNanos.contentHashCode()
+            return result
+        }
+    }
+
+    private val modes = Mode.values()
+    private val cpuNanos = AtomicLongArray(modes.size)
+    private val wallNanos = AtomicLongArray(modes.size)
+
+    // 当前模式，null 表示没有在录音
+    @Volatile
+    private var current: Mode? = null
+    @Volatile
+    private var modeSince = 0L
+
+    fun getMode(): Mode? = current
+
+    /**
+     * 切换到 [mode]（null 为停止计时），把上一个模式经过的墙钟时间记上
+     */
+    fun switchTo(mode: Mode?, nowNanos: Long) {
+        val previous = current
+        if (previous == mode) return
+        if (previous != null) {
+            wallNanos.addAndGet(previous.ordinal, nowNanos - modeSince)
+        }
+        modeSince = nowNanos
+        current = mode
+    }
+
+    /**
+     * 给当前模式记上 [nanos] 的 CPU 时间
+     */
+    fun addCpu(nanos: Long) {
+        val mode = current ?: return
+        if (nanos > 0) {
+            cpuNanos.addAndGet(mode.ordinal, nanos)
+        }
+    }
+
+    fun reset() {
+        for (i in modes.indices) {
+            cpuNanos.set(i, 0L)
+            wallNanos.set(i, 0L)
+        }
+        current = null
+    }
+
+    fun usage(nowNanos: Long): Usage {
+        val mode = current
+        val wall = LongArray(modes.size) { wallNanos.get(it) }
+        if (mode != null) {
+            wall[mode.ordinal] += nowNanos - modeSince
+        }
+        return Usage(mode, LongArray(modes.size) { cpuNanos.get(it) }, wall)
+    }
+}
@@ -0,0 +1,110 @@
+package org.voiddog.coughdetect.engine
+
+/**
+ * 采样时钟：把采样时间轴上的样本序号换算成它的采集时刻（System.nanoTime 时基）
+ *
+ * 时间轴分成若干段，每段由一个锚点（某个样本的序号和采集时刻）按采样率外推。每块音频到达时，
+ * 用到达时刻减去输入延迟（由 AudioRecord.getTimestamp 推算）估计这一块最后一个样本的采集时刻：
+ * - 估计值比外推值早：回调延迟比之前见过的都小，把当前段的锚点提前（段太长时另起一段，避免时钟漂移累积到很早的样本上）；
+ * - 晚得超过 [MAX_LAG_NANOS]：采集中断或时钟漂移，从这一块开始另起一段；
+ * - 其余的偏差是回调调度的抖动，忽略。
+ * 调整锚点时不早于上一段的末尾，所以采集时刻随序号单调递增，也不随回调时机抖动。
+ *
+ * 保留最近 [MAX_SEGMENTS] 段，跨越采集中断的窗口的第一个样本仍然按中断前的那段换算。
+ * 不是线程安全的，由调用方加锁；[onChunk] 和 [captureNanosAt] 都不分配内存。
+ */
+class SampleClock(private val sampleRate: Int) {
+
+    companion object {
+        const val MAX_LAG_NANOS = 20_000_000L
+        private const val MAX_SEGMENTS = 16
+        private const val MAX_SEGMENT_SECONDS = 10
+    }
+
+    private val maxSegmentSamples = sampleRate.toLong() * MAX_SEGMENT_SECONDS
+
+    // 每段的锚点（样本序号和采集时刻）和这一段的第一个样本，环形保存
+    private val anchorIndex = LongArray(MAX_SEGMENTS)
+    private val anchorNanos = LongArray(MAX_SEGMENTS)
+    private val segmentStart = LongArray(MAX_SEGMENTS)
+    private var segments = 0
+    private var newest = -1
+
+    val segmentCount: Int
+        get() = segments
+
+    fun reset() {
+        segments = 0
+        newest = -1
+    }
+
+    /**
+     * 序号 [end] - [length] 到 [end] - 1 的样本刚刚到达，估计最后一个样本在 [estimatedNanos] 采集
+     */
+    fun onChunk(end: Long, length: Int, estimatedNanos: Long) {
+        if (length <= 0) return
+        val last = end - 1
+        if (newest < 0) {
+            addSegment(end - length, last, estimatedNanos)
+            return
+        }
+        val lag = estimatedNanos - extrapolate(newest, last)
+        if (lag > MAX_LAG_NANOS) {
+            addSegment(end - length, last, estimatedNanos)
+        } else if (lag < 0L) {
+            if (last - segmentStart[newest] > maxSegmentSamples) {
+                addSegment(end - length, last, estimatedNanos)
+            } else {
+                anchorIndex[newest] = last
+                anchorNanos[newest] = estimatedNanos
+                clampToPrevious()
+            }
+        }
+    }
+
+    /**
+     * 序号为 [index] 的样本的采集时刻；还没有锚点时返回 0
+     */
+    fun captureNanosAt(index: Long): Long {
+        if (newest < 0) return 0L
+        var slot = newest
+        for (i in 0 until segments) {
+            if (segmentStart[slot] <= index) {
+                return extrapolate(slot, index)
+            }
+            slot = previous(slot)
+        }
+        // 比保留的段都早，用最旧的一段外推
+        return extrapolate(next(slot), index)
+    }
+
+    private fun extrapolate(slot: Int, index: Long): Long {
+        return anchorNanos[slot] + (index - anchorIndex[slot]) * 1_000_000_000L / sampleRate
+    }
+
+    private fun addSegment(start: Long, index: Long, nanos: Long) {
+        newest = next(newest)
+        anchorIndex[newest] = index
+        anchorNanos[newest] = nanos
+        segmentStart[newest] = start
+        if (segments < MAX_SEGMENTS) {
+            segments++
+        }
+        clampToPrevious()
+    }
+
+    // 最新一段的第一个样本不能早于上一段的最后一个样本
+    private fun clampToPrevious() {
+        if (segments < 2) return
+        val start = segmentStart[newest]
+        val floor = extrapolate(previous(newest), start - 1) + 1
+        val startNanos = extrapolate(newest, start)
+        if (startNanos < floor) {
+            anchorNanos[newest] += floor - startNanos
+        }
+    }
+
+    private fun next(slot: Int): Int = (slot + 1) % MAX_SEGMENTS
+
+    private fun previous(slot: Int): Int = (slot - 1 + MAX_SEGMENTS) % MAX_SEGMENTS
+}
@@ -0,0 +1,35 @@
+package org.voiddog.coughdetect.engine
+
+/**
+ * 引擎历史缓冲区的公共接口
+ *
+ * 对外始终以 float 写入和取窗口；实现可以用 float（[FloatRingBuffer]）或
+ * 16-bit PCM（[ShortRingBuffer]）存储，后者在分析边界才转换成 float。
+ * 写满时丢弃最旧的样本。非线程安全，由调用方加锁。
+ */
+interface SampleRingBuffer {
+
+    val capacity: Int
+
+    val size: Int
+
+    /** 每个样本占用的字节数 */
+    val bytesPerSample: Int
+
+    /**
+     * 追加 [length] 个样本，空间不足时覆盖最旧的样本，返回被丢弃的样本数
+     */
+    fun write(source: FloatArray, offset: Int = 0, length: Int = source.size - offset): Int
+
+    /**
+     * 复制最旧的 [count] 个样本到 [target]，不移除
+     */
+    fun peek(target: FloatArray, targetOffset: Int = 0, count: Int = size)
+
+    /**
+     * 移除最旧的 [count] 个样本
+     */
+    fun discard(count: Int)
+
+    fun clear()
+}
@@ -0,0 +1,119 @@
+package org.voiddog.coughdetect.engine
+
+import org.voiddog.coughdetect.ml.AudioFeatures
+
+/**
+ * 以 16-bit PCM 存储的环形缓冲区
+ *
+ * 麦克风本身就是 16-bit 采集，历史样本没有必要展开成 float：内存和拷贝的带宽都减半。
+ * 可以直接写入 PCM（[writePcm16]），也可以写入 float 并在写入时转换；
+ * 取窗口时在分析边界一次性转换成 float。写满时丢弃最旧的样本。
+ *
+ * 非线程安全，由调用方加锁。
+ */
+class ShortRingBuffer(override val capacity: Int) : SampleRingBuffer {
+
+    private val data = ShortArray(capacity)
+    private var head = 0 // 最旧样本的位置
+
+    override var size = 0
+        private set
+
+    override val bytesPerSample: Int
+        get() = 2
+
+    /**
+     * 追加 [length] 个 16-bit PCM 样本，返回被丢弃的样本数
+     */
+    fun writePcm16(source: ShortArray, offset: Int = 0, length: Int = source.size - offset): Int {
+        var sourceOffset = offset
+        var count = length
+        val dropped = makeRoom(count)
+        if (count > capacity) {
+            sourceOffset += count - capacity
+            count = capacity
+        }
+
+        val tail = tail()
+        val firstPart = minOf(count, capacity - tail)
+        System.arraycopy(source, sourceOffset, data, tail, firstPart)
+        if (count > firstPart) {
+            System.arraycopy(source, sourceOffset + firstPart, data, 0, count - firstPart)
+        }
+        size += count
+        return dropped
+    }
+
+    override fun write(source: FloatArray, offset: Int, length: Int): Int {
+        var sourceOffset = offset
+        var count = length
+        val dropped = makeRoom(count)
+        if (count > capacity) {
+            sourceOffset += count - capacity
+            count = capacity
+        }
+
+        val tail = tail()
+        val firstPart = minOf(count, capacity - tail)
+        AudioFeatures.floatToPcm16(source, sourceOffset, data, tail, firstPart)
+        if (count > firstPart) {
+            AudioFeatures.floatToPcm16(source, sourceOffset + firstPart, data, 0, count - firstPart)
+        }
+        size += count
+        return dropped
+    }
+
+    /**
+     * 复制最旧的 [count] 个样本到 [target]，保持 16-bit PCM，不移除
+     */
+    fun peekPcm16(target: ShortArray, targetOffset: Int = 0, count: Int = size) {
+        require(count <= size) { "peek $count of $size" }
+        val firstPart = minOf(count, capacity - head)
+        System.arraycopy(data, head, target, targetOffset, firstPart)
+        if (count > firstPart) {
+            System.arraycopy(data, 0, target, targetOffset + firstPart, count - firstPart)
+        }
+    }
+
+    override fun peek(target: FloatArray, targetOffset: Int, count: Int) {
+        require(count <= size) { "peek $count of $size" }
+        val firstPart = minOf(count, capacity - head)
+        AudioFeatures.pcm16ToFloat(data, head, target, targetOffset, firstPart)
+        if (count > firstPart) {
+            AudioFeatures.pcm16ToFloat(data, 0, target, targetOffset + firstPart, count - firstPart)
+        }
+    }
+
+    override fun discard(count: Int) {
+        val removed = minOf(count, size)
+        head += removed
+        if (head >= capacity) head -= capacity
+        size -= removed
+    }
+
+    override fun clear() {
+        head = 0
+        size = 0
+    }
+
+    // 为 [count] 个新样本腾出空间（超过容量时只保留最后 capacity 个），返回被丢弃的样本数
+    private fun makeRoom(count: Int): Int {
+        var dropped = 0
+        var kept = count
+        if (kept > capacity) {
+            dropped += kept - capacity
+            kept = capacity
+        }
+        val overflow = size + kept - capacity
+        if (overflow > 0) {
+            discard(overflow)
+            dropped += overflow
+        }
+        return dropped
+    }
+
+    private fun tail(): Int {
+        val tail = head + size
+        return if (tail >= capacity) tail - capacity else tail
+    }
+}
@@ -0,0 +1,116 @@
+package org.voiddog.coughdetect.ml
+
+import kotlin.math.abs
+import kotlin.math.sqrt
+
+/**
+ * 检测链路上的基础音频特征
+ *
+ * 纯计算、无 Android 依赖，录音、规则检测和主机端基准测试共用同一份实现。
+ * 所有函数都接受 offset/length，方便直接在复用的缓冲区上计算而不复制。
+ */
+object AudioFeatures {
+
+    /**
+     * 16-bit PCM 转换为 [-1, 1) 的 float
+     */
+    fun pcm16ToFloat(source: ShortArray, target: FloatArray, count: Int) {
+        pcm16ToFloat(source, 0, target, 0, count)
+    }
+
+    fun pcm16ToFloat(source: ShortArray, sourceOffset: Int, target: FloatArray, targetOffset: Int, count: Int) {
+        // 简单的逐元素循环，便于 JIT/AOT 编译器做自动向量化
+        for (i in 0 until count) {
+            target[targetOffset + i] = source[sourceOffset + i] / 32768.0f
+        }
+    }
+
+    /**
+     * float 样本转换为 16-bit PCM，超出 [-1, 1] 的值会被截断
+     */
+    fun floatToPcm16(source: FloatArray, sourceOffset: Int, target: ShortArray, targetOffset: Int, count: Int) {
+        // 简单的逐元素循环，便于 JIT/AOT 编译器做自动向量化
+        for (i in 0 until count) {
+            var value = source[sourceOffset + i]
+            if (value > 1.0f) value = 1.0f
+            if (value < -1.0f) value = -1.0f
+            target[targetOffset + i] = (value * 32767f).toInt().toShort()
+        }
+    }
+
+    fun rms(data: FloatArray, offset: Int = 0, length: Int = data.size - offset): Float {
+        if (length <= 0) return 0f
+        var sum = 0.0
+        for (i in offset until offset + length) {
+            val value = data[i]
+            sum += value * value
+        }
+        return sqrt(sum / length).toFloat()
+    }
+
+    /**
+     * 每隔 [stride] 个样本取一个估计 RMS；只用来粗略估计能量，不需要抗混叠
+     */
+    fun rmsStrided(data: FloatArray, offset: Int, length: Int, stride: Int): Float {
+        if (length <= 0) return 0f
+        var sum = 0.0
+        var count = 0
+        var i = offset
+        val end = offset + length
+        while (i < end) {
+            val value = data[i]
+            sum += value * value
+            count++
+            i += stride
+        }
+        return sqrt(sum / count).toFloat()
+    }
+
+    /**
+     * 16-bit PCM 的 RMS，按 [-1, 1) 归一化，与转换成 float 后计算的结果一致
+     */
+    fun rmsPcm16(data: ShortArray, offset: Int = 0, length: Int = data.size - offset): Float {
+        if (length <= 0) return 0f
+        var sum = 0L
+        for (i in offset until offset + length) {
+            val value = data[i].toLong()
+            sum += value * value
+        }
+        return (sqrt(sum.toDouble() / length) / 32768.0).toFloat()
+    }
+
+    /**
+     * 过零率：相邻样本符号变化的次数除以样本数
+     */
+    fun zeroCrossingRate(data: FloatArray, offset: Int = 0, length: Int = data.size - offset): Float {
+        if (length <= 0) return 0f
+        var crossings = 0
+        var previousNonNegative = data[offset] >= 0
+        for (i in offset + 1 until offset + length) {
+            val nonNegative = data[i] >= 0
+            if (nonNegative != previousNonNegative) {
+                crossings++
+            }
+            previousNonNegative = nonNegative
+        }
+        return crossings.toFloat() / length
+    }
+
+    /**
+     * 简化的“频谱质心”：以样本序号为权重的幅度加权平均，不做 FFT
+     */
+    fun spectralCentroid(data: FloatArray, offset: Int = 0, length: Int = data.size - offset): Float {
+        var weightedSum = 0.0
+        var magnitudeSum = 0.0
+        for (i in 0 until length) {
+            val magnitude = abs(data[offset + i]).toDouble()
+            weightedSum += i * magnitude
+            magnitudeSum += magnitude
+        }
+        return if (magnitudeSum > 0) {
+            (weightedSum / magnitudeSum).toFloat()
+        } else {
+            0f
+        }
+    }
+}
@@ -0,0 +1,211 @@
+package org.voiddog.coughdetect.ml
+
+import kotlin.math.PI
+import kotlin.math.cos
+import kotlin.math.floor
+import kotlin.math.ln
+import kotlin.math.log10
+import kotlin.math.max
+import kotlin.math.pow
+import kotlin.math.sin
+import kotlin.math.sqrt
+
+/**
+ * MFCC 前端（运行时配置的通用实现）
+ *
+ * 每帧：Hann 窗 → radix-2 FFT → 功率谱 → 三角 mel 滤波器组 → 对数 → 正交 DCT-II。
+ * 所有表在构造时生成，缓冲区按配置一次分配，[process] 不分配内存。
+ * 线上固定配置见 [ProductionMfccFrontEnd]，两者共用同一份内联帧内核；
+ * 这个通用版本只作为特化版本的对照，供单元测试和基准测试使用。
+ */
+class MfccFrontEnd(val config: Config = Config()) {
+
+    data class Config(
+        val sampleRate: Int = 16000,
+        val frameSize: Int = 512,
+        val hopSize: Int = 160,
+        val melBands: Int = 40,
+        val cepstra: Int = 13
+    ) {
+        init {
+            require(frameSize > 1 && frameSize and (frameSize - 1) == 0) { "frameSize must be a power of two" }
+            require(cepstra <= melBands) { "cepstra must not exceed melBands" }
+        }
+    }
+
+    private val frameSize = config.frameSize
+    private val hopSize = config.hopSize
+    private val melBands = config.melBands
+    private val cepstra = config.cepstra
+
+    private val window = MfccTables.hann(frameSize)
+    private val bitReverse = MfccTables.bitReverse(frameSize)
+    private val cosTable = MfccTables.cosTable(frameSize)
+    private val sinTable = MfccTables.sinTable(frameSize)
+    private val filterbank = MfccTables.melFilterbank(frameSize, config.sampleRate, melBands)
+    private val dct = MfccTables.dct(melBands, cepstra)
+
+    private val re = FloatArray(frameSize)
+    private val im = FloatArray(frameSize)
+    private val power = FloatArray(frameSize / 2 + 1)
+    private val mel = FloatArray(melBands)
+
+    fun frameCount(length: Int): Int = MfccTables.frameCount(length, frameSize, hopSize)
+
+    /**
+     * 计算 [length] 个样本的 MFCC，按帧依次写入 [out]（每帧 cepstra 个系数），返回帧数
+     */
+    fun process(samples: FloatArray, offset: Int, length: Int, out: FloatArray, outOffset: Int = 0): Int {
+        val frames = frameCount(length)
+        for (frame in 0 until frames) {
+            mfccFrame(
+                samples, offset + frame * hopSize,
+                frameSize, melBands, cepstra,
+                window, bitReverse, cosTable, sinTable,
+                filterbank.start, filterbank.offset, filterbank.length, filterbank.weights, dct,
+                re, im, power, mel,
+                out, outOffset + frame * cepstra
+            )
+        }
+        return frames
+    }
+}
+
+/**
+ * MFCC 前端的表生成，通用实现和特化实现共用
+ */
+internal object MfccTables {
+
+    private const val LOG_FLOOR = 1e-10f
+
+    /** 稀疏的三角滤波器组：第 m 个滤波器覆盖 [start[m], start[m] + length[m]) 个频点 */
+    class MelFilterbank(val start: IntArray, val length: IntArray, val offset: IntArray, val weights: FloatArray)
+
+    fun frameCount(length: Int, frameSize: Int, hopSize: Int): Int {
+        return if (length < frameSize) 0 else (length - frameSize) / hopSize + 1
+    }
+
+    fun hann(size: Int) = FloatArray(size) { i -> (0.5 - 0.5 * cos(2 * PI * i / size)).toFloat() }
+
+    fun bitReverse(size: Int): IntArray {
+        val bits = Integer.numberOfTrailingZeros(size)
+        return IntArray(size) { i -> Integer.reverse(i) ushr (32 - bits) }
+    }
+
+    fun cosTable(size: Int) = FloatArray(size / 2) { k -> cos(2 * PI * k / size).toFloat() }
+
+    fun sinTable(size: Int) = FloatArray(size / 2) { k -> sin(2 * PI * k / size).toFloat() }
+
+    private fun hzToMel(hz: Double) = 2595.0 * log10(1.0 + hz / 700.0)
+
+    private fun melToHz(mel: Double) = 700.0 * (10.0.pow(mel / 2595.0) - 1.0)
+
+    fun melFilterbank(frameSize: Int, sampleRate: Int, bands: Int): MelFilterbank {
+        val bins = frameSize / 2 + 1
+        val maxMel = hzToMel(sampleRate / 2.0)
+        // bands + 2 个等间隔 mel 点，换算为（小数）频点位置
+        val points = DoubleArray(bands + 2) { i -> melToHz(maxMel * i / (bands + 1)) * frameSize / sampleRate }
+
+        val start = IntArray(bands)
+        val length = IntArray(bands)
+        val offset = IntArray(bands)
+        val weights = ArrayList<Float>()
+        for (m in 0 until bands) {
+            val left = points[m]
+            val center = points[m + 1]
+            val right = points[m + 2]
+            val first = (floor(left).toInt() + 1).coerceIn(0, bins - 1)
+            val last = (kotlin.math.ceil(right).toInt() - 1).coerceIn(first, bins - 1)
+            start[m] = first
+            offset[m] = weights.size
+            for (k in first..last) {
+                val weight = when {
+                    k <= center -> (k - left) / (center - left)
+                    else -> (right - k) / (right - center)
+                }
+                weights.add(max(weight, 0.0).toFloat())
+            }
+            length[m] = last - first + 1
+        }
+        return MelFilterbank(start, length, offset, weights.toFloatArray())
+    }
+
+    /** 正交 DCT-II 矩阵，按 [cepstra][bands] 展平 */
+    fun dct(bands: Int, cepstra: Int): FloatArray {
+        return FloatArray(cepstra * bands) { index ->
+            val c = index / bands
+            val m = index % bands
+            val scale = if (c == 0) sqrt(1.0 / bands) else sqrt(2.0 / bands)
+            (scale * cos(PI * c * (m + 0.5) / bands)).toFloat()
+        }
+    }
+
+    fun logFloor(value: Float): Float = ln(max(value, LOG_FLOOR))
+}
+
+/**
+ * 单帧 MFCC 内核。内联到每个调用点：特化实现传入的尺寸都是常量，JIT 看到的是
+ * 定长循环，可以展开和向量化；通用实现传入的是运行时字段。
+ */
+@Suppress("NOTHING_TO_INLINE")
+internal inline fun mfccFrame(
+    samples: FloatArray, start: Int,
+    frameSize: Int, melBands: Int, cepstra: Int,
+    window: FloatArray, bitReverse: IntArray, cosTable: FloatArray, sinTable: FloatArray,
+    melStart: IntArray, melOffset: IntArray, melLength: IntArray, melWeights: FloatArray, dct: FloatArray,
+    re: FloatArray, im: FloatArray, power: FloatArray, mel: FloatArray,
+    out: FloatArray, outOffset: Int
+) {
+    // 加窗，同时完成 FFT 的位反转重排
+    for (i in 0 until frameSize) {
+        val j = bitReverse[i]
+        re[j] = samples[start + i] * window[i]
+        im[j] = 0f
+    }
+
+    // radix-2 蝶形，旋转因子 e^{-2πik/N} 查表
+    var half = 1
+    while (half < frameSize) {
+        val step = frameSize / (half * 2)
+        var group = 0
+        while (group < frameSize) {
+            for (k in 0 until half) {
+                val c = cosTable[k * step]
+                val s = sinTable[k * step]
+                val a = group + k
+                val b = a + half
+                val tRe = re[b] * c + im[b] * s
+                val tIm = im[b] * c - re[b] * s
+                re[b] = re[a] - tRe
+                im[b] = im[a] - tIm
+                re[a] += tRe
+                im[a] += tIm
+            }
+            group += half * 2
+        }
+        half *= 2
+    }
+
+    for (k in 0..frameSize / 2) {
+        power[k] = re[k] * re[k] + im[k] * im[k]
+    }
+
+    for (m in 0 until melBands) {
+        var energy = 0f
+        val first = melStart[m]
+        val weightOffset = melOffset[m]
+        for (j in 0 until melLength[m]) {
+            energy += melWeights[weightOffset + j] * power[first + j]
+        }
+        mel[m] = MfccTables.logFloor(energy)
+    }
+
+    for (c in 0 until cepstra) {
+        var sum = 0f
+        val row = c * melBands
+        for (m in 0 until melBands) {
+            sum += dct[row + m] * mel[m]
+        }
+        out[outOffset + c] = sum
+    }
+}
@@ -0,0 +1,52 @@
+package org.voiddog.coughdetect.ml
+
+/**
+ * 线上固定配置的 MFCC 前端：16kHz、512 点帧、160 点帧移、40 个 mel 带、13 个倒谱系数
+ *
+ * 尺寸都是编译期常量，窗函数、旋转因子、滤波器组和 DCT 表在类加载时生成一次、
+ * 所有实例共享。帧内核以这些常量内联展开，是 [MfccFrontEnd] 的特化版本，
+ * 结果与同配置的通用实现一致。模型输入是这一配置的 MFCC 时由 [TensorFlowLiteDetector] 在打分线程上调用。
+ */
+class ProductionMfccFrontEnd {
+
+    companion object {
+        const val SAMPLE_RATE = 16000
+        const val FRAME_SIZE = 512
+        const val HOP_SIZE = 160
+        const val MEL_BANDS = 40
+        const val CEPSTRA = 13
+        private const val BINS = FRAME_SIZE / 2 + 1
+
+        private val WINDOW = MfccTables.hann(FRAME_SIZE)
+        private val BIT_REVERSE = MfccTables.bitReverse(FRAME_SIZE)
+        private val COS_TABLE = MfccTables.cosTable(FRAME_SIZE)
+        private val SIN_TABLE = MfccTables.sinTable(FRAME_SIZE)
+        private val FILTERBANK = MfccTables.melFilterbank(FRAME_SIZE, SAMPLE_RATE, MEL_BANDS)
+        private val DCT = MfccTables.dct(MEL_BANDS, CEPSTRA)
+
+        fun frameCount(length: Int): Int = MfccTables.frameCount(length, FRAME_SIZE, HOP_SIZE)
+    }
+
+    private val re = FloatArray(FRAME_SIZE)
+    private val im = FloatArray(FRAME_SIZE)
+    private val power = FloatArray(BINS)
+    private val mel = FloatArray(MEL_BANDS)
+
+    /**
+     * 计算 [length] 个样本的 MFCC，按帧依次写入 [out]（每帧 13 个系数），返回帧数
+     */
+    fun process(samples: FloatArray, offset: Int, length: Int, out: FloatArray, outOffset: Int = 0): Int {
+        val frames = frameCount(length)
+        for (frame in 0 until frames) {
+            mfccFrame(
+                samples, offset + frame * HOP_SIZE,
+                FRAME_SIZE, MEL_BANDS, CEPSTRA,
+                WINDOW, BIT_REVERSE, COS_TABLE, SIN_TABLE,
+                FILTERBANK.start, FILTERBANK.offset, FILTERBANK.length, FILTERBANK.weights, DCT,
+                re, im, power, mel,
+                out, outOffset + frame * CEPSTRA
+            )
+        }
+        return frames
+    }
+}
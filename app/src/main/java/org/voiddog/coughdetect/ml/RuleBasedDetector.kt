@@ -0,0 +1,133 @@
+package org.voiddog.coughdetect.ml
+
+import kotlin.math.max
+import kotlin.math.min
+
+/**
+ * 基于音频特征的规则检测（没有模型时的回退方案）
+ *
+ * 从 [TensorFlowLiteDetector] 中拆出，不依赖 Android，可以在主机端直接测试和基准测试。
+ * 实例持有分析用的临时内存，同一实例只能在一个线程上使用。
+ */
+class RuleBasedDetector(private val config: Config = Config()) {
+
+    companion object {
+        // 抽样估计的能量有误差，低于阈值这个比例才直接判为非咳嗽
+        private const val COARSE_SCREEN_MARGIN = 0.8f
+    }
+
+    /**
+     * 规则的阈值和置信度权重，默认值即线上使用的参数；离线评估时用不同配置对比
+     */
+    data class Config(
+        // 高能量 + 快速变化
+        val loudRmsThreshold: Float = 0.1f,
+        val zeroCrossingThreshold: Float = 0.05f,
+        // 中等能量 + 高频成分
+        val moderateRmsThreshold: Float = 0.05f,
+        // 默认是时域近似的“质心”（样本序号）；spectralCentroid = true 时改用 FFT 频谱质心，单位 Hz
+        val centroidThreshold: Float = 2000f,
+        val spectralCentroid: Boolean = false,
+        // 咳嗽置信度 = min(rms * rmsWeight + zcr * zeroCrossingWeight, 1)
+        val rmsWeight: Float = 2f,
+        val zeroCrossingWeight: Float = 5f
+    )
+
+    // 频谱质心所需的 FFT 和每窗口临时内存，只在启用时创建
+    private val spectralAnalyzer = if (config.spectralCentroid) SpectralAnalyzer() else null
+    private val arena = spectralAnalyzer?.let { ScratchArena(it.scratchSize) }
+
+    data class Features(
+        val rms: Float,
+        val zeroCrossingRate: Float,
+        val spectralCentroid: Float
+    )
+
+    fun extractFeatures(audioData: FloatArray, offset: Int = 0, length: Int = audioData.size - offset): Features {
+        return Features(
+            rms = AudioFeatures.rms(audioData, offset, length),
+            zeroCrossingRate = AudioFeatures.zeroCrossingRate(audioData, offset, length),
+            spectralCentroid = centroid(audioData, offset, length)
+        )
+    }
+
+    fun classify(
+        features: Features,
+        result: TensorFlowLiteDetector.DetectionResult = TensorFlowLiteDetector.DetectionResult()
+    ): TensorFlowLiteDetector.DetectionResult {
+        return classify(features.rms, features.zeroCrossingRate, features.spectralCentroid, result)
+    }
+
+    /**
+     * 检测并把结果写入 [result]；传入复用的结果对象时整个检测过程不分配内存
+     */
+    fun detect(
+        audioData: FloatArray,
+        offset: Int = 0,
+        length: Int = audioData.size - offset,
+        result: TensorFlowLiteDetector.DetectionResult = TensorFlowLiteDetector.DetectionResult()
+    ): TensorFlowLiteDetector.DetectionResult {
+        return classify(
+            AudioFeatures.rms(audioData, offset, length),
+            AudioFeatures.zeroCrossingRate(audioData, offset, length),
+            centroid(audioData, offset, length),
+            result
+        )
+    }
+
+    /**
+     * 粗略检测：先每隔 [stride] 个样本估计能量，低于两条规则的能量阈值时直接判为非咳嗽，
+     * 不再计算过零率和质心；否则和 [detect] 相同
+     */
+    fun detectCoarse(
+        audioData: FloatArray,
+        offset: Int,
+        length: Int,
+        stride: Int,
+        result: TensorFlowLiteDetector.DetectionResult = TensorFlowLiteDetector.DetectionResult()
+    ): TensorFlowLiteDetector.DetectionResult {
+        val rms = AudioFeatures.rmsStrided(audioData, offset, length, stride)
+        if (rms < min(config.loudRmsThreshold, config.moderateRmsThreshold) * COARSE_SCREEN_MARGIN) {
+            return classify(rms, 0f, 0f, result)
+        }
+        return detect(audioData, offset, length, result)
+    }
+
+    private fun centroid(audioData: FloatArray, offset: Int, length: Int): Float {
+        val analyzer = spectralAnalyzer ?: return AudioFeatures.spectralCentroid(audioData, offset, length)
+        val arena = arena!!
+        return try {
+            val spectrum = analyzer.meanMagnitudeSpectrum(audioData, offset, length, arena)
+            analyzer.centroidHz(arena.buffer, spectrum)
+        } finally {
+            // 窗口结束，一次释放全部临时数据
+            arena.reset()
+        }
+    }
+
+    private fun classify(
+        rms: Float,
+        zeroCrossingRate: Float,
+        spectralCentroid: Float,
+        result: TensorFlowLiteDetector.DetectionResult
+    ): TensorFlowLiteDetector.DetectionResult {
+        // Cough detection heuristics
+        val isCough = when {
+            rms > config.loudRmsThreshold && zeroCrossingRate > config.zeroCrossingThreshold -> true // High energy + rapid changes
+            rms > config.moderateRmsThreshold && spectralCentroid > config.centroidThreshold -> true // Moderate energy + high frequency content
+            else -> false
+        }
+
+        val confidence = when {
+            isCough -> min(rms * config.rmsWeight + zeroCrossingRate * config.zeroCrossingWeight, 1.0f)
+            else -> max(1.0f - rms * config.rmsWeight, 0.0f)
+        }
+
+        return result.set(
+            isCough = isCough,
+            confidence = confidence,
+            coughProbability = if (isCough) confidence else 1.0f - confidence,
+            nonCoughProbability = if (isCough) 1.0f - confidence else confidence
+        )
+    }
+}
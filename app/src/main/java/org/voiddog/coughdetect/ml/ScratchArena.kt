@@ -0,0 +1,53 @@
+package org.voiddog.coughdetect.ml
+
+/**
+ * 分析线程的每窗口临时内存（bump 分配器）
+ *
+ * 一块预分配的 FloatArray，按需顺序切出片段；JVM 上没有数组切片，片段用 [allocate]
+ * 返回的偏移在 [buffer] 上读写。每个窗口结束时 [reset]，O(1) 释放全部片段，
+ * 频谱、幅度、帧缓冲等临时数据都在同一块连续内存里，不产生分配和 GC 压力。
+ *
+ * 非线程安全，归分析线程所有。
+ */
+class ScratchArena(capacity: Int) {
+
+    val buffer = FloatArray(capacity)
+
+    val capacity: Int
+        get() = buffer.size
+
+    var used = 0
+        private set
+
+    /**
+     * 已用空间的历史最大值，用于确定容量
+     */
+    var highWaterMark = 0
+        private set
+
+    /**
+     * 切出 [size] 个 float，返回在 [buffer] 中的起始偏移。内容未清零。
+     */
+    fun allocate(size: Int): Int {
+        check(used + size <= buffer.size) { "Scratch arena exhausted: $used + $size > ${buffer.size}" }
+        val offset = used
+        used += size
+        if (used > highWaterMark) {
+            highWaterMark = used
+        }
+        return offset
+    }
+
+    fun mark(): Int = used
+
+    /**
+     * 释放 [mark] 之后切出的所有片段
+     */
+    fun release(mark: Int) {
+        used = mark
+    }
+
+    fun reset() {
+        used = 0
+    }
+}
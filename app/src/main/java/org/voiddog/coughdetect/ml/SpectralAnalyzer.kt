@@ -0,0 +1,88 @@
+package org.voiddog.coughdetect.ml
+
+import org.jtransforms.fft.FloatFFT_1D
+import kotlin.math.PI
+import kotlin.math.abs
+import kotlin.math.cos
+import kotlin.math.sqrt
+
+/**
+ * 基于 FFT 的频谱特征
+ *
+ * 窗口按 [frameSize] 点 Hann 窗分帧，用 JTransforms 原地做实数 FFT，各帧幅度谱取平均。
+ * 帧缓冲和幅度谱都从调用方的 [ScratchArena] 中切出，FFT 计划和窗函数只在构造时计算一次，
+ * 分析过程中不分配内存。
+ */
+class SpectralAnalyzer(
+    val frameSize: Int = 512,
+    val hopSize: Int = frameSize / 2,
+    private val sampleRate: Int = 16000
+) {
+
+    private val fft = FloatFFT_1D(frameSize.toLong())
+    private val window = FloatArray(frameSize) { i ->
+        (0.5 - 0.5 * cos(2 * PI * i / (frameSize - 1))).toFloat()
+    }
+
+    val binCount = frameSize / 2 + 1
+
+    private val binHz = sampleRate.toFloat() / frameSize
+
+    /**
+     * 一次 [meanMagnitudeSpectrum] 需要的临时空间（帧缓冲 + 平均幅度谱）
+     */
+    val scratchSize: Int
+        get() = frameSize + binCount
+
+    /**
+     * 计算窗口内各帧的平均幅度谱，写入 [arena]，返回幅度谱在 arena.buffer 中的偏移
+     */
+    fun meanMagnitudeSpectrum(data: FloatArray, offset: Int, length: Int, arena: ScratchArena): Int {
+        val frame = arena.allocate(frameSize)
+        val spectrum = arena.allocate(binCount)
+        val buffer = arena.buffer
+        buffer.fill(0f, spectrum, spectrum + binCount)
+
+        var frames = 0
+        var start = offset
+        val end = offset + length
+        while (start + frameSize <= end) {
+            for (i in 0 until frameSize) {
+                buffer[frame + i] = data[start + i] * window[i]
+            }
+            // 原地实数 FFT：[Re0, Re(n/2), Re1, Im1, Re2, Im2, ...]
+            fft.realForward(buffer, frame)
+            buffer[spectrum] += abs(buffer[frame])
+            buffer[spectrum + binCount - 1] += abs(buffer[frame + 1])
+            for (k in 1 until binCount - 1) {
+                val re = buffer[frame + 2 * k]
+                val im = buffer[frame + 2 * k + 1]
+                buffer[spectrum + k] += sqrt(re * re + im * im)
+            }
+            frames++
+            start += hopSize
+        }
+
+        if (frames > 1) {
+            val scale = 1f / frames
+            for (k in 0 until binCount) {
+                buffer[spectrum + k] *= scale
+            }
+        }
+        return spectrum
+    }
+
+    /**
+     * 幅度加权的平均频率（Hz）
+     */
+    fun centroidHz(buffer: FloatArray, spectrum: Int): Float {
+        var weightedSum = 0.0
+        var magnitudeSum = 0.0
+        for (k in 0 until binCount) {
+            val magnitude = buffer[spectrum + k].toDouble()
+            weightedSum += k * binHz * magnitude
+            magnitudeSum += magnitude
+        }
+        return if (magnitudeSum > 0) (weightedSum / magnitudeSum).toFloat() else 0f
+    }
+}
@@ -20,19 +20,39 @@ class TensorFlowLiteDetector(private val context: Context) {
         private const val MODEL_FILENAME = "cough_detection_model.tflite"
         private const val INPUT_SIZE = 16000 // 1 second at 16kHz
         private const val OUTPUT_SIZE = 2 // [non-cough, cough]
-        private const val COUGH_THRESHOLD = 0.5f
+        private const val COARSE_STRIDE = 4 // Energy screen of the coarse pass looks at every 4th sample
     }
     
     private var interpreter: Interpreter? = null
     private var gpuDelegate: GpuDelegate? = null
     private var isModelLoaded = false
+    private var ruleBasedDetector = RuleBasedDetector()
+    private var coughThreshold = 0.5f
+    
+    // 推理用的缓冲区和结果对象只分配一次，[detect] 在稳态下不分配内存；输入缓冲区在加载模型时按输入特征重新分配
+    private var inputBuffer = ByteBuffer.allocateDirect(INPUT_SIZE * 4).order(ByteOrder.nativeOrder())
+    // 模型输入是线上固定配置的 MFCC 时由前端从窗口计算特征，输入是原始波形时为 null
+    private var mfccFrontEnd: ProductionMfccFrontEnd? = null
+    private var mfccFeatures: FloatArray? = null
+    private val outputBuffer = ByteBuffer.allocateDirect(OUTPUT_SIZE * 4).order(ByteOrder.nativeOrder())
+    private val processedData = FloatArray(INPUT_SIZE)
+    private val result = DetectionResult()
+    private var fallbackLogged = false
     
     data class DetectionResult(
-        val isCough: Boolean,
-        val confidence: Float,
-        val coughProbability: Float,
-        val nonCoughProbability: Float
-    )
+        var isCough: Boolean = false,
+        var confidence: Float = 0f,
+        var coughProbability: Float = 0f,
+        var nonCoughProbability: Float = 0f
+    ) {
+        fun set(isCough: Boolean, confidence: Float, coughProbability: Float, nonCoughProbability: Float): DetectionResult {
+            this.isCough = isCough
+            this.confidence = confidence
+            this.coughProbability = coughProbability
+            this.nonCoughProbability = nonCoughProbability
+            return this
+        }
+    }
     
     suspend fun initialize(): Boolean = withContext(Dispatchers.IO) {
         try {
@@ -66,7 +86,9 @@ class TensorFlowLiteDetector(private val context: Context) {
                 Log.i(TAG, "ℹ️ GPU不支持，使用CPU")
             }
             
-            interpreter = Interpreter(modelBuffer, options)
+            val loaded = Interpreter(modelBuffer, options)
+            configureInput(loaded.getInputTensor(0).numElements())
+            interpreter = loaded
             isModelLoaded = true
             
             Log.i(TAG, "✅ TensorFlow Lite检测器初始化成功")
@@ -80,29 +102,42 @@ class TensorFlowLiteDetector(private val context: Context) {
     }
     
     suspend fun detectCough(audioData: FloatArray): DetectionResult = withContext(Dispatchers.Default) {
+        // 挂起版本的调用方可能跨线程持有结果，返回副本
+        detect(audioData).copy()
+    }
+    
+    /**
+     * 在调用线程上同步检测前 [length] 个样本
+     *
+     * 返回的结果对象由检测器复用，下一次检测时会被覆盖；同一检测器不能被多个线程同时调用。
+     */
+    fun detect(audioData: FloatArray, length: Int = audioData.size): DetectionResult {
         if (!isModelLoaded || interpreter == null) {
-            Log.w(TAG, "模型未加载，使用规则检测")
-            return@withContext performRuleBasedDetection(audioData)
+            if (!fallbackLogged) {
+                Log.w(TAG, "模型未加载，使用规则检测")
+                fallbackLogged = true
+            }
+            return performRuleBasedDetection(audioData, length)
         }
         
-        try {
-            // Prepare input buffer
-            val inputBuffer = ByteBuffer.allocateDirect(INPUT_SIZE * 4).apply {
-                order(ByteOrder.nativeOrder())
-                rewind()
-            }
-            
+        return try {
             // Normalize and pad/truncate audio data to INPUT_SIZE
-            val processedData = preprocessAudioData(audioData)
-            for (value in processedData) {
-                inputBuffer.putFloat(value)
+            preprocessAudioData(audioData, length)
+            inputBuffer.clear()
+            val frontEnd = mfccFrontEnd
+            val features = mfccFeatures
+            if (frontEnd != null && features != null) {
+                frontEnd.process(processedData, 0, INPUT_SIZE, features)
+                for (value in features) {
+                    inputBuffer.putFloat(value)
+                }
+            } else {
+                for (value in processedData) {
+                    inputBuffer.putFloat(value)
+                }
             }
             inputBuffer.rewind()
-            
-            // Prepare output buffer
-            val outputBuffer = ByteBuffer.allocateDirect(OUTPUT_SIZE * 4).apply {
-                order(ByteOrder.nativeOrder())
-            }
+            outputBuffer.clear()
             
             // Run inference
             interpreter?.run(inputBuffer, outputBuffer)
@@ -120,14 +155,16 @@ class TensorFlowLiteDetector(private val context: Context) {
             val normalizedNonCough = expNonCough / sumExp
             val normalizedCough = expCough / sumExp
             
-            val isCough = normalizedCough > COUGH_THRESHOLD
+            val isCough = normalizedCough > coughThreshold
             val confidence = if (isCough) normalizedCough else normalizedNonCough
             
-            Log.d(TAG, "TFLite检测结果 - 咳嗽概率: %.3f, 非咳嗽概率: %.3f, 判断: %s".format(
-                normalizedCough, normalizedNonCough, if (isCough) "咳嗽" else "非咳嗽"
-            ))
+            if (Log.isLoggable(TAG, Log.DEBUG)) {
+                Log.d(TAG, "TFLite检测结果 - 咳嗽概率: %.3f, 非咳嗽概率: %.3f, 判断: %s".format(
+                    normalizedCough, normalizedNonCough, if (isCough) "咳嗽" else "非咳嗽"
+                ))
+            }
             
-            DetectionResult(
+            result.set(
                 isCough = isCough,
                 confidence = confidence,
                 coughProbability = normalizedCough,
@@ -136,105 +173,75 @@ class TensorFlowLiteDetector(private val context: Context) {
             
         } catch (e: Exception) {
             Log.e(TAG, "❌ TensorFlow Lite推理失败，回退到规则检测", e)
-            performRuleBasedDetection(audioData)
+            performRuleBasedDetection(audioData, length)
         }
     }
     
-    private fun preprocessAudioData(audioData: FloatArray): FloatArray {
-        val processedData = FloatArray(INPUT_SIZE)
-        
-        when {
-            audioData.size == INPUT_SIZE -> {
-                // Perfect size, just copy
-                audioData.copyInto(processedData)
-            }
-            audioData.size > INPUT_SIZE -> {
-                // Truncate to INPUT_SIZE
-                audioData.copyInto(processedData, 0, 0, INPUT_SIZE)
-            }
-            else -> {
-                // Pad with zeros
-                audioData.copyInto(processedData, 0, 0, audioData.size)
-                // Remaining elements are already 0.0f
+    /**
+     * 只用规则检测，不经过模型；CPU 余量不足时的降级档位，和 [detect] 共用结果对象
+     */
+    fun detectRules(audioData: FloatArray, length: Int = audioData.size): DetectionResult {
+        return performRuleBasedDetection(audioData, length)
+    }
+    
+    /**
+     * 过载时给来不及完整打分的窗口做粗略判定：抽样能量筛查，通过后只跑规则检测，不经过模型。
+     * 和 [detect] 共用结果对象，同样不能被多个线程同时调用
+     */
+    fun detectCoarse(audioData: FloatArray, length: Int = audioData.size): DetectionResult {
+        return ruleBasedDetector.detectCoarse(audioData, 0, length, COARSE_STRIDE, result)
+    }
+    
+    /**
+     * 按模型输入张量的元素数选择特征：等于一个窗口的 MFCC（16kHz/512/160/40/13）时用
+     * [ProductionMfccFrontEnd] 计算，否则直接输入 [INPUT_SIZE] 个样本的波形
+     */
+    private fun configureInput(elements: Int) {
+        val mfccElements = ProductionMfccFrontEnd.frameCount(INPUT_SIZE) * ProductionMfccFrontEnd.CEPSTRA
+        if (elements == mfccElements) {
+            mfccFrontEnd = ProductionMfccFrontEnd()
+            mfccFeatures = FloatArray(mfccElements)
+            inputBuffer = ByteBuffer.allocateDirect(mfccElements * 4).order(ByteOrder.nativeOrder())
+            Log.i(TAG, "ℹ️ 模型输入为 MFCC: ${ProductionMfccFrontEnd.frameCount(INPUT_SIZE)} 帧 × ${ProductionMfccFrontEnd.CEPSTRA}")
+        } else {
+            mfccFrontEnd = null
+            mfccFeatures = null
+            inputBuffer = ByteBuffer.allocateDirect(INPUT_SIZE * 4).order(ByteOrder.nativeOrder())
+            if (elements != INPUT_SIZE) {
+                Log.w(TAG, "⚠️ 模型输入大小 $elements 与窗口长度 $INPUT_SIZE 不一致，推理会失败并回退到规则检测")
             }
         }
+    }
+    
+    private fun preprocessAudioData(audioData: FloatArray, length: Int) {
+        val copied = minOf(length, INPUT_SIZE)
+        // Truncate to INPUT_SIZE, or pad with zeros
+        audioData.copyInto(processedData, 0, 0, copied)
+        processedData.fill(0f, copied, INPUT_SIZE)
         
         // Normalize to [-1, 1] range if needed
-        val maxAbs = processedData.maxOfOrNull { kotlin.math.abs(it) } ?: 1.0f
+        var maxAbs = 0f
+        for (value in processedData) {
+            maxAbs = maxOf(maxAbs, kotlin.math.abs(value))
+        }
         if (maxAbs > 1.0f) {
             for (i in processedData.indices) {
                 processedData[i] /= maxAbs
             }
         }
-        
-        return processedData
     }
     
-    private fun performRuleBasedDetection(audioData: FloatArray): DetectionResult {
+    private fun performRuleBasedDetection(audioData: FloatArray, length: Int): DetectionResult {
         // Simple rule-based detection based on audio characteristics
-        val rms = calculateRMS(audioData)
-        val zeroCrossingRate = calculateZeroCrossingRate(audioData)
-        val spectralCentroid = calculateSpectralCentroid(audioData)
-        
-        // Cough detection heuristics
-        val isCough = when {
-            rms > 0.1f && zeroCrossingRate > 0.05f -> true // High energy + rapid changes
-            rms > 0.05f && spectralCentroid > 2000f -> true // Moderate energy + high frequency content
-            else -> false
-        }
-        
-        val confidence = when {
-            isCough -> kotlin.math.min(rms * 2f + zeroCrossingRate * 5f, 1.0f)
-            else -> kotlin.math.max(1.0f - rms * 2f, 0.0f)
-        }
-        
-        Log.d(TAG, "规则检测结果 - RMS: %.3f, ZCR: %.3f, SC: %.1f, 判断: %s".format(
-            rms, zeroCrossingRate, spectralCentroid, if (isCough) "咳嗽" else "非咳嗽"
-        ))
-        
-        return DetectionResult(
-            isCough = isCough,
-            confidence = confidence,
-            coughProbability = if (isCough) confidence else 1.0f - confidence,
-            nonCoughProbability = if (isCough) 1.0f - confidence else confidence
-        )
-    }
-    
-    private fun calculateRMS(data: FloatArray): Float {
-        var sum = 0.0
-        for (value in data) {
-            sum += value * value
-        }
-        return kotlin.math.sqrt(sum / data.size).toFloat()
-    }
-    
-    private fun calculateZeroCrossingRate(data: FloatArray): Float {
-        var crossings = 0
-        for (i in 1 until data.size) {
-            if ((data[i] >= 0) != (data[i - 1] >= 0)) {
-                crossings++
-            }
-        }
-        return crossings.toFloat() / data.size
-    }
-    
-    private fun calculateSpectralCentroid(data: FloatArray): Float {
-        // Simplified spectral centroid calculation
-        // In a real implementation, you would use FFT
-        var weightedSum = 0.0
-        var magnitudeSum = 0.0
-        
-        for (i in data.indices) {
-            val magnitude = kotlin.math.abs(data[i]).toDouble()
-            weightedSum += i * magnitude
-            magnitudeSum += magnitude
-        }
-        
-        return if (magnitudeSum > 0) {
-            (weightedSum / magnitudeSum).toFloat()
-        } else {
-            0f
+        if (Log.isLoggable(TAG, Log.DEBUG)) {
+            val features = ruleBasedDetector.extractFeatures(audioData, 0, length)
+            ruleBasedDetector.classify(features, result)
+            Log.d(TAG, "规则检测结果 - RMS: %.3f, ZCR: %.3f, SC: %.1f, 判断: %s".format(
+                features.rms, features.zeroCrossingRate, features.spectralCentroid, if (result.isCough) "咳嗽" else "非咳嗽"
+            ))
+            return result
         }
+        return ruleBasedDetector.detect(audioData, 0, length, result)
     }
     
     private fun loadModelFile(): File? {
@@ -261,6 +268,14 @@ class TensorFlowLiteDetector(private val context: Context) {
         }
     }
     
+    /**
+     * 更新判定阈值和规则检测参数；和 [detect] 一样只能在检测线程上调用
+     */
+    fun setConfig(coughThreshold: Float, rules: RuleBasedDetector.Config) {
+        this.coughThreshold = coughThreshold
+        ruleBasedDetector = RuleBasedDetector(rules)
+    }
+    
     fun isModelLoaded(): Boolean = isModelLoaded
     
     fun cleanup() {
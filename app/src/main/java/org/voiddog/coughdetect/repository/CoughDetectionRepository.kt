@@ -5,13 +5,18 @@ import android.util.Log
 import org.voiddog.coughdetect.data.CoughRecord
 import org.voiddog.coughdetect.data.CoughDetectDatabase
 import org.voiddog.coughdetect.data.CoughRecordDao
+import org.voiddog.coughdetect.data.DiskQuotaManager
+import org.voiddog.coughdetect.data.EventLog
 import org.voiddog.coughdetect.engine.CoughDetectEngine
+import org.voiddog.coughdetect.engine.EngineConfig
 import org.voiddog.coughdetect.data.SettingsManager
 import org.voiddog.coughdetect.plugin.AudioEventRecordPlugin
+import org.voiddog.coughdetect.audio.FlacEncoder
+import org.voiddog.coughdetect.utils.Constants
 import kotlinx.coroutines.*
 import kotlinx.coroutines.flow.*
+import kotlinx.coroutines.future.await
 import java.io.File
-import java.text.SimpleDateFormat
 import java.util.*
 
 class CoughDetectionRepository(private val context: Context) {
@@ -26,6 +31,9 @@ class CoughDetectionRepository(private val context: Context) {
     private val coughRecordDao: CoughRecordDao = database.coughRecordDao()
     private val coughDetectEngine = CoughDetectEngine(context)
     private val settingsManager = SettingsManager.getInstance(context)
+    // 首次访问时会恢复日志段、重放配额清单，在 initialize() 的 IO 线程中预热
+    private val eventLog by lazy { EventLog.getInstance(context) }
+    private val diskQuota by lazy { DiskQuotaManager.getInstance(context) }
     
     // 插件列表
     private val plugins = mutableListOf<AudioEventRecordPlugin>()
@@ -103,6 +111,7 @@ class CoughDetectionRepository(private val context: Context) {
 
             Log.d(TAG, "✅ 引擎初始化成功，设置回调...")
             setupEngineCallbacks()
+            coughDetectEngine.setConfig(EngineConfig.forSensitivity(settingsManager.detectionSensitivity))
 
             val initTime = System.currentTimeMillis() - startTime
             Log.i(TAG, "✅ 仓库初始化完成! 总耗时: ${initTime}ms")
@@ -114,6 +123,9 @@ class CoughDetectionRepository(private val context: Context) {
                     val created = audioDir.mkdirs()
                     Log.d(TAG, "音频目录创建${if (created) "成功" else "失败"}: ${audioDir.absolutePath}")
                 }
+
+                // 加载事件日志和配额索引
+                Log.d(TAG, "事件日志: ${eventLog.segmentSizes().size}个段, 已用空间: ${diskQuota.totalBytes / 1024 / 1024}MB")
             }
 
             true
@@ -137,23 +149,32 @@ class CoughDetectionRepository(private val context: Context) {
             }
         }
 
-        // Monitor audio level changes
+        // Poll audio level from the engine telemetry block while recording
         CoroutineScope(Dispatchers.Main).launch {
-            coughDetectEngine.audioLevel.collect { level ->
-                _audioLevel.value = level
-            }
+            val telemetry = coughDetectEngine.getTelemetry()
+            detectionState
+                .map { it == DetectionState.RECORDING || it == DetectionState.PROCESSING }
+                .distinctUntilChanged()
+                .collectLatest { active ->
+                    if (!active) {
+                        _audioLevel.value = 0f
+                        return@collectLatest
+                    }
+                    while (currentCoroutineContext().isActive) {
+                        _audioLevel.value = telemetry.getAudioLevel()
+                        delay(Constants.UI.AUDIO_LEVEL_UPDATE_INTERVAL_MS)
+                    }
+                }
         }
 
-        // Monitor audio events
+        // Monitor audio events: every event is delivered once, so each pooled buffer is released once
         CoroutineScope(Dispatchers.Main).launch {
-            coughDetectEngine.lastAudioEvent.collect { event ->
-                event?.let {
-                    // Store the audio data when a cough is detected
-                    if (it.type == CoughDetectEngine.AudioEventType.COUGH_DETECTED && it.audioData != null) {
-                        // We could store the audio data here if needed
-                        // For now, we're just handling the event normally
-                    }
-                    handleAudioEvent(it)
+            coughDetectEngine.audioEvents.collect { event ->
+                try {
+                    handleAudioEvent(event)
+                } finally {
+                    // 音频已编码写入事件日志，缓冲区还给引擎复用
+                    coughDetectEngine.releaseAudioEvent(event)
                 }
             }
         }
@@ -240,6 +261,14 @@ class CoughDetectionRepository(private val context: Context) {
         }
     }
 
+    /**
+     * 保存并应用检测灵敏度（0..1），检测进行中也会在下一个窗口生效，不中断录音
+     */
+    fun setDetectionSensitivity(sensitivity: Float): Boolean {
+        settingsManager.detectionSensitivity = sensitivity
+        return coughDetectEngine.setConfig(EngineConfig.forSensitivity(sensitivity))
+    }
+
     suspend fun pauseDetection() {
         withContext(Dispatchers.Main) {
             if (_detectionState.value == DetectionState.RECORDING) {
@@ -380,37 +409,25 @@ class CoughDetectionRepository(private val context: Context) {
             var duration = 0L
             var audioSamples = 0
 
-            // 如果提供了音频数据，则保存音频文件
+            // 如果提供了音频数据，则压缩后追加到事件日志
             if (audioData != null) {
-                // Generate filename with timestamp
-                val dateFormat = SimpleDateFormat("yyyyMMdd_HHmmss_SSS", Locale.getDefault())
-                val eventTypeName = eventType.name.lowercase()
-                val filename = "${eventTypeName}_${dateFormat.format(Date(timestamp))}"
-
-                // Create audio file path using internal storage for better compatibility
-                val audioDir = File(context.filesDir, "audio_events")
-                if (!audioDir.exists()) {
-                    audioDir.mkdirs()
-                }
-                audioFilePath = "${audioDir.absolutePath}/$filename.wav"
-
-                // 在保存新文件之前检查磁盘空间并清理旧文件
-                manageDiskSpace(audioDir)
-
-                // Save real audio data to file
-                val saved = saveAudioDataToFile(audioFilePath, audioData)
-                if (!saved) {
-                    Log.e(TAG, "❌ 保存音频文件失败: $audioFilePath")
-                    // 注意：这里不能直接更新 _error.value，因为可能不在主线程
-                    throw Exception("保存音频文件失败")
-                }
-
                 // Calculate duration based on sample rate (assuming 16kHz)
                 val sampleRate = 16000 // Hz
                 duration = (audioData.size * 1000L) / sampleRate // 转换为毫秒
                 audioSamples = audioData.size
 
-                Log.d(TAG, "✅ 音频文件保存成功: $filename, 样本数: $audioSamples, 时长: ${duration}ms")
+                val clip = FlacEncoder.encodeToByteArray(audioData, sampleRate)
+
+                // 追加之前检查配额，必要时整段淘汰最旧的日志段
+                manageDiskSpace(clip.size.toLong())
+
+                // 片段由事件日志的后台 I/O 线程写入，这里挂起等待落盘，不占用 IO 调度器的线程
+                val entry = eventLog.append(timestamp, duration.toInt(), confidence, amplitude, eventType.ordinal, clip).await()
+                audioFilePath = entry.clip.toString()
+                diskQuota.put(entry.clip.file.absolutePath, eventLog.segmentSize(entry.clip.file))
+
+                Log.d(TAG, "✅ 音频片段已写入事件日志: ${entry.clip.file.name}, 偏移: ${entry.clip.offset}, 大小: ${clip.size} bytes, " +
+                        "压缩比: ${String.format("%.2f", audioSamples * 2.0 / clip.size)}, 时长: ${duration}ms")
             } else {
                 // 如果没有音频数据，使用缓冲区大小估算时长（后备方案）
                 duration = currentAudioBuffer.size * 100L // Assuming 100ms chunks
@@ -442,7 +459,7 @@ class CoughDetectionRepository(private val context: Context) {
             val totalRecords = coughRecordDao.getRecordCount()
 
             if (audioData != null) {
-                Log.i(TAG, "💾 ${eventType.displayName}记录已保存 - ID: $recordId, 文件: ${audioFilePath.substringAfterLast("/")}, 置信度: ${String.format("%.3f", confidence)}, " +
+                Log.i(TAG, "💾 ${eventType.displayName}记录已保存 - ID: $recordId, 片段: ${audioFilePath.substringAfterLast("/")}, 置信度: ${String.format("%.3f", confidence)}, " +
                         "音频样本: $audioSamples, 时长: ${duration}ms, 保存耗时: ${saveTime}ms, 总记录数: $totalRecords")
             } else {
                 Log.i(TAG, "💾 ${eventType.displayName}记录已保存(仅数据库) - ID: $recordId, 置信度: ${String.format("%.3f", confidence)}, " +
@@ -451,8 +468,7 @@ class CoughDetectionRepository(private val context: Context) {
 
             // 检查存储空间 (仅在保存了音频文件时检查)
             if (audioData != null) {
-                val audioDir = File(context.filesDir, "audio_events")
-                val freeSpace = audioDir.freeSpace / 1024 / 1024
+                val freeSpace = context.filesDir.freeSpace / 1024 / 1024
                 if (freeSpace < 100) {  // 小于100MB时警告
                     Log.w(TAG, "⚠️ 存储空间不足: ${freeSpace}MB")
                 }
@@ -528,71 +544,40 @@ class CoughDetectionRepository(private val context: Context) {
     }
 
     /**
-     * 管理磁盘空间，确保音频文件的总大小不超过设定的限制
+     * 管理磁盘空间，确保已存储音频的总大小加上即将写入的片段不超过设定的限制
+     * 总大小和最久未使用顺序由配额管理器增量维护，淘汰只涉及被选中的条目，不需要扫描目录
      */
-    private suspend fun manageDiskSpace(audioDir: File) {
+    private suspend fun manageDiskSpace(incomingBytes: Long) {
         try {
             val settings = settingsManager.getSettings()
-            val maxSizeBytes = settings.maxAudioCacheSizeMB.toLong() * 1024 * 1024
-
-            // 获取目录下所有wav文件
-            val wavFiles = audioDir.listFiles { file -> file.extension.equals("wav", ignoreCase = true) }
+            val maxSizeBytes = settings.maxAudioCacheSizeMB * 1024 * 1024
 
-            if (wavFiles != null) {
-                // 计算当前总大小
-                var currentSize = 0L
-                val fileWithLastModified = mutableListOf<Pair<File, Long>>()
+            val evictedPaths = diskQuota.evict(maxSizeBytes - incomingBytes)
+            if (evictedPaths.isEmpty()) {
+                return
+            }
 
-                for (file in wavFiles) {
-                    currentSize += file.length()
-                    fileWithLastModified.add(Pair(file, file.lastModified()))
+            var updatedCount = 0
+            val deletedFilePaths = mutableListOf<String>()
+            for (path in evictedPaths) {
+                val file = File(path)
+                if (eventLog.removeSegment(file)) {
+                    // 被淘汰段内的片段引用全部置空
+                    updatedCount += coughRecordDao.clearAudioFilePathsWithPrefix(EventLog.refPrefix(file))
+                } else if (file.delete() || !file.exists()) {
+                    deletedFilePaths.add(path)
+                } else {
+                    Log.w(TAG, "删除音频文件失败: $path")
                 }
+            }
 
-                Log.d(TAG, "当前音频缓存大小: ${currentSize / 1024 / 1024}MB, 限制大小: ${settings.maxAudioCacheSizeMB}MB")
-
-                // 如果当前大小超过了限制，则删除最旧的文件
-                if (currentSize > maxSizeBytes) {
-                    // 按最后修改时间排序，最旧的在前面
-                    fileWithLastModified.sortBy { it.second }
-
-                    // 多删除一些空间
-                    var sizeToDelete = currentSize - maxSizeBytes / 2
-                    var deletedSize = 0L
-                    val filesToDelete = mutableListOf<File>()
-
-                    // 收集需要删除的文件
-                    for ((file, _) in fileWithLastModified) {
-                        if (deletedSize < sizeToDelete) {
-                            filesToDelete.add(file)
-                            deletedSize += file.length()
-                        } else {
-                            break
-                        }
-                    }
-
-                    // 删除文件
-                    var actuallyDeletedSize = 0L
-                    val deletedFilePaths = mutableListOf<String>()
-                    for (file in filesToDelete) {
-                        val fileSize = file.length()
-                        if (file.delete()) {
-                            actuallyDeletedSize += fileSize
-                            deletedFilePaths.add(file.absolutePath)
-                            Log.d(TAG, "已删除旧音频文件: ${file.name}, 大小: ${fileSize / 1024}KB")
-                        } else {
-                            Log.w(TAG, "删除音频文件失败: ${file.absolutePath}")
-                        }
-                    }
-
-                    // 更新数据库中对应记录的audioFilePath字段为空
-                    if (deletedFilePaths.isNotEmpty()) {
-                        val updatedCount = coughRecordDao.clearAudioFilePaths(deletedFilePaths)
-                        Log.d(TAG, "已更新数据库中" + updatedCount + "条记录的audioFilePath字段为空")
-                    }
-
-                    Log.i(TAG, "磁盘空间管理完成: 计划删除${sizeToDelete / 1024 / 1024}MB, 实际删除${actuallyDeletedSize / 1024 / 1024}MB")
-                }
+            // 更新数据库中对应记录的audioFilePath字段为空
+            if (deletedFilePaths.isNotEmpty()) {
+                updatedCount += coughRecordDao.clearAudioFilePaths(deletedFilePaths)
             }
+
+            Log.i(TAG, "磁盘空间管理完成: 淘汰${evictedPaths.size}项, 更新${updatedCount}条记录, " +
+                    "当前大小: ${diskQuota.totalBytes / 1024 / 1024}MB, 限制大小: ${settings.maxAudioCacheSizeMB}MB")
         } catch (e: Exception) {
             Log.e(TAG, "磁盘空间管理失败", e)
         }
@@ -619,78 +604,6 @@ class CoughDetectionRepository(private val context: Context) {
         }
     }
 
-    private fun saveAudioDataToFile(filePath: String, audioData: FloatArray): Boolean {
-        return try {
-            java.io.FileOutputStream(filePath).use { fos ->
-                // Convert float array to 16-bit PCM
-                val shortBuffer = ShortArray(audioData.size)
-                for (i in audioData.indices) {
-                    // Clamp the value between -1.0 and 1.0
-                    val clampedValue = audioData[i].coerceIn(-1.0f, 1.0f)
-                    // Convert to 16-bit PCM (-32768 to 32767)
-                    shortBuffer[i] = (clampedValue * 32767).toInt().toShort()
-                }
-
-                // Write WAV header and audio data
-                writeWavHeader(fos, shortBuffer.size * 2, 16000, 1, 16)
-
-                // Write audio data
-                for (sample in shortBuffer) {
-                    fos.write(sample.toInt() and 0xFF)
-                    fos.write((sample.toInt() ushr 8) and 0xFF)
-                }
-            }
-
-            Log.d(TAG, "✅ 音频文件保存成功: $filePath, 大小: ${java.io.File(filePath).length()} bytes")
-            true
-        } catch (e: Exception) {
-            Log.e(TAG, "❌ 保存音频文件失败: $filePath", e)
-            false
-        }
-    }
-
-    private fun writeWavHeader(
-        out: java.io.OutputStream,
-        audioLength: Int,
-        sampleRate: Int,
-        channels: Int,
-        bitsPerSample: Int
-    ) {
-        val byteRate = sampleRate * channels * bitsPerSample / 8
-        val blockAlign = channels * bitsPerSample / 8
-
-        // RIFF header
-        out.write("RIFF".toByteArray())
-        writeInt(out, 36 + audioLength) // Chunk size
-        out.write("WAVE".toByteArray())
-
-        // Format chunk
-        out.write("fmt ".toByteArray())
-        writeInt(out, 16) // Subchunk1 size
-        writeShort(out, 1.toShort()) // Audio format (1 = PCM)
-        writeShort(out, channels.toShort()) // Number of channels
-        writeInt(out, sampleRate) // Sample rate
-        writeInt(out, byteRate) // Byte rate
-        writeShort(out, blockAlign.toShort()) // Block align
-        writeShort(out, bitsPerSample.toShort()) // Bits per sample
-
-        // Data chunk
-        out.write("data".toByteArray())
-        writeInt(out, audioLength) // Data chunk size
-    }
-
-    private fun writeInt(out: java.io.OutputStream, value: Int) {
-        out.write(value and 0xFF)
-        out.write((value ushr 8) and 0xFF)
-        out.write((value ushr 16) and 0xFF)
-        out.write((value ushr 24) and 0xFF)
-    }
-
-    private fun writeShort(out: java.io.OutputStream, value: Short) {
-        out.write(value.toInt() and 0xFF)
-        out.write((value.toInt() ushr 8) and 0xFF)
-    }
-
     private fun clearAudioBuffer() {
         currentAudioBuffer.clear()
         coughStartTime = 0L
@@ -701,6 +614,20 @@ class CoughDetectionRepository(private val context: Context) {
         return coughRecordDao.getAllRecords()
     }
 
+    /**
+     * 回放过的音频在配额淘汰时最后考虑；配额清单追加写盘，首次访问还会重放清单，都在 IO 线程执行
+     */
+    suspend fun markPlayed(audioFilePath: String) {
+        withContext(Dispatchers.IO) {
+            try {
+                val file = EventLog.ClipRef.parse(audioFilePath)?.file ?: java.io.File(audioFilePath)
+                diskQuota.touch(file.absolutePath)
+            } catch (e: Exception) {
+                Log.w(TAG, "更新音频访问时间失败: $audioFilePath", e)
+            }
+        }
+    }
+
     suspend fun getCoughRecordById(id: Long): CoughRecord? {
         return coughRecordDao.getRecordById(id)
     }
@@ -710,13 +637,19 @@ class CoughDetectionRepository(private val context: Context) {
         withContext(Dispatchers.IO) {
             try {
                 // Delete audio file only if path is not empty
-                if (record.audioFilePath.isNotEmpty()) {
+                val clipRef = EventLog.ClipRef.parse(record.audioFilePath)
+                if (clipRef != null) {
+                    // 事件日志只追加，片段标记删除，空间随所在段一起回收
+                    val marked = eventLog.markDeleted(clipRef)
+                    Log.d(TAG, "标记事件日志片段删除${if (marked) "成功" else "失败"}: ${record.audioFilePath}")
+                } else if (record.audioFilePath.isNotEmpty()) {
                     val audioFile = java.io.File(record.audioFilePath)
                     Log.d(TAG, "删除音频文件: ${record.audioFilePath}, 文件存在: ${audioFile.exists()}")
                     if (audioFile.exists()) {
                         val deleted = audioFile.delete()
                         Log.d(TAG, "音频文件删除${if (deleted) "成功" else "失败"}: ${record.audioFilePath}")
                     }
+                    diskQuota.remove(record.audioFilePath)
                 } else {
                     Log.d(TAG, "记录 ${record.id} 没有关联的音频文件")
                 }
@@ -743,6 +676,9 @@ class CoughDetectionRepository(private val context: Context) {
 
                 // Delete audio files only if they exist
                 records.forEach { record ->
+                    if (EventLog.isClipRef(record.audioFilePath)) {
+                        return@forEach // 事件日志片段随日志整体清空
+                    }
                     if (record.audioFilePath.isNotEmpty()) {
                         val audioFile = java.io.File(record.audioFilePath)
                         Log.d(TAG, "删除音频文件: ${record.audioFilePath}, 文件存在: ${audioFile.exists()}")
@@ -750,11 +686,15 @@ class CoughDetectionRepository(private val context: Context) {
                             val deleted = audioFile.delete()
                             Log.d(TAG, "音频文件删除${if (deleted) "成功" else "失败"}: ${record.audioFilePath}")
                         }
+                        diskQuota.remove(record.audioFilePath)
                     } else {
                         Log.d(TAG, "记录 ${record.id} 没有关联的音频文件，跳过")
                     }
                 }
 
+                eventLog.clear()
+                diskQuota.sync(eventLog.directory, eventLog.segmentSizes())
+
                 // Clear database
                 coughRecordDao.deleteAllRecords()
 
@@ -776,6 +716,15 @@ class CoughDetectionRepository(private val context: Context) {
         return coughRecordDao.getRecordsInTimeRange(startTime, endTime)
     }
 
+    /**
+     * 直接从事件日志索引查询时间范围内的事件，不经过数据库
+     */
+    suspend fun getLoggedEventsInTimeRange(startTime: Long, endTime: Long): List<EventLog.Entry> {
+        return withContext(Dispatchers.IO) {
+            eventLog.query(startTime, endTime)
+        }
+    }
+
     suspend fun getAverageConfidence(): Float? {
         return coughRecordDao.getAverageConfidence()
     }
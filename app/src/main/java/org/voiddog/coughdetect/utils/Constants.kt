@@ -8,6 +8,7 @@ object Constants {
     // Audio Configuration
     object Audio {
         const val SAMPLE_RATE = 16000 // 16kHz sample rate
+        const val PREFERRED_CAPTURE_SAMPLE_RATE = 48000 // native rate when the device doesn't report one
         const val CHANNEL_COUNT = 1 // Mono
         const val BITS_PER_SAMPLE = 16 // 16-bit PCM
         const val BUFFER_SIZE_FACTOR = 2
@@ -48,9 +49,14 @@ object Constants {
     object Storage {
         const val AUDIO_DIRECTORY = "cough_audio"
         const val AUDIO_FILE_EXTENSION = ".wav"
+        const val COMPRESSED_AUDIO_FILE_EXTENSION = ".flac" // 无损压缩片段
         const val DATE_FORMAT_FILENAME = "yyyyMMdd_HHmmss_SSS"
         const val DATE_FORMAT_DISPLAY = "yyyy-MM-dd HH:mm:ss"
         const val MAX_STORAGE_SIZE_MB = 500 // 500MB max storage
+        const val EVENT_LOG_DIRECTORY = "event_log" // 分段事件日志目录
+        const val EVENT_LOG_SEGMENT_SIZE_MB = 4 // 单个日志段的大小上限，也是淘汰的粒度
+        const val LEGACY_AUDIO_DIRECTORY = "audio_events" // 旧版本按事件单独保存的音频
+        const val QUOTA_MANIFEST_FILE = "storage_quota.manifest" // 配额索引清单
     }
     
     // UI
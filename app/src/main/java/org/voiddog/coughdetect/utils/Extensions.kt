@@ -260,7 +260,9 @@ fun File.getSizeInMB(): Double {
 }
 
 fun File.isAudioFile(): Boolean {
-    return name.lowercase().endsWith(Constants.Storage.AUDIO_FILE_EXTENSION)
+    val lowerName = name.lowercase()
+    return lowerName.endsWith(Constants.Storage.AUDIO_FILE_EXTENSION) ||
+        lowerName.endsWith(Constants.Storage.COMPRESSED_AUDIO_FILE_EXTENSION)
 }
 
 // MediaPlayer Extensions
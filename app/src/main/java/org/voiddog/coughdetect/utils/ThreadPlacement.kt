@@ -0,0 +1,230 @@
+package org.voiddog.coughdetect.utils
+
+import android.content.Context
+import android.os.Build
+import android.os.PerformanceHintManager
+import android.os.Process
+import android.util.Log
+import java.io.File
+import java.util.Collections
+import java.util.WeakHashMap
+
+/**
+ * 采集、分析和 I/O 线程的放置策略
+ *
+ * Java 层不能设置 CPU 亲和性，能用的手段是线程优先级和系统的性能提示：
+ * - 采集线程用 URGENT_AUDIO，分帧线程用 AUDIO，它们所在的核尽量不被其他线程抢占；
+ * - 打分线程稳态下用略低于默认的优先级，负载小的线程由 EAS 调度器留在能效核上；
+ *   模型推理期间通过 [Burst] 在 Android 12+ 用 PerformanceHintManager 报告实际耗时，
+ *   耗时逼近目标时系统会提频或把线程迁到性能核；
+ * - 分发和文件写入线程用 BACKGROUND，不和采集线程争抢同一个核。
+ *
+ * 各核的容量从 sysfs 读取（cpu_capacity，没有时用最高频率），用来区分能效核和性能核。
+ * 只有存在更快的核时 [Burst] 才在推理期间提升优先级；单一类型核心的设备上提升优先级
+ * 没有更快的核可迁，只会和采集线程争抢，这时只保留性能提示。
+ * 登记过的线程可以通过 [snapshot] 查看唤醒次数、迁移次数和最近运行的核（来自 /proc，读不到时为 -1）。
+ */
+object ThreadPlacement {
+
+    private const val TAG = "ThreadPlacement"
+    private const val CPU_ROOT = "/sys/devices/system/cpu"
+
+    enum class Role(val priority: Int) {
+        CAPTURE(Process.THREAD_PRIORITY_URGENT_AUDIO),
+        FRAMING(Process.THREAD_PRIORITY_AUDIO),
+        ANALYSIS(Process.THREAD_PRIORITY_DEFAULT + Process.THREAD_PRIORITY_LESS_FAVORABLE),
+        IO(Process.THREAD_PRIORITY_BACKGROUND)
+    }
+
+    data class Core(val cpu: Int, val capacity: Long, val efficient: Boolean)
+
+    data class ThreadStats(
+        val role: Role,
+        val name: String,
+        val tid: Int,
+        val wakeups: Long,
+        val migrations: Long,
+        // 最近运行的核，以及它是否为能效核（读不到时为 -1 / null）
+        val cpu: Int,
+        val onEfficientCore: Boolean?
+    )
+
+    private class Registration(val role: Role, val tid: Int)
+
+    // 线程退出后自动移除
+    private val threads = Collections.synchronizedMap(WeakHashMap<Thread, Registration>())
+
+    /**
+     * 各核的容量；单一类型核心的设备上全部不是能效核
+     */
+    val cores: List<Core> by lazy { readCores(File(CPU_ROOT)) }
+
+    /**
+     * 把当前线程设置为 [role] 的优先级并登记，只在线程开始时调用一次
+     */
+    fun apply(role: Role) {
+        try {
+            Process.setThreadPriority(role.priority)
+        } catch (e: Exception) {
+            // 部分机型不允许提升到音频优先级
+            Log.w(TAG, "设置线程优先级失败: ${Thread.currentThread().name} -> $role: ${e.message}")
+        }
+        threads[Thread.currentThread()] = Registration(role, Process.myTid())
+    }
+
+    fun snapshot(): List<ThreadStats> {
+        val registered = synchronized(threads) { threads.entries.map { it.key to it.value } }
+        val coreList = cores
+        return registered.filter { it.first.isAlive }.map { (thread, registration) ->
+            val counters = readSchedCounters(registration.tid)
+            val cpu = readLastCpu(registration.tid)
+            ThreadStats(
+                role = registration.role,
+                name = thread.name,
+                tid = registration.tid,
+                wakeups = counters[0],
+                migrations = counters[1],
+                cpu = cpu,
+                onEfficientCore = coreList.firstOrNull { it.cpu == cpu }?.efficient
+            )
+        }
+    }
+
+    /**
+     * 存在容量更大的核时，推理期间提升优先级才有意义（EAS 会把线程迁过去）
+     */
+    internal fun hasFasterCores(cores: List<Core>): Boolean = cores.any { it.efficient }
+
+    /**
+     * 模型推理的提升：有更快的核时 [begin] 到 [end] 之间线程用更高的优先级，结束时把实际耗时
+     * 报告给 PerformanceHintManager（Android 12+）。只能在同一个线程上使用，会话和核心布局
+     * 在第一次 [begin] 时读取。
+     */
+    class Burst(private val context: Context, private val steady: Role) {
+
+        private var session: PerformanceHintManager.Session? = null
+        private var sessionTried = false
+        private var raisePriority = false
+        private var targetNanos = 0L
+
+        fun begin() {
+            if (!sessionTried) {
+                sessionTried = true
+                session = createSession()
+                raisePriority = hasFasterCores(cores)
+                Log.i(TAG, "ℹ️ 推理提升: ${if (raisePriority) "提升优先级 + 性能提示" else "仅性能提示（单一类型核心）"}")
+            }
+            if (!raisePriority) return
+            try {
+                Process.setThreadPriority(BURST_PRIORITY)
+            } catch (e: Exception) {
+                // 保持稳态优先级
+            }
+        }
+
+        /**
+         * 推理结束，耗时 [actualNanos]，希望在 [targetNanos] 内完成
+         */
+        fun end(actualNanos: Long, targetNanos: Long) {
+            if (raisePriority) {
+                try {
+                    Process.setThreadPriority(steady.priority)
+                } catch (e: Exception) {
+                    // 保持当前优先级
+                }
+            }
+            val current = session ?: return
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.S && actualNanos > 0L && targetNanos > 0L) {
+                if (targetNanos != this.targetNanos) {
+                    current.updateTargetWorkDuration(targetNanos)
+                    this.targetNanos = targetNanos
+                }
+                current.reportActualWorkDuration(actualNanos)
+            }
+        }
+
+        fun close() {
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.S) {
+                session?.close()
+            }
+            session = null
+            sessionTried = false
+            raisePriority = false
+            targetNanos = 0L
+        }
+
+        private fun createSession(): PerformanceHintManager.Session? {
+            if (Build.VERSION.SDK_INT < Build.VERSION_CODES.S) return null
+            return try {
+                val manager = context.getSystemService(PerformanceHintManager::class.java) ?: return null
+                // 初始目标随第一次报告更新
+                manager.createHintSession(intArrayOf(Process.myTid()), INITIAL_TARGET_NANOS).also {
+                    if (it == null) Log.i(TAG, "ℹ️ 设备不支持性能提示")
+                }
+            } catch (e: Exception) {
+                Log.w(TAG, "创建性能提示会话失败: ${e.message}")
+                null
+            }
+        }
+
+        private companion object {
+            const val BURST_PRIORITY = Process.THREAD_PRIORITY_DISPLAY
+            const val INITIAL_TARGET_NANOS = 100_000_000L
+        }
+    }
+
+    internal fun readCores(root: File): List<Core> {
+        val dirs = root.listFiles { file -> file.isDirectory && file.name.matches(Regex("cpu\\d+")) } ?: return emptyList()
+        val capacities = dirs.mapNotNull { dir ->
+            val capacity = readLong(File(dir, "cpu_capacity")) ?: readLong(File(dir, "cpufreq/cpuinfo_max_freq"))
+            capacity?.let { dir.name.removePrefix("cpu").toInt() to it }
+        }.sortedBy { it.first }
+        val max = capacities.maxOfOrNull { it.second } ?: return emptyList()
+        return capacities.map { (cpu, capacity) -> Core(cpu, capacity, capacity < max) }
+    }
+
+    // [wakeups, migrations]；sched 需要内核开启 SCHED_DEBUG，没有时唤醒次数退回主动切换次数
+    private fun readSchedCounters(tid: Int): LongArray {
+        val counters = parseSchedCounters(readText(File("/proc/self/task/$tid/sched")))
+        if (counters[0] < 0L) {
+            readText(File("/proc/self/task/$tid/status"))?.lineSequence()
+                ?.firstOrNull { it.startsWith("voluntary_ctxt_switches:") }
+                ?.let { counters[0] = it.substringAfter(':').trim().toLongOrNull() ?: -1L }
+        }
+        return counters
+    }
+
+    internal fun parseSchedCounters(text: String?): LongArray {
+        val counters = longArrayOf(-1L, -1L)
+        text?.lineSequence()?.forEach { line ->
+            val key = line.substringBefore(':').trim()
+            val value = line.substringAfter(':', "").trim()
+            when (key) {
+                "nr_wakeups" -> counters[0] = value.toLongOrNull() ?: -1L
+                "se.nr_migrations" -> counters[1] = value.toLongOrNull() ?: -1L
+            }
+        }
+        return counters
+    }
+
+    private fun readLastCpu(tid: Int): Int {
+        val stat = readText(File("/proc/self/task/$tid/stat")) ?: return -1
+        return parseLastCpu(stat)
+    }
+
+    // /proc/<pid>/stat 的第 39 个字段；线程名可能含空格，从最后一个右括号之后开始数（第 3 个字段起）
+    internal fun parseLastCpu(stat: String): Int {
+        val fields = stat.substringAfterLast(')').trim().split(' ')
+        return fields.getOrNull(39 - 3)?.toIntOrNull() ?: -1
+    }
+
+    private fun readLong(file: File): Long? = readText(file)?.trim()?.toLongOrNull()
+
+    private fun readText(file: File): String? {
+        return try {
+            if (file.canRead()) file.readText() else null
+        } catch (e: Exception) {
+            null
+        }
+    }
+}
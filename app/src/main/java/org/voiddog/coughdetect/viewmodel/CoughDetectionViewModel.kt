@@ -312,6 +312,7 @@ class CoughDetectionViewModel(application: Application) : AndroidViewModel(appli
                 val success = audioPlayer.playAudioFile(record.audioFilePath)
                 if (success) {
                     Log.d(TAG, "开始播放音频: ${record.audioFilePath}")
+                    repository.markPlayed(record.audioFilePath)
                 } else {
                     Log.e(TAG, "播放音频失败: ${record.audioFilePath}")
                 }
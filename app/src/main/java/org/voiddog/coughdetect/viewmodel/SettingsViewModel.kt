@@ -10,9 +10,9 @@ import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import org.voiddog.coughdetect.data.DiskQuotaManager
 import org.voiddog.coughdetect.data.Settings
 import org.voiddog.coughdetect.data.SettingsManager
-import java.io.File
 
 class SettingsViewModel(application: Application) : AndroidViewModel(application) {
     private val settingsManager = SettingsManager.getInstance(application)
@@ -55,21 +55,8 @@ class SettingsViewModel(application: Application) : AndroidViewModel(application
                 
                 // 在IO线程中进行计算
                 val currentSizeMB = withContext(Dispatchers.IO) {
-                    val audioDir = File(getApplication<Application>().filesDir, "audio_events")
-                    if (audioDir.exists()) {
-                        val wavFiles = audioDir.listFiles { file -> file.extension.equals("wav", ignoreCase = true) }
-                        if (wavFiles != null) {
-                            var currentSize = 0L
-                            for (file in wavFiles) {
-                                currentSize += file.length()
-                            }
-                            currentSize / (1024 * 1024) // 转换为MB
-                        } else {
-                            0L
-                        }
-                    } else {
-                        0L
-                    }
+                    // 配额管理器增量维护总大小，无需扫描目录
+                    DiskQuotaManager.getInstance(getApplication()).totalBytes / (1024 * 1024) // 转换为MB
                 }
                 
                 // 更新UI状态
@@ -0,0 +1,112 @@
+package org.voiddog.coughdetect.audio
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.util.Random
+import kotlin.math.PI
+import kotlin.math.cos
+import kotlin.math.exp
+import kotlin.math.sin
+
+class FlacCodecTest {
+
+    private fun speechLike(samples: Int, seed: Long): ShortArray {
+        val random = Random(seed)
+        return ShortArray(samples) { i ->
+            val t = i / 16000.0
+            val envelope = 0.5 + 0.5 * sin(2 * PI * 3.0 * t)
+            val voiced = 0.3 * sin(2 * PI * 180.0 * t) + 0.1 * sin(2 * PI * 720.0 * t)
+            val noise = random.nextGaussian() * 0.01
+            ((envelope * voiced + noise) * 32767).toInt().coerceIn(-32768, 32767).toShort()
+        }
+    }
+
+    @Test
+    fun roundTripIsLossless() {
+        val samples = speechLike(16000 * 3 + 123, 42L)
+        val encoded = FlacEncoder.encodeToByteArray(samples, 16000)
+        val decoded = FlacDecoder.decodeToShortArray(encoded)
+        assertArrayEquals(samples, decoded)
+    }
+
+    @Test
+    fun roundTripHandlesConstantAndNoiseBlocks() {
+        val random = Random(7L)
+        val samples = ShortArray(FlacEncoder.DEFAULT_BLOCK_SIZE * 3) { i ->
+            when (i / FlacEncoder.DEFAULT_BLOCK_SIZE) {
+                0 -> 0
+                1 -> random.nextInt(65536) - 32768 // 白噪声会退化为 VERBATIM
+                else -> -32768
+            }.toShort()
+        }
+        val decoded = FlacDecoder.decodeToShortArray(FlacEncoder.encodeToByteArray(samples, 16000))
+        assertArrayEquals(samples, decoded)
+    }
+
+    // 每秒一次衰减的咳嗽样爆发，其余时间是约 -60 dBFS 的底噪
+    private fun coughLike(samples: Int, seed: Long): ShortArray {
+        val random = Random(seed)
+        var lowPassed = 0.0
+        return ShortArray(samples) { i ->
+            val t = i / 16000.0
+            val phase = t % 1.0
+            val burst = if (phase < 0.35) 0.4 * exp(-phase * 12) else 0.0
+            lowPassed = 0.8 * lowPassed + 0.2 * random.nextGaussian()
+            val value = burst * (0.6 * sin(2 * PI * 220.0 * t) + 0.4 * lowPassed) + random.nextGaussian() * 0.001
+            (value * 32767).toInt().coerceIn(-32768, 32767).toShort()
+        }
+    }
+
+    @Test
+    fun compressesCoughClips() {
+        val samples = coughLike(16000 * 4, 1L)
+        val encoded = FlacEncoder.encodeToByteArray(samples, 16000)
+        val ratio = samples.size * 2.0 / encoded.size
+        // 实测约 1.85 倍：-60 dBFS 的白噪声底噪每个样本仍要约 7 位，底噪越低压缩率越高
+        assertTrue("compression ratio $ratio", ratio >= 1.8)
+    }
+
+    // 噪声激励的 500Hz 共振，二阶线性预测能完全描述，固定阶多项式预测不能
+    private fun resonant(samples: Int, seed: Long): ShortArray {
+        val random = Random(seed)
+        val a1 = 2 * 0.995 * cos(2 * PI * 500.0 / 16000)
+        val a2 = 0.995 * 0.995
+        var y1 = 0.0
+        var y2 = 0.0
+        return ShortArray(samples) {
+            val y = a1 * y1 - a2 * y2 + random.nextGaussian() * 100
+            y2 = y1
+            y1 = y
+            y.toInt().coerceIn(-32768, 32767).toShort()
+        }
+    }
+
+    @Test
+    fun lpcSubframesBeatFixedPredictors() {
+        val samples = resonant(16000 * 2, 11L)
+        val lpc = FlacEncoder.encodeToByteArray(samples, 16000)
+        val fixedOnly = FlacEncoder.encodeToByteArray(samples, 16000, maxLpcOrder = 0)
+        assertArrayEquals(samples, FlacDecoder.decodeToShortArray(lpc))
+        // 实测 LPC 约 1.71 倍，只用固定阶预测约 1.61 倍
+        assertTrue("lpc ${lpc.size} fixed ${fixedOnly.size}", lpc.size * 1.04 < fixedOnly.size)
+    }
+
+    @Test
+    fun seekLandsOnRequestedSample() {
+        val samples = speechLike(16000 * 5, 3L)
+        val decoder = FlacDecoder(ByteBuffer.wrap(FlacEncoder.encodeToByteArray(samples, 16000)))
+        assertEquals(samples.size.toLong(), decoder.totalSamples)
+
+        val target = 16000L * 3 + 17
+        decoder.seek(target)
+        val block = IntArray(decoder.maxBlockSize)
+        val n = decoder.readFrame(block)
+        assertTrue(n > 0)
+        for (i in 0 until n) {
+            assertEquals(samples[target.toInt() + i].toInt(), block[i])
+        }
+    }
+}
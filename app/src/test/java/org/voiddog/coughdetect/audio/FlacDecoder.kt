@@ -0,0 +1,355 @@
+package org.voiddog.coughdetect.audio
+
+import java.io.File
+import java.io.IOException
+import java.io.RandomAccessFile
+import java.nio.ByteBuffer
+import java.nio.channels.FileChannel
+
+/**
+ * 流式 FLAC 解码器（单声道，最多 24-bit）
+ *
+ * 测试用的参考解码器，校验 [FlacEncoder] 的输出能无损还原；线上的片段由 MediaPlayer 直接播放。
+ * 支持 CONSTANT / VERBATIM / FIXED / LPC 子帧和 Rice / Rice2 残差编码。输入是整段字节缓冲区
+ * （通常是内存映射的文件），按帧逐块解码；有 SEEKTABLE 时 [seek] 直接跳到最近的帧，否则从头顺序跳帧。
+ */
+class FlacDecoder(private val data: ByteBuffer) {
+
+    companion object {
+        private const val METADATA_TYPE_STREAMINFO = 0
+        private const val METADATA_TYPE_SEEKTABLE = 3
+        private const val PLACEHOLDER_SAMPLE = -1L
+
+        fun open(file: File): FlacDecoder {
+            RandomAccessFile(file, "r").use { raf ->
+                val buffer = raf.channel.map(FileChannel.MapMode.READ_ONLY, 0, raf.length())
+                return FlacDecoder(buffer)
+            }
+        }
+
+        /**
+         * 一次性解码整段 FLAC 字节流
+         */
+        fun decodeToShortArray(bytes: ByteArray): ShortArray {
+            val decoder = FlacDecoder(ByteBuffer.wrap(bytes))
+            val result = ShortArray(decoder.totalSamples.toInt())
+            val block = IntArray(decoder.maxBlockSize)
+            var position = 0
+            while (true) {
+                val n = decoder.readFrame(block)
+                if (n == 0) break
+                for (i in 0 until n) {
+                    result[position + i] = block[i].toShort()
+                }
+                position += n
+            }
+            return result
+        }
+    }
+
+    var sampleRate = 0
+        private set
+    var bitsPerSample = 0
+        private set
+    var totalSamples = 0L
+        private set
+    var maxBlockSize = 0
+        private set
+
+    private var seekSamples = LongArray(0)
+    private var seekOffsets = LongArray(0)
+    private var firstFrameOffset = 0
+
+    private var bytePosition = 0
+    private var cache = 0L
+    private var cacheBits = 0
+
+    private var currentSample = 0L
+    private var skipSamples = 0
+    private var residual = IntArray(0)
+
+    init {
+        readMetadata()
+    }
+
+    /**
+     * 解码下一帧到 [out]，返回样本数；流结束时返回 0。
+     * [out] 的长度至少为 [maxBlockSize]。
+     */
+    fun readFrame(out: IntArray): Int {
+        while (true) {
+            if (bytePosition + 2 > data.limit()) return 0
+            val decoded = decodeFrame(out)
+            currentSample += decoded
+            if (skipSamples == 0) return decoded
+            if (skipSamples >= decoded) {
+                skipSamples -= decoded
+                continue
+            }
+            // seek 目标落在帧内，丢弃帧头部分样本
+            val keep = decoded - skipSamples
+            System.arraycopy(out, skipSamples, out, 0, keep)
+            skipSamples = 0
+            return keep
+        }
+    }
+
+    /**
+     * 定位到指定样本，之后的 [readFrame] 从该样本开始输出
+     */
+    fun seek(sample: Long) {
+        require(sample in 0..totalSamples) { "Seek target out of range: $sample" }
+        var targetSample = 0L
+        var targetOffset = 0L
+        for (i in seekSamples.indices) {
+            if (seekSamples[i] == PLACEHOLDER_SAMPLE || seekSamples[i] > sample) break
+            targetSample = seekSamples[i]
+            targetOffset = seekOffsets[i]
+        }
+        bytePosition = firstFrameOffset + targetOffset.toInt()
+        cacheBits = 0
+        currentSample = targetSample
+        skipSamples = (sample - targetSample).toInt()
+    }
+
+    private fun readMetadata() {
+        if (readBits(32) != 0x664C6143) throw IOException("Not a FLAC stream")
+        var last = false
+        while (!last) {
+            last = readBits(1) == 1
+            val type = readBits(7)
+            val length = readBits(24)
+            val blockEnd = bytePosition + length
+            when (type) {
+                METADATA_TYPE_STREAMINFO -> {
+                    readBits(16) // min block size
+                    maxBlockSize = readBits(16)
+                    readBits(24) // min frame size
+                    readBits(24) // max frame size
+                    sampleRate = readBits(20)
+                    val channels = readBits(3) + 1
+                    bitsPerSample = readBits(5) + 1
+                    totalSamples = (readBits(4).toLong() shl 32) or (readBits(32).toLong() and 0xFFFFFFFFL)
+                    if (channels != 1) throw IOException("Only mono FLAC is supported, got $channels channels")
+                }
+                METADATA_TYPE_SEEKTABLE -> {
+                    val points = length / 18
+                    seekSamples = LongArray(points)
+                    seekOffsets = LongArray(points)
+                    for (i in 0 until points) {
+                        seekSamples[i] = readLong()
+                        seekOffsets[i] = readLong()
+                        readBits(16)
+                    }
+                }
+            }
+            bytePosition = blockEnd
+            cacheBits = 0
+        }
+        firstFrameOffset = bytePosition
+        if (maxBlockSize == 0) throw IOException("Missing STREAMINFO")
+        residual = IntArray(maxBlockSize)
+    }
+
+    private fun decodeFrame(out: IntArray): Int {
+        val frameStart = bytePosition
+        val sync = readBits(16)
+        if (sync and 0xFFFE != 0xFFF8) throw IOException("Lost frame sync at $frameStart")
+        val blockSizeCode = readBits(4)
+        val sampleRateCode = readBits(4)
+        val channelAssignment = readBits(4)
+        val sampleSizeCode = readBits(3)
+        readBits(1)
+        readUtf8()
+
+        val blockSize = when (blockSizeCode) {
+            1 -> 192
+            in 2..5 -> 576 shl (blockSizeCode - 2)
+            6 -> readBits(8) + 1
+            7 -> readBits(16) + 1
+            in 8..15 -> 256 shl (blockSizeCode - 8)
+            else -> throw IOException("Reserved block size code")
+        }
+        when (sampleRateCode) {
+            12 -> readBits(8)
+            13, 14 -> readBits(16)
+        }
+        val bps = when (sampleSizeCode) {
+            0 -> bitsPerSample
+            1 -> 8
+            2 -> 12
+            4 -> 16
+            5 -> 20
+            6 -> 24
+            else -> throw IOException("Reserved sample size code")
+        }
+        val headerCrc = readBits(8)
+        if (headerCrc != FlacCrc.crc8(data, frameStart, bytePosition - 1)) {
+            throw IOException("Frame header CRC mismatch at $frameStart")
+        }
+        if (channelAssignment != 0) throw IOException("Only mono frames are supported")
+        if (blockSize > out.size) throw IOException("Block size $blockSize exceeds buffer")
+
+        decodeSubframe(out, blockSize, bps)
+
+        cacheBits = 0 // 帧尾按字节对齐
+        val crcEnd = bytePosition
+        val frameCrc = readBits(16)
+        if (frameCrc != FlacCrc.crc16(data, frameStart, crcEnd)) {
+            throw IOException("Frame CRC mismatch at $frameStart")
+        }
+        return blockSize
+    }
+
+    private fun decodeSubframe(out: IntArray, blockSize: Int, frameBps: Int) {
+        readBits(1)
+        val type = readBits(6)
+        var wasted = 0
+        if (readBits(1) == 1) {
+            wasted = readUnary() + 1
+        }
+        val bps = frameBps - wasted
+
+        when {
+            type == 0 -> {
+                val value = readSigned(bps)
+                for (i in 0 until blockSize) out[i] = value
+            }
+            type == 1 -> {
+                for (i in 0 until blockSize) out[i] = readSigned(bps)
+            }
+            type in 8..12 -> {
+                val order = type and 0x07
+                for (i in 0 until order) out[i] = readSigned(bps)
+                readResidual(blockSize, order)
+                restoreFixed(out, blockSize, order)
+            }
+            type >= 32 -> {
+                val order = (type and 0x1F) + 1
+                for (i in 0 until order) out[i] = readSigned(bps)
+                val precision = readBits(4) + 1
+                val shift = readSigned(5)
+                val coefficients = IntArray(order) { readSigned(precision) }
+                readResidual(blockSize, order)
+                restoreLpc(out, blockSize, coefficients, shift)
+            }
+            else -> throw IOException("Reserved subframe type $type")
+        }
+
+        if (wasted > 0) {
+            for (i in 0 until blockSize) out[i] = out[i] shl wasted
+        }
+    }
+
+    private fun readResidual(blockSize: Int, order: Int) {
+        val method = readBits(2)
+        if (method > 1) throw IOException("Reserved residual coding method")
+        val paramBits = if (method == 0) 4 else 5
+        val escape = (1 shl paramBits) - 1
+        val partitionOrder = readBits(4)
+        val partitions = 1 shl partitionOrder
+        val partitionSize = blockSize shr partitionOrder
+        var index = order
+        for (p in 0 until partitions) {
+            val end = (p + 1) * partitionSize
+            val k = readBits(paramBits)
+            if (k == escape) {
+                val rawBits = readBits(5)
+                while (index < end) {
+                    residual[index++] = if (rawBits == 0) 0 else readSigned(rawBits)
+                }
+            } else {
+                while (index < end) {
+                    val folded = (readUnary() shl k) or readBits(k)
+                    residual[index++] = (folded ushr 1) xor -(folded and 1)
+                }
+            }
+        }
+    }
+
+    private fun restoreFixed(out: IntArray, blockSize: Int, order: Int) {
+        val r = residual
+        when (order) {
+            0 -> for (i in 0 until blockSize) out[i] = r[i]
+            1 -> for (i in 1 until blockSize) out[i] = r[i] + out[i - 1]
+            2 -> for (i in 2 until blockSize) out[i] = r[i] + 2 * out[i - 1] - out[i - 2]
+            3 -> for (i in 3 until blockSize) out[i] = r[i] + 3 * out[i - 1] - 3 * out[i - 2] + out[i - 3]
+            4 -> for (i in 4 until blockSize) {
+                out[i] = r[i] + 4 * out[i - 1] - 6 * out[i - 2] + 4 * out[i - 3] - out[i - 4]
+            }
+        }
+    }
+
+    private fun restoreLpc(out: IntArray, blockSize: Int, coefficients: IntArray, shift: Int) {
+        val order = coefficients.size
+        for (i in order until blockSize) {
+            var sum = 0L
+            for (j in 0 until order) {
+                sum += coefficients[j].toLong() * out[i - 1 - j]
+            }
+            out[i] = residual[i] + (sum shr shift).toInt()
+        }
+    }
+
+    private fun readBits(bits: Int): Int {
+        if (bits == 0) return 0
+        while (cacheBits < bits) {
+            cache = (cache shl 8) or (data.get(bytePosition++).toLong() and 0xFF)
+            cacheBits += 8
+        }
+        cacheBits -= bits
+        return ((cache ushr cacheBits) and ((1L shl bits) - 1)).toInt()
+    }
+
+    private fun readSigned(bits: Int): Int {
+        if (bits == 0) return 0
+        val value = readBits(bits)
+        return (value shl (32 - bits)) shr (32 - bits)
+    }
+
+    private fun readLong(): Long {
+        val high = readBits(32).toLong() and 0xFFFFFFFFL
+        val low = readBits(32).toLong() and 0xFFFFFFFFL
+        return (high shl 32) or low
+    }
+
+    private fun readUnary(): Int {
+        var count = 0
+        while (true) {
+            if (cacheBits == 0) {
+                cache = (cache shl 8) or (data.get(bytePosition++).toLong() and 0xFF)
+                cacheBits = 8
+            }
+            val window = cache and ((1L shl cacheBits) - 1)
+            if (window == 0L) {
+                count += cacheBits
+                cacheBits = 0
+                continue
+            }
+            val leadingZeros = java.lang.Long.numberOfLeadingZeros(window) - (64 - cacheBits)
+            count += leadingZeros
+            cacheBits -= leadingZeros + 1
+            return count
+        }
+    }
+
+    private fun readUtf8(): Long {
+        val first = readBits(8)
+        var extra = 0
+        var value: Long
+        when {
+            first and 0x80 == 0 -> value = first.toLong()
+            first and 0xE0 == 0xC0 -> { extra = 1; value = (first and 0x1F).toLong() }
+            first and 0xF0 == 0xE0 -> { extra = 2; value = (first and 0x0F).toLong() }
+            first and 0xF8 == 0xF0 -> { extra = 3; value = (first and 0x07).toLong() }
+            first and 0xFC == 0xF8 -> { extra = 4; value = (first and 0x03).toLong() }
+            first and 0xFE == 0xFC -> { extra = 5; value = (first and 0x01).toLong() }
+            first == 0xFE -> { extra = 6; value = 0L }
+            else -> throw IOException("Invalid UTF-8 coded frame number")
+        }
+        repeat(extra) {
+            value = (value shl 6) or (readBits(8) and 0x3F).toLong()
+        }
+        return value
+    }
+}
@@ -0,0 +1,112 @@
+package org.voiddog.coughdetect.audio
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import kotlin.math.PI
+import kotlin.math.log10
+import kotlin.math.sin
+import kotlin.math.sqrt
+
+class PolyphaseResamplerTest {
+
+    private fun sine(hz: Double, rate: Int, size: Int) =
+        FloatArray(size) { i -> 0.5f * sin(2 * PI * hz * i / rate).toFloat() }
+
+    private fun resample(resampler: PolyphaseResampler, input: FloatArray): FloatArray {
+        val output = FloatArray(resampler.maxOutputSize(input.size))
+        val count = resampler.process(input, 0, input.size, output)
+        return output.copyOf(count)
+    }
+
+    // 跳过开头的滤波器建立期，只看稳态部分的幅度（相对输入正弦的 RMS）
+    private fun steadyGain(output: FloatArray): Double {
+        var sum = 0.0
+        val from = output.size / 4
+        for (i in from until output.size) {
+            sum += output[i] * output[i]
+        }
+        return sqrt(sum / (output.size - from)) / (0.5 / sqrt(2.0))
+    }
+
+    @Test
+    fun keepsPassbandTones() {
+        for (rate in intArrayOf(48000, 44100)) {
+            for (hz in doubleArrayOf(1000.0, 6000.0)) {
+                val resampler = PolyphaseResampler(rate, 16000)
+                val output = resample(resampler, sine(hz, rate, rate / 4))
+                assertEquals("$rate Hz, tone $hz Hz", 1.0, steadyGain(output), 0.01)
+            }
+        }
+    }
+
+    @Test
+    fun rejectsTonesAboveOutputNyquist() {
+        for (hz in doubleArrayOf(10000.0, 12000.0)) {
+            val resampler = PolyphaseResampler(48000, 16000)
+            val output = resample(resampler, sine(hz, 48000, 12000))
+            // 至少 60dB 衰减，否则会混叠回 4~6kHz
+            assertTrue("tone $hz Hz leaked", steadyGain(output) < 1e-3)
+        }
+    }
+
+    @Test
+    fun presetsRejectAliasingTones() {
+        // 各档在 10kHz 和 12kHz 处的衰减至少为 55/75/95dB（按滤波器系数算出的值分别在 59/80/107dB 以上）
+        val limits = mapOf(
+            PolyphaseResampler.Quality.LOW to 55.0,
+            PolyphaseResampler.Quality.MEDIUM to 75.0,
+            PolyphaseResampler.Quality.HIGH to 95.0
+        )
+        for ((quality, db) in limits) {
+            for (hz in doubleArrayOf(10000.0, 12000.0)) {
+                val output = resample(PolyphaseResampler(48000, 16000, quality), sine(hz, 48000, 12000))
+                val attenuation = -20 * log10(steadyGain(output))
+                assertTrue("$quality tone $hz Hz: $attenuation dB", attenuation >= db)
+            }
+        }
+    }
+
+    @Test
+    fun outputLengthFollowsRatio() {
+        val resampler = PolyphaseResampler(48000, 16000)
+        assertEquals(4000, resample(resampler, FloatArray(12000)).size)
+
+        val cd = PolyphaseResampler(44100, 16000)
+        var total = 0
+        repeat(10) { total += resample(cd, FloatArray(4410)).size }
+        assertEquals(16000, total)
+    }
+
+    @Test
+    fun chunkedMatchesOneShot() {
+        val input = sine(900.0, 48000, 9600)
+        val expected = resample(PolyphaseResampler(48000, 16000), input)
+
+        val resampler = PolyphaseResampler(48000, 16000)
+        val output = FloatArray(expected.size)
+        var produced = 0
+        var offset = 0
+        val chunks = intArrayOf(1, 7, 480, 1000, 333)
+        var index = 0
+        while (offset < input.size) {
+            val length = minOf(chunks[index++ % chunks.size], input.size - offset)
+            produced += resampler.process(input, offset, length, output, produced)
+            offset += length
+        }
+
+        assertEquals(expected.size, produced)
+        assertArrayEquals(expected, output, 0f)
+    }
+
+    @Test
+    fun resetClearsHistory() {
+        val resampler = PolyphaseResampler(48000, 16000)
+        val first = resample(resampler, sine(1000.0, 48000, 4800))
+        resample(resampler, sine(3000.0, 48000, 1234))
+
+        resampler.reset()
+        assertArrayEquals(first, resample(resampler, sine(1000.0, 48000, 4800)), 0f)
+    }
+}
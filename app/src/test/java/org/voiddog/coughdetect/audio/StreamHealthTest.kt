@@ -0,0 +1,84 @@
+package org.voiddog.coughdetect.audio
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Test
+
+class StreamHealthTest {
+
+    companion object {
+        private const val RATE = 16000
+        private const val READ_FRAMES = 1600 // 100ms
+        private const val READ_NANOS = 100_000_000L
+    }
+
+    @Test
+    fun steadyReadsHaveNoJitterOrXruns() {
+        val health = StreamHealth()
+        health.start(RATE, READ_FRAMES * 2)
+        var now = 1_000_000L
+        repeat(10) {
+            health.recordRead(READ_FRAMES, READ_FRAMES, now)
+            health.recordProcessingTime(300_000L)
+            now += READ_NANOS
+        }
+
+        val snapshot = health.snapshot()
+        assertEquals(10L * READ_FRAMES, snapshot.framesRead)
+        assertEquals(10L * READ_FRAMES, snapshot.framesExpected)
+        assertEquals(0L, snapshot.xrunCount)
+        // 9 个间隔都落在第一个桶（抖动 0）
+        assertEquals(9L, snapshot.intervalJitterHistogram[0])
+        // 300us 落在 (250, 500] 桶
+        assertEquals(10L, snapshot.processingTimeHistogram[2])
+    }
+
+    @Test
+    fun lateReaderCountsXrunOnceBacklogExceedsBuffer() {
+        val health = StreamHealth()
+        health.start(RATE, READ_FRAMES * 2)
+        var now = 1_000_000L
+        health.recordRead(READ_FRAMES, READ_FRAMES, now)
+        // 读取方卡住 400ms：积压 3 个读取块，超过 2 块的缓冲区
+        now += 4 * READ_NANOS
+        health.recordRead(READ_FRAMES, READ_FRAMES, now)
+        assertEquals(1L, health.getXrunCount())
+        assertEquals(4L * READ_FRAMES + READ_FRAMES, health.snapshot().framesExpected)
+
+        // 之后立即读走积压的数据不会再计数
+        now += 1_000_000L
+        health.recordRead(READ_FRAMES, READ_FRAMES, now)
+        assertEquals(1L, health.getXrunCount())
+        // 300ms 的偏差落在最后一个桶
+        assertEquals(1L, health.snapshot().intervalJitterHistogram.last())
+    }
+
+    @Test
+    fun pauseDoesNotCountAsXrun() {
+        val health = StreamHealth()
+        health.start(RATE, READ_FRAMES * 2)
+        health.recordRead(READ_FRAMES, READ_FRAMES, 1_000_000L)
+        health.markDiscontinuity()
+        health.recordRead(READ_FRAMES, READ_FRAMES, 10_000_000_000L)
+
+        assertEquals(0L, health.getXrunCount())
+        assertEquals(2L * READ_FRAMES, health.snapshot().framesExpected)
+    }
+
+    @Test
+    fun inputLatencyFromTimestamp() {
+        val health = StreamHealth()
+        assertEquals(StreamHealth.UNKNOWN_LATENCY, health.getInputLatencyUs())
+        health.start(RATE, READ_FRAMES * 2)
+        // 第 16000 帧在 t=1s 采集；已读到 16160 帧（再往后 10ms），此刻 t=1.03s
+        health.updateInputLatency(16000L, 1_000_000_000L, 16160L, 1_030_000_000L)
+        assertEquals(20_000L, health.getInputLatencyUs())
+    }
+
+    @Test
+    fun histogramBucketsAreInclusiveUpperBounds() {
+        val histogram = StreamHealth.Histogram(longArrayOf(10, 100))
+        longArrayOf(0, 10, 11, 100, 101, 5000).forEach { histogram.record(it) }
+        assertArrayEquals(longArrayOf(2, 2, 2), histogram.counts())
+    }
+}
@@ -0,0 +1,234 @@
+package org.voiddog.coughdetect.bench
+
+import org.junit.Assume.assumeTrue
+import org.junit.Test
+import org.voiddog.coughdetect.audio.FlacEncoder
+import org.voiddog.coughdetect.ml.AudioFeatures
+import org.voiddog.coughdetect.ml.RuleBasedDetector
+import java.io.File
+import java.util.Locale
+
+/**
+ * 带标注语料上的准确率 + 开销回归测试
+ *
+ * 语料目录（-PbenchCorpus=<dir>）中每个 16kHz WAV 旁边放一个同名 CSV，每行一个咳嗽片段：
+ *   start_seconds,end_seconds[,label]
+ * 允许表头和 # 注释；有 label 列时只统计 label 为 cough 的行。
+ *
+ * 检测器按引擎的方式分窗（1 秒窗口、200ms 重叠），置信度达到阈值的连续窗口合并为一个
+ * 检测片段。片段级指标：与任一标注重叠的检测片段计为真阳性（精确率），被至少一个检测片段
+ * 覆盖的标注计为召回。同时记录每小时音频消耗的 CPU 时间，所有配置汇总成一张对比表。
+ *
+ * [flacCompression] 在同一语料上测量片段存储的 FLAC 压缩率（相对 16-bit PCM）。
+ *
+ * 运行方式：
+ *   ./gradlew :app:testDebugUnitTest -Pbench -PbenchCorpus=<dir> --tests "*AccuracyBenchmark*"
+ */
+class AccuracyBenchmark {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val WINDOW_SIZE = SAMPLE_RATE
+        private const val HOP_SIZE = WINDOW_SIZE - SAMPLE_RATE * 200 / 1000
+        private const val ENGINE_MIN_CONFIDENCE = 0.6f // 与 CoughDetectEngine.MIN_CONFIDENCE_THRESHOLD 一致
+    }
+
+    private class Variant(
+        val name: String,
+        val config: RuleBasedDetector.Config,
+        val minConfidence: Float = ENGINE_MIN_CONFIDENCE
+    )
+
+    /** 片段，单位为样本，区间 [start, end) */
+    private class Episode(val start: Long, val end: Long) {
+        fun overlaps(other: Episode) = start < other.end && other.start < end
+    }
+
+    private class Clip(val name: String, val samples: FloatArray, val labels: List<Episode>)
+
+    private class Score(
+        var predicted: Int = 0,
+        var truePositives: Int = 0,
+        var labels: Int = 0,
+        var recalled: Int = 0,
+        var cpuNanos: Long = 0L,
+        var audioSamples: Long = 0L
+    ) {
+        val precision: Double get() = if (predicted > 0) truePositives.toDouble() / predicted else 0.0
+        val recall: Double get() = if (labels > 0) recalled.toDouble() / labels else 0.0
+        val f1: Double get() = if (precision + recall > 0) 2 * precision * recall / (precision + recall) else 0.0
+        val cpuSecondsPerAudioHour: Double
+            get() = if (audioSamples > 0) cpuNanos / 1e9 * (SAMPLE_RATE * 3600.0 / audioSamples) else 0.0
+    }
+
+    // 待对比的配置：第一项为线上默认参数
+    private val variants = listOf(
+        Variant("default", RuleBasedDetector.Config()),
+        Variant("cutoff_0.5", RuleBasedDetector.Config(), minConfidence = 0.5f),
+        Variant("cutoff_0.8", RuleBasedDetector.Config(), minConfidence = 0.8f),
+        Variant("loud_only", RuleBasedDetector.Config(moderateRmsThreshold = Float.MAX_VALUE)),
+        Variant("strict_rms", RuleBasedDetector.Config(loudRmsThreshold = 0.15f, moderateRmsThreshold = 0.08f)),
+        Variant("sensitive_rms", RuleBasedDetector.Config(loudRmsThreshold = 0.06f, moderateRmsThreshold = 0.03f)),
+        Variant("spectral_centroid", RuleBasedDetector.Config(spectralCentroid = true))
+    )
+
+    private fun parseLabels(file: File): List<Episode> {
+        if (!file.exists()) return emptyList()
+        val episodes = ArrayList<Episode>()
+        file.forEachLine { line ->
+            val trimmed = line.trim()
+            if (trimmed.isEmpty() || trimmed.startsWith("#")) return@forEachLine
+            val columns = trimmed.split(',').map { it.trim() }
+            val start = columns.getOrNull(0)?.toDoubleOrNull() ?: return@forEachLine // 表头
+            val end = columns.getOrNull(1)?.toDoubleOrNull() ?: return@forEachLine
+            val label = columns.getOrNull(2)
+            if (label != null && !label.equals("cough", ignoreCase = true)) return@forEachLine
+            episodes.add(Episode((start * SAMPLE_RATE).toLong(), (end * SAMPLE_RATE).toLong()))
+        }
+        return episodes
+    }
+
+    private fun loadCorpus(directory: File): List<Clip> {
+        return directory.listFiles { file -> file.name.endsWith(".wav", ignoreCase = true) }
+            .orEmpty()
+            .sortedBy { it.name }
+            .mapNotNull { file ->
+                val audio = WavReader.read(file)
+                if (audio.sampleRate != SAMPLE_RATE) {
+                    println("跳过 ${file.name}: 采样率 ${audio.sampleRate}Hz，需要 ${SAMPLE_RATE}Hz")
+                    return@mapNotNull null
+                }
+                Clip(file.nameWithoutExtension, audio.samples, parseLabels(File(file.parentFile, file.nameWithoutExtension + ".csv")))
+            }
+    }
+
+    /**
+     * 按引擎的分窗方式检测，连续的阳性窗口合并为一个片段
+     */
+    private fun detectEpisodes(detector: RuleBasedDetector, samples: FloatArray, minConfidence: Float): List<Episode> {
+        val episodes = ArrayList<Episode>()
+        var openStart = -1L
+        var openEnd = -1L
+        var offset = 0
+        while (offset + WINDOW_SIZE <= samples.size) {
+            val result = detector.detect(samples, offset, WINDOW_SIZE)
+            val positive = result.isCough && result.confidence >= minConfidence
+            if (positive) {
+                if (openStart < 0) openStart = offset.toLong()
+                openEnd = (offset + WINDOW_SIZE).toLong()
+            } else if (openStart >= 0) {
+                episodes.add(Episode(openStart, openEnd))
+                openStart = -1L
+            }
+            offset += HOP_SIZE
+        }
+        if (openStart >= 0) {
+            episodes.add(Episode(openStart, openEnd))
+        }
+        return episodes
+    }
+
+    private fun evaluate(variant: Variant, corpus: List<Clip>): Score {
+        val detector = RuleBasedDetector(variant.config)
+        val score = Score()
+        for (clip in corpus) {
+            val cpuStart = Benchmark.currentThreadCpuNanos()
+            val predicted = detectEpisodes(detector, clip.samples, variant.minConfidence)
+            score.cpuNanos += Benchmark.currentThreadCpuNanos() - cpuStart
+            score.audioSamples += clip.samples.size
+
+            score.predicted += predicted.size
+            score.truePositives += predicted.count { episode -> clip.labels.any { it.overlaps(episode) } }
+            score.labels += clip.labels.size
+            score.recalled += clip.labels.count { label -> predicted.any { it.overlaps(label) } }
+        }
+        return score
+    }
+
+    @Test
+    fun accuracyVersusCost() {
+        assumeTrue("基准测试未启用（-Pbench）", Benchmark.enabled)
+        val directory = Benchmark.corpusDirectory
+        assumeTrue("未指定标注语料目录（-PbenchCorpus）", directory != null)
+        val corpus = loadCorpus(directory!!)
+        assumeTrue("语料目录中没有可用的 WAV 文件", corpus.isNotEmpty())
+
+        // 预热一遍，避免第一个配置的 CPU 时间包含 JIT 编译
+        evaluate(variants.first(), corpus)
+
+        val audioHours = corpus.sumOf { it.samples.size.toLong() } / (SAMPLE_RATE * 3600.0)
+        println(String.format(
+            Locale.US, "语料: %d 个文件, %.2f 小时, %d 个标注片段",
+            corpus.size, audioHours, corpus.sumOf { it.labels.size }
+        ))
+        println(String.format(
+            Locale.US, "%-16s %10s %10s %8s %8s %8s %14s",
+            "config", "predicted", "labels", "P", "R", "F1", "cpu s/audio h"
+        ))
+
+        val rows = variants.map { variant ->
+            val score = evaluate(variant, corpus)
+            println(String.format(
+                Locale.US, "%-16s %10d %10d %8.3f %8.3f %8.3f %14.2f",
+                variant.name, score.predicted, score.labels,
+                score.precision, score.recall, score.f1, score.cpuSecondsPerAudioHour
+            ))
+            linkedMapOf<String, Any>(
+                "name" to variant.name,
+                "backend" to "rule_based",
+                "min_confidence" to variant.minConfidence,
+                "config" to variant.config.toString(),
+                "predicted_episodes" to score.predicted,
+                "labeled_episodes" to score.labels,
+                "precision" to score.precision,
+                "recall" to score.recall,
+                "f1" to score.f1,
+                "cpu_seconds_per_audio_hour" to score.cpuSecondsPerAudioHour
+            )
+        }
+        Benchmark.writeJson(Benchmark.outputDirectory, "accuracy", rows)
+    }
+
+    /**
+     * 按仓库保存片段的方式（float 转 16-bit 后编码）测量每个文件的压缩率，对照只用固定阶预测的结果
+     */
+    @Test
+    fun flacCompression() {
+        assumeTrue("基准测试未启用（-Pbench）", Benchmark.enabled)
+        val directory = Benchmark.corpusDirectory
+        assumeTrue("未指定标注语料目录（-PbenchCorpus）", directory != null)
+        val corpus = loadCorpus(directory!!)
+        assumeTrue("语料目录中没有可用的 WAV 文件", corpus.isNotEmpty())
+
+        var pcmBytes = 0L
+        var lpcBytes = 0L
+        var fixedBytes = 0L
+        val rows = corpus.map { clip ->
+            val pcm = ShortArray(clip.samples.size)
+            AudioFeatures.floatToPcm16(clip.samples, 0, pcm, 0, pcm.size)
+            val lpc = FlacEncoder.encodeToByteArray(pcm, SAMPLE_RATE).size
+            val fixed = FlacEncoder.encodeToByteArray(pcm, SAMPLE_RATE, maxLpcOrder = 0).size
+            pcmBytes += pcm.size * 2L
+            lpcBytes += lpc
+            fixedBytes += fixed
+            println(String.format(
+                Locale.US, "%-24s %8.3f %8.3f", clip.name, pcm.size * 2.0 / lpc, pcm.size * 2.0 / fixed
+            ))
+            linkedMapOf<String, Any>(
+                "name" to clip.name,
+                "pcm_bytes" to pcm.size * 2,
+                "ratio" to pcm.size * 2.0 / lpc,
+                "ratio_fixed_only" to pcm.size * 2.0 / fixed
+            )
+        }
+        println(String.format(
+            Locale.US, "%-24s %8.3f %8.3f", "total", pcmBytes.toDouble() / lpcBytes, pcmBytes.toDouble() / fixedBytes
+        ))
+        Benchmark.writeJson(Benchmark.outputDirectory, "compression", rows + linkedMapOf<String, Any>(
+            "name" to "total",
+            "pcm_bytes" to pcmBytes,
+            "ratio" to pcmBytes.toDouble() / lpcBytes,
+            "ratio_fixed_only" to pcmBytes.toDouble() / fixedBytes
+        ))
+    }
+}
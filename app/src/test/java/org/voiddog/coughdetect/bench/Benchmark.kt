@@ -0,0 +1,179 @@
+package org.voiddog.coughdetect.bench
+
+import org.voiddog.coughdetect.testing.AllocationCounter
+import java.io.File
+import java.util.Locale
+
+/**
+ * 主机端微基准测试的最小框架
+ *
+ * 每个用例先预热，再跑若干轮，每轮按目标时长自动确定迭代次数，取各轮 ns/op 的中位数。
+ * 每次操作分配的字节数由 [AllocationCounter] 统计，JVM 不支持时记为 -1。
+ */
+class Benchmark(
+    private val suite: String,
+    private val warmupRounds: Int = 3,
+    private val rounds: Int = 7,
+    private val targetRoundNanos: Long = 50_000_000L
+) {
+
+    data class Result(
+        val name: String,
+        val windowSize: Int,
+        val nsPerOp: Double,
+        val samplesPerSecond: Double,
+        val bytesPerOp: Double,
+        val iterations: Long
+    )
+
+    private val results = ArrayList<Result>()
+
+    /**
+     * 基准测试 [block]，每次操作处理 [windowSize] 个样本。
+     * 返回值写入 [sink]，防止 JIT 把整个计算消除掉。
+     */
+    fun measure(name: String, windowSize: Int, block: () -> Any?): Result {
+        var iterations = 1L
+        // 预热并确定每轮的迭代次数
+        repeat(warmupRounds) {
+            while (true) {
+                val elapsed = runRound(iterations, block)
+                if (elapsed >= targetRoundNanos / 4 || iterations >= Int.MAX_VALUE) {
+                    iterations = (iterations * targetRoundNanos / elapsed.coerceAtLeast(1)).coerceAtLeast(1)
+                    break
+                }
+                iterations *= 2
+            }
+        }
+
+        val nsPerOp = DoubleArray(rounds)
+        for (round in 0 until rounds) {
+            nsPerOp[round] = runRound(iterations, block).toDouble() / iterations
+        }
+        nsPerOp.sort()
+        val median = nsPerOp[rounds / 2]
+
+        val result = Result(
+            name = name,
+            windowSize = windowSize,
+            nsPerOp = median,
+            samplesPerSecond = if (median > 0) windowSize * 1e9 / median else 0.0,
+            bytesPerOp = measureAllocation(iterations.coerceAtMost(10_000L), block),
+            iterations = iterations
+        )
+        results.add(result)
+        println(String.format(
+            Locale.US, "%-32s %6d  %12.1f ns/op  %14.0f samples/s  %10.1f B/op",
+            name, windowSize, result.nsPerOp, result.samplesPerSecond, result.bytesPerOp
+        ))
+        return result
+    }
+
+    private fun runRound(iterations: Long, block: () -> Any?): Long {
+        val start = System.nanoTime()
+        var i = 0L
+        while (i < iterations) {
+            sink = block()
+            i++
+        }
+        return System.nanoTime() - start
+    }
+
+    private fun measureAllocation(iterations: Long, block: () -> Any?): Double {
+        val thread = Thread.currentThread()
+        val before = AllocationCounter.allocatedBytes(thread)
+        if (before < 0) return -1.0
+        var i = 0L
+        while (i < iterations) {
+            sink = block()
+            i++
+        }
+        val after = AllocationCounter.allocatedBytes(thread)
+        // 扣除查询本身产生的分配
+        val bytes = (after - before - AllocationCounter.selfOverhead).coerceAtLeast(0L)
+        return bytes.toDouble() / iterations
+    }
+
+    /**
+     * 以 JSON 写出全部结果，文件名为 <suite>.json
+     */
+    fun writeJson(directory: File): File {
+        return writeJson(directory, suite, results.map { result ->
+            linkedMapOf<String, Any>(
+                "name" to result.name,
+                "window_size" to result.windowSize,
+                "ns_per_op" to result.nsPerOp,
+                "samples_per_second" to result.samplesPerSecond,
+                "bytes_per_op" to result.bytesPerOp,
+                "iterations" to result.iterations
+            )
+        })
+    }
+
+    companion object {
+        /** 防止被测代码的结果被 JIT 当作死代码消除 */
+        @Volatile
+        @JvmStatic
+        var sink: Any? = null
+
+        fun currentThreadCpuNanos(): Long = AllocationCounter.currentThreadCpuNanos()
+
+        /**
+         * 写出 {"suite", "jvm", "results": [...]} 格式的 JSON，每行是一组扁平的键值
+         */
+        fun writeJson(directory: File, suite: String, rows: List<Map<String, Any>>): File {
+            directory.mkdirs()
+            val file = File(directory, "$suite.json")
+            val json = StringBuilder()
+            json.append("{\n")
+            json.append("  \"suite\": ").append(jsonValue(suite)).append(",\n")
+            json.append("  \"jvm\": ").append(jsonValue(
+                System.getProperty("java.vm.name") + " " + System.getProperty("java.version")
+            )).append(",\n")
+            json.append("  \"results\": [\n")
+            rows.forEachIndexed { index, row ->
+                json.append("    {")
+                row.entries.forEachIndexed { column, (key, value) ->
+                    if (column > 0) json.append(", ")
+                    json.append(jsonValue(key)).append(": ").append(jsonValue(value))
+                }
+                json.append(if (index < rows.size - 1) "},\n" else "}\n")
+            }
+            json.append("  ]\n}\n")
+            file.writeText(json.toString())
+            return file
+        }
+
+        private fun jsonValue(value: Any): String = when (value) {
+            is Float, is Double -> {
+                val number = (value as Number).toDouble()
+                if (number.isFinite()) String.format(Locale.US, "%.3f", number) else "null"
+            }
+            is Number, is Boolean -> value.toString()
+            else -> "\"" + value.toString().replace("\\", "\\\\").replace("\"", "\\\"") + "\""
+        }
+
+        /**
+         * 已排序数组的最近秩百分位数
+         */
+        fun percentile(sorted: LongArray, p: Double): Long {
+            if (sorted.isEmpty()) return 0L
+            val rank = kotlin.math.ceil(p / 100.0 * sorted.size).toInt().coerceIn(1, sorted.size)
+            return sorted[rank - 1]
+        }
+
+        /** 是否启用基准测试（./gradlew testDebugUnitTest -Pbench） */
+        val enabled: Boolean
+            get() = System.getProperty("coughdetect.bench") == "true"
+
+        val outputDirectory: File
+            get() = File(System.getProperty("coughdetect.bench.dir") ?: "build/bench")
+
+        /** 录音语料目录（-PbenchCorpus=<dir>），未指定时为 null */
+        val corpusDirectory: File?
+            get() = System.getProperty("coughdetect.bench.corpus")
+                ?.takeIf { it.isNotEmpty() }
+                ?.let { File(it) }
+                ?.takeIf { it.isDirectory }
+    }
+}
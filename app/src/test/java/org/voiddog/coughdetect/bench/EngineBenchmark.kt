@@ -0,0 +1,233 @@
+package org.voiddog.coughdetect.bench
+
+import android.content.Context
+import org.junit.Assert.assertEquals
+import org.junit.Assume.assumeTrue
+import org.junit.Before
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.audio.SampleFormat
+import org.voiddog.coughdetect.engine.CoughDetectEngine
+import org.voiddog.coughdetect.engine.EngineConfig
+import org.voiddog.coughdetect.testing.PushAudioSource
+import java.util.Locale
+import java.util.Random
+import kotlin.math.PI
+import kotlin.math.exp
+import kotlin.math.sin
+
+/**
+ * 端到端基准测试：用文件或合成信号驱动完整的 CoughDetectEngine
+ * （缓冲、分窗、检测、事件回调），不受实时速度限制。
+ *
+ * 每送入一块音频就等引擎处理完由此凑满的窗口再送下一块，既跑得比实时快，
+ * 又不会因为检测跟不上而丢样本。报告：
+ * - 实时倍数：音频时长 / 墙钟时间
+ * - 每个窗口的延迟（从凑满窗口的那块音频交给引擎，到该窗口检测完成）p50/p95/p99/max
+ * - 合成咳嗽从起点到 COUGH_DETECTED 回调的延迟：窗口结束时刻与起点之间的音频时长，
+ *   加上该窗口的处理延迟。这是设备上用户实际感受到的延迟。
+ *
+ * 合成信号分别以 float 和 16-bit PCM 历史缓冲区各跑一遍，对比吞吐和历史缓冲区占用的内存。
+ *
+ * 主机上没有 TFLite 的本地库，检测走规则回退路径。
+ *
+ * 运行方式：
+ *   ./gradlew :app:testDebugUnitTest -Pbench [-PbenchCorpus=<wav目录>] --tests "*EngineBenchmark*"
+ */
+class EngineBenchmark {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val SEED = 20240601L
+        private const val CHUNK_SIZE = 2560 // 设备上 AudioRecord 单次读取的典型样本数
+        private const val WINDOW_SIZE = SAMPLE_RATE // 与引擎一致：1 秒窗口，固定步长时 200ms 重叠
+        private const val HOP_SIZE = WINDOW_SIZE - SAMPLE_RATE * 200 / 1000
+        private const val WINDOW_TIMEOUT_NS = 5_000_000_000L
+    }
+
+    private class Run(
+        val name: String,
+        val audioSeconds: Double,
+        val wallSeconds: Double,
+        val historyBytes: Int,
+        val windowLatencyNs: LongArray,
+        val coughs: Int,
+        val detected: Int,
+        val onsetDelayMs: LongArray
+    )
+
+    @Before
+    fun requireBenchmarkMode() {
+        assumeTrue("基准测试未启用（-Pbench）", Benchmark.enabled)
+    }
+
+    /**
+     * 合成信号：低电平背景噪声上，每 3.7 秒左右出现一次 250ms 的类咳嗽突发
+     * （宽带噪声加 700Hz 分量，指数衰减），返回信号和各突发的起点样本
+     */
+    private fun syntheticCoughs(seconds: Int): Pair<FloatArray, IntArray> {
+        val random = Random(SEED)
+        val samples = FloatArray(seconds * SAMPLE_RATE) { (random.nextGaussian() * 0.01).toFloat() }
+        val onsets = ArrayList<Int>()
+        var onset = SAMPLE_RATE * 2
+        while (onset + SAMPLE_RATE < samples.size) {
+            onsets.add(onset)
+            val length = SAMPLE_RATE / 4
+            for (i in 0 until length) {
+                val envelope = exp(-3.0 * i / length).toFloat()
+                val tone = sin(2 * PI * 700 * i / SAMPLE_RATE).toFloat()
+                samples[onset + i] += envelope * (0.5f * tone + (random.nextGaussian() * 0.3).toFloat())
+            }
+            onset += SAMPLE_RATE * 37 / 10 + random.nextInt(SAMPLE_RATE / 2)
+        }
+        return samples to onsets.toIntArray()
+    }
+
+    private fun expectedWindows(samplesPushed: Long): Long {
+        return if (samplesPushed < WINDOW_SIZE) 0L else (samplesPushed - WINDOW_SIZE) / HOP_SIZE + 1
+    }
+
+    private fun drive(
+        name: String,
+        samples: FloatArray,
+        onsets: IntArray,
+        format: SampleFormat = SampleFormat.PCM16
+    ): Run {
+        val source = PushAudioSource(SAMPLE_RATE, CHUNK_SIZE, pcm16 = format == SampleFormat.PCM16)
+        val engine = CoughDetectEngine(mock(Context::class.java), source, format)
+        val telemetry = engine.getTelemetry()
+
+        // 回调线程上记录每个 COUGH_DETECTED 事件（带所在窗口的样本范围和采集时刻）和分发时刻
+        val events = ArrayList<CoughDetectEngine.AudioEvent>()
+        val eventTimes = ArrayList<Long>()
+        engine.setAudioEventListener { event ->
+            if (event.type == CoughDetectEngine.AudioEventType.COUGH_DETECTED) {
+                synchronized(events) {
+                    events.add(event)
+                    eventTimes.add(System.nanoTime())
+                }
+            }
+        }
+
+        // 按固定步长推算每次推送后应处理完的窗口数，关闭自适应步长
+        check(engine.setConfig(EngineConfig(adaptiveHop = false))) { "引擎配置无效" }
+        check(engine.initialize()) { "引擎初始化失败" }
+        check(engine.start()) { "引擎启动失败" }
+
+        val windowLatency = ArrayList<Long>()
+        var pushed = 0L
+        val wallStart = System.nanoTime()
+        var offset = 0
+        while (offset < samples.size) {
+            val length = minOf(CHUNK_SIZE, samples.size - offset)
+            val pushTime = System.nanoTime()
+            source.push(samples, offset, length)
+            offset += length
+            pushed += length
+
+            val expected = expectedWindows(pushed)
+            if (telemetry.getWindowsProcessed() < expected) {
+                while (telemetry.getWindowsProcessed() < expected) {
+                    check(System.nanoTime() - pushTime < WINDOW_TIMEOUT_NS) { "等待窗口处理超时" }
+                    Thread.yield()
+                }
+                windowLatency.add(System.nanoTime() - pushTime)
+            }
+        }
+        val wallNanos = System.nanoTime() - wallStart
+        engine.release()
+
+        // 每个突发取起点之后第一个覆盖到它的检测事件
+        val delays = ArrayList<Long>()
+        synchronized(events) {
+            for (onset in onsets) {
+                for (i in events.indices) {
+                    val windowStart = events[i].startSample
+                    val windowEnd = events[i].endSample + 1
+                    if (windowEnd > onset && windowStart <= onset + SAMPLE_RATE / 4) {
+                        // 音频本身的延迟加上窗口最后一个样本采集到事件分发的延迟
+                        val audioDelayNs = (windowEnd - onset) * 1_000_000_000L / SAMPLE_RATE
+                        val processingNs = eventTimes[i] - events[i].endNanos
+                        delays.add((audioDelayNs + processingNs) / 1_000_000L)
+                        break
+                    }
+                }
+            }
+        }
+
+        return Run(
+            name = name,
+            audioSeconds = samples.size.toDouble() / SAMPLE_RATE,
+            wallSeconds = wallNanos / 1e9,
+            historyBytes = engine.getHistoryBytes(),
+            windowLatencyNs = windowLatency.toLongArray().also { it.sort() },
+            coughs = onsets.size,
+            detected = delays.size,
+            onsetDelayMs = delays.toLongArray().also { it.sort() }
+        )
+    }
+
+    private fun report(runs: List<Run>) {
+        val rows = runs.map { run ->
+            val latency = run.windowLatencyNs
+            val row = linkedMapOf<String, Any>(
+                "name" to run.name,
+                "audio_seconds" to run.audioSeconds,
+                "wall_seconds" to run.wallSeconds,
+                "x_realtime" to run.audioSeconds / run.wallSeconds,
+                "history_bytes" to run.historyBytes,
+                "windows" to latency.size,
+                "window_latency_p50_us" to Benchmark.percentile(latency, 50.0) / 1000,
+                "window_latency_p95_us" to Benchmark.percentile(latency, 95.0) / 1000,
+                "window_latency_p99_us" to Benchmark.percentile(latency, 99.0) / 1000,
+                "window_latency_max_us" to (latency.lastOrNull() ?: 0L) / 1000
+            )
+            if (run.coughs > 0) {
+                row["coughs"] = run.coughs
+                row["coughs_detected"] = run.detected
+                row["onset_to_callback_p50_ms"] = Benchmark.percentile(run.onsetDelayMs, 50.0)
+                row["onset_to_callback_p95_ms"] = Benchmark.percentile(run.onsetDelayMs, 95.0)
+                row["onset_to_callback_max_ms"] = run.onsetDelayMs.lastOrNull() ?: 0L
+            }
+            println(String.format(
+                Locale.US, "%-24s %8.1fx realtime  window p50/p95/p99/max %d/%d/%d/%d us  onset delay p50 %d ms (%d/%d)",
+                run.name, run.audioSeconds / run.wallSeconds,
+                row["window_latency_p50_us"], row["window_latency_p95_us"],
+                row["window_latency_p99_us"], row["window_latency_max_us"],
+                Benchmark.percentile(run.onsetDelayMs, 50.0), run.detected, run.coughs
+            ))
+            row
+        }
+        Benchmark.writeJson(Benchmark.outputDirectory, "engine", rows)
+    }
+
+    @Test
+    fun endToEnd() {
+        val runs = ArrayList<Run>()
+
+        // 预热一遍，避免第一轮测到的是解释执行和 JIT 编译
+        val (warmup, warmupOnsets) = syntheticCoughs(30)
+        drive("warmup", warmup, warmupOnsets)
+
+        val (samples, onsets) = syntheticCoughs(600)
+        for (format in SampleFormat.values()) {
+            val synthetic = drive("synthetic_10min_${format.name.lowercase()}", samples, onsets, format)
+            assertEquals(expectedWindows(samples.size.toLong()).toInt(), synthetic.windowLatencyNs.size)
+            runs.add(synthetic)
+        }
+
+        Benchmark.corpusDirectory
+            ?.listFiles { file -> file.name.endsWith(".wav", ignoreCase = true) }
+            ?.sortedBy { it.name }
+            ?.forEach { file ->
+                val audio = WavReader.read(file)
+                if (audio.sampleRate != SAMPLE_RATE) {
+                    println("跳过 ${file.name}: 采样率 ${audio.sampleRate}Hz，引擎需要 ${SAMPLE_RATE}Hz")
+                    return@forEach
+                }
+                runs.add(drive(file.nameWithoutExtension, audio.samples, IntArray(0)))
+            }
+
+        report(runs)
+    }
+}
@@ -0,0 +1,226 @@
+package org.voiddog.coughdetect.bench
+
+import android.content.Context
+import kotlinx.coroutines.flow.MutableStateFlow
+import org.junit.Assume.assumeTrue
+import org.junit.Before
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.audio.FlacEncoder
+import org.voiddog.coughdetect.audio.PolyphaseResampler
+import org.voiddog.coughdetect.engine.CoughDetectEngine
+import org.voiddog.coughdetect.engine.EngineTelemetry
+import org.voiddog.coughdetect.engine.FloatRingBuffer
+import org.voiddog.coughdetect.engine.ShortRingBuffer
+import org.voiddog.coughdetect.ml.AudioFeatures
+import org.voiddog.coughdetect.ml.MfccFrontEnd
+import org.voiddog.coughdetect.ml.ProductionMfccFrontEnd
+import org.voiddog.coughdetect.ml.RuleBasedDetector
+import org.voiddog.coughdetect.ml.TensorFlowLiteDetector
+import org.voiddog.coughdetect.testing.PushAudioSource
+import java.util.Random
+import kotlin.math.PI
+import kotlin.math.sin
+
+/**
+ * 检测热路径上各个内核的微基准测试
+ *
+ * 默认跳过，运行方式：
+ *   ./gradlew :app:testDebugUnitTest -Pbench --tests "*KernelBenchmark*"
+ * 结果写入 app/build/bench/kernels.json。
+ */
+class KernelBenchmark {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val SEED = 20240601L
+
+        // 录音回调的典型大小、一帧 FLAC 块、检测窗口（1 秒）
+        private val WINDOW_SIZES = intArrayOf(512, 4096, 16000)
+    }
+
+    @Before
+    fun requireBenchmarkMode() {
+        assumeTrue("基准测试未启用（-Pbench）", Benchmark.enabled)
+    }
+
+    /**
+     * 固定种子的测试信号：低电平噪声上叠加周期性的类咳嗽突发
+     */
+    private fun signal(size: Int): FloatArray {
+        val random = Random(SEED)
+        return FloatArray(size) { i ->
+            val burst = if ((i / 2400) % 4 == 0) 0.4f * sin(2 * PI * 900 * i / SAMPLE_RATE).toFloat() else 0f
+            burst + (random.nextGaussian() * 0.02).toFloat()
+        }
+    }
+
+    private fun pcm16(samples: FloatArray): ShortArray {
+        val pcm = ShortArray(samples.size)
+        AudioFeatures.floatToPcm16(samples, 0, pcm, 0, samples.size)
+        return pcm
+    }
+
+    @Test
+    fun kernels() {
+        val bench = Benchmark("kernels")
+        val detector = RuleBasedDetector()
+        val spectralDetector = RuleBasedDetector(RuleBasedDetector.Config(spectralCentroid = true))
+        val result = TensorFlowLiteDetector.DetectionResult()
+
+        for (size in WINDOW_SIZES) {
+            val samples = signal(size)
+            val pcm = pcm16(samples)
+            val floatTarget = FloatArray(size)
+            val pcmTarget = ShortArray(size)
+
+            bench.measure("rms", size) { AudioFeatures.rms(samples) }
+            bench.measure("zero_crossing_rate", size) { AudioFeatures.zeroCrossingRate(samples) }
+            bench.measure("spectral_centroid", size) { AudioFeatures.spectralCentroid(samples) }
+            bench.measure("rule_detector", size) { detector.detect(samples, 0, size, result) }
+            bench.measure("rule_detector_fft_centroid", size) { spectralDetector.detect(samples, 0, size, result) }
+            bench.measure("pcm16_to_float", size) {
+                AudioFeatures.pcm16ToFloat(pcm, floatTarget, size)
+                floatTarget
+            }
+            bench.measure("float_to_pcm16", size) {
+                AudioFeatures.floatToPcm16(samples, 0, pcmTarget, 0, size)
+                pcmTarget
+            }
+            bench.measure("flac_encode", size) { FlacEncoder.encodeToByteArray(pcm, SAMPLE_RATE) }
+        }
+
+        bench.writeJson(Benchmark.outputDirectory)
+    }
+
+    /**
+     * 引擎的窗口缓冲：每个录音回调追加一次，攒够一个窗口后取出并保留重叠部分。
+     * 保留原来装箱的 MutableList<Float> 实现作为对照；PCM16 历史在取窗口时转换成 float。
+     */
+    @Test
+    fun engineWindowBuffering() {
+        val bench = Benchmark("engine_buffering")
+        val windowSize = SAMPLE_RATE
+        val overlap = SAMPLE_RATE * 200 / 1000
+
+        for (chunkSize in WINDOW_SIZES) {
+            val chunk = signal(chunkSize)
+            val buffer = mutableListOf<Float>()
+            bench.measure("boxed_window_buffer", chunkSize) {
+                buffer.addAll(chunk.toList())
+                var window: FloatArray? = null
+                if (buffer.size >= windowSize) {
+                    window = buffer.take(windowSize).toFloatArray()
+                    buffer.subList(0, windowSize - overlap).clear()
+                }
+                window
+            }
+
+            val ring = FloatRingBuffer(windowSize * 2)
+            val window = FloatArray(windowSize)
+            bench.measure("ring_window_buffer", chunkSize) {
+                ring.write(chunk, 0, chunkSize)
+                if (ring.size >= windowSize) {
+                    ring.peek(window, 0, windowSize)
+                    ring.discard(windowSize - overlap)
+                }
+                window
+            }
+
+            val pcmChunk = pcm16(chunk)
+            val pcmRing = ShortRingBuffer(windowSize * 2)
+            bench.measure("pcm16_ring_window_buffer", chunkSize) {
+                pcmRing.writePcm16(pcmChunk, 0, chunkSize)
+                if (pcmRing.size >= windowSize) {
+                    pcmRing.peek(window, 0, windowSize)
+                    pcmRing.discard(windowSize - overlap)
+                }
+                window
+            }
+        }
+
+        bench.writeJson(Benchmark.outputDirectory)
+    }
+
+    /**
+     * 线上固定配置（16kHz/512/160/40/13）的特化 MFCC 前端与同配置通用实现的对比
+     */
+    @Test
+    fun mfccFrontEnd() {
+        val bench = Benchmark("mfcc")
+        val generic = MfccFrontEnd()
+        val production = ProductionMfccFrontEnd()
+
+        for (size in WINDOW_SIZES) {
+            val samples = signal(size)
+            val out = FloatArray(maxOf(1, generic.frameCount(size)) * ProductionMfccFrontEnd.CEPSTRA)
+            bench.measure("mfcc_generic", size) { generic.process(samples, 0, size, out) }
+            bench.measure("mfcc_production", size) { production.process(samples, 0, size, out) }
+        }
+
+        bench.writeJson(Benchmark.outputDirectory)
+    }
+
+    /**
+     * 48kHz 原生录音降到 16kHz 的多相重采样，各档质量对比；windowSize 按输入样本计
+     */
+    @Test
+    fun resampler() {
+        val bench = Benchmark("resampler")
+
+        for (quality in PolyphaseResampler.Quality.values()) {
+            val resampler = PolyphaseResampler(48000, SAMPLE_RATE, quality)
+            for (size in WINDOW_SIZES) {
+                val input = signal(size)
+                val output = FloatArray(resampler.maxOutputSize(size))
+                bench.measure("resample_48k_${quality.name.lowercase()}", size) {
+                    resampler.process(input, 0, size, output)
+                }
+            }
+        }
+
+        bench.writeJson(Benchmark.outputDirectory)
+    }
+
+    /**
+     * UI 每帧读取的引擎状态：单字段读取和一致性快照
+     */
+    @Test
+    fun telemetry() {
+        val bench = Benchmark("telemetry")
+        val telemetry = EngineTelemetry()
+        telemetry.updateState(CoughDetectEngine.EngineState.RECORDING)
+        telemetry.updateAudioLevel(0.25f)
+
+        bench.measure("telemetry_get_audio_level", 1) { telemetry.getAudioLevel() }
+        bench.measure("telemetry_get_state", 1) { telemetry.getState() }
+        bench.measure("telemetry_snapshot", 1) { telemetry.snapshot() }
+        bench.measure("telemetry_record_window", 1) { telemetry.recordWindow(1200L) }
+
+        bench.writeJson(Benchmark.outputDirectory)
+    }
+
+    /**
+     * 引擎的状态读取：getter 读遥测块的单个 volatile 字段，对照原来经过 StateFlow.value 的读取
+     */
+    @Test
+    fun engineGetters() {
+        val bench = Benchmark("engine_getters")
+        val engine = CoughDetectEngine(mock(Context::class.java), PushAudioSource(SAMPLE_RATE, SAMPLE_RATE / 10))
+        val stateFlow = MutableStateFlow(CoughDetectEngine.EngineState.RECORDING)
+        val levelFlow = MutableStateFlow(0.25f)
+        try {
+            bench.measure("stateflow_is_recording", 1) { stateFlow.value == CoughDetectEngine.EngineState.RECORDING }
+            bench.measure("stateflow_audio_level", 1) { levelFlow.value }
+            bench.measure("engine_is_recording", 1) { engine.isRecording() }
+            bench.measure("engine_get_state", 1) { engine.getState() }
+            bench.measure("engine_get_audio_level", 1) { engine.getAudioLevel() }
+            bench.measure("engine_get_sample_rate", 1) { engine.getSampleRate() }
+            bench.measure("engine_is_ready", 1) { engine.isReady() }
+        } finally {
+            engine.release()
+        }
+
+        bench.writeJson(Benchmark.outputDirectory)
+    }
+}
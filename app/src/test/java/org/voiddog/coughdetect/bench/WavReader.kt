@@ -0,0 +1,52 @@
+package org.voiddog.coughdetect.bench
+
+import java.io.File
+import java.io.IOException
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * 读取基准测试语料用的 16-bit PCM WAV（多声道时取第一声道）
+ */
+object WavReader {
+
+    class Audio(val samples: FloatArray, val sampleRate: Int)
+
+    fun read(file: File): Audio {
+        val buffer = ByteBuffer.wrap(file.readBytes()).order(ByteOrder.LITTLE_ENDIAN)
+        if (buffer.int != 0x46464952 || buffer.getInt(8) != 0x45564157) { // "RIFF" ... "WAVE"
+            throw IOException("Not a WAV file: ${file.name}")
+        }
+        buffer.position(12)
+        var sampleRate = 0
+        var channels = 0
+        var bitsPerSample = 0
+        while (buffer.remaining() >= 8) {
+            val id = buffer.int
+            val size = buffer.int
+            val start = buffer.position()
+            when (id) {
+                0x20746D66 -> { // "fmt "
+                    buffer.short // format
+                    channels = buffer.short.toInt()
+                    sampleRate = buffer.int
+                    buffer.position(start + 14)
+                    bitsPerSample = buffer.short.toInt()
+                }
+                0x61746164 -> { // "data"
+                    if (bitsPerSample != 16 || channels <= 0) {
+                        throw IOException("Unsupported WAV format in ${file.name}: $bitsPerSample bit, $channels channels")
+                    }
+                    val frames = minOf(size, buffer.remaining()) / (2 * channels)
+                    val samples = FloatArray(frames)
+                    for (i in 0 until frames) {
+                        samples[i] = buffer.getShort(start + i * 2 * channels) / 32768.0f
+                    }
+                    return Audio(samples, sampleRate)
+                }
+            }
+            buffer.position((start + size + (size and 1)).coerceAtMost(buffer.limit()))
+        }
+        throw IOException("No data chunk in ${file.name}")
+    }
+}
@@ -0,0 +1,112 @@
+package org.voiddog.coughdetect.data
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+import java.io.File
+import java.io.FileOutputStream
+
+class DiskQuotaManagerTest {
+
+    @get:Rule
+    val temporaryFolder = TemporaryFolder()
+
+    private fun manifest() = File(temporaryFolder.root, "quota.manifest")
+
+    @Test
+    fun evictsLeastRecentlyUsedFirst() {
+        val quota = DiskQuotaManager(manifest())
+        quota.put("/a", 10)
+        quota.put("/b", 10)
+        quota.put("/c", 10)
+        quota.touch("/a")
+
+        assertEquals(listOf("/b", "/c"), quota.evict(15))
+        assertEquals(10L, quota.totalBytes)
+        assertTrue(quota.contains("/a"))
+        assertTrue(quota.evict(100).isEmpty())
+    }
+
+    @Test
+    fun putUpdatesSizeInPlace() {
+        val quota = DiskQuotaManager(manifest())
+        quota.put("/segment", 100)
+        quota.put("/segment", 250)
+        quota.put("/other", 50)
+
+        assertEquals(2, quota.size)
+        assertEquals(300L, quota.totalBytes)
+        assertTrue(quota.remove("/other"))
+        assertFalse(quota.remove("/other"))
+        assertEquals(250L, quota.totalBytes)
+    }
+
+    @Test
+    fun reloadsFromManifestInAccessOrder() {
+        val first = DiskQuotaManager(manifest())
+        assertFalse(first.loadedFromManifest)
+        for (i in 0 until 5) {
+            first.put("/clip$i", 100L + i)
+        }
+        first.touch("/clip0")
+        first.remove("/clip3")
+        first.close()
+
+        val reloaded = DiskQuotaManager(manifest())
+        assertTrue(reloaded.loadedFromManifest)
+        assertEquals(100L + 101 + 102 + 104, reloaded.totalBytes)
+        assertEquals(listOf("/clip1", "/clip2", "/clip4", "/clip0"), reloaded.evict(0))
+    }
+
+    @Test
+    fun compactsRedundantOperations() {
+        val quota = DiskQuotaManager(manifest())
+        quota.put("/a", 1)
+        quota.put("/b", 2)
+        repeat(10_000) { quota.touch(if (it % 2 == 0) "/a" else "/b") }
+        quota.close()
+
+        // 每条 PUT 约 23 字节，压缩后清单大小与操作次数无关
+        assertTrue("manifest ${manifest().length()} bytes", manifest().length() < 16 * 1024)
+        val reloaded = DiskQuotaManager(manifest())
+        assertEquals(3L, reloaded.totalBytes)
+        assertEquals(listOf("/a", "/b"), reloaded.evict(0))
+    }
+
+    @Test
+    fun ignoresTornTailOperation() {
+        val quota = DiskQuotaManager(manifest())
+        quota.put("/a", 10)
+        quota.put("/b", 20)
+        quota.close()
+        FileOutputStream(manifest(), true).use { it.write(byteArrayOf(1, 0, 5, '/'.code.toByte())) }
+
+        val reloaded = DiskQuotaManager(manifest())
+        assertTrue(reloaded.loadedFromManifest)
+        assertEquals(30L, reloaded.totalBytes)
+        reloaded.put("/c", 5)
+        reloaded.close()
+        assertEquals(35L, DiskQuotaManager(manifest()).totalBytes)
+    }
+
+    @Test
+    fun syncReconcilesDirectory() {
+        val directory = temporaryFolder.newFolder("event_log")
+        val quota = DiskQuotaManager(manifest())
+        quota.put("/legacy/clip.wav", 7)
+        quota.put(File(directory, "00000001.seg").absolutePath, 100)
+        quota.put(File(directory, "00000002.seg").absolutePath, 100)
+
+        quota.sync(directory, mapOf(
+            File(directory, "00000002.seg").absolutePath to 150L,
+            File(directory, "00000003.seg").absolutePath to 40L
+        ))
+
+        assertEquals(7L + 150 + 40, quota.totalBytes)
+        assertFalse(quota.contains(File(directory, "00000001.seg").absolutePath))
+        assertTrue(quota.contains("/legacy/clip.wav"))
+    }
+}
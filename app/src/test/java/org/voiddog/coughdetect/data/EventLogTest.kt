@@ -0,0 +1,128 @@
+package org.voiddog.coughdetect.data
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNotEquals
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+import java.io.File
+import java.io.FileOutputStream
+
+class EventLogTest {
+
+    @get:Rule
+    val temporaryFolder = TemporaryFolder()
+
+    private fun clip(seed: Int, size: Int = 64) = ByteArray(size) { (it * 31 + seed).toByte() }
+
+    private fun EventLog.appendAt(timestamp: Long, seed: Int = timestamp.toInt(), size: Int = 64) =
+        append(timestamp, 1000, 0.8f, 0.3f, AudioEventType.COUGH.ordinal, clip(seed, size)).get()
+
+    @Test
+    fun queriesByTimeRange() {
+        val log = EventLog(temporaryFolder.newFolder())
+        for (t in 0L until 100L) {
+            log.appendAt(t * 10)
+        }
+
+        val entries = log.query(205, 300)
+        assertEquals((21..30).map { it * 10L }, entries.map { it.timestamp })
+        assertEquals(10, log.countInRange(205, 300))
+        assertEquals(0, log.countInRange(2000, 3000))
+        assertArrayEquals(clip(210), log.readClip(entries.first().clip))
+    }
+
+    @Test
+    fun outOfOrderTimestampStartsNewSegment() {
+        val log = EventLog(temporaryFolder.newFolder())
+        val first = log.appendAt(1000)
+        val second = log.appendAt(500)
+
+        assertNotEquals(first.clip.file, second.clip.file)
+        assertEquals(listOf(500L, 1000L), log.query(0, 2000).map { it.timestamp }.sorted())
+    }
+
+    @Test
+    fun removesWholeSegments() {
+        val log = EventLog(temporaryFolder.newFolder(), segmentSizeLimit = 200)
+        val entries = (0L until 10L).map { log.appendAt(it) } // 每段容纳 3 个片段
+        val sizeBefore = log.totalBytes
+
+        assertTrue(log.removeSegment(entries[0].clip.file))
+        assertFalse(entries[0].clip.file.exists())
+        assertEquals(sizeBefore - 3 * (64 + EventLog.RECORD_SIZE), log.totalBytes)
+        assertEquals((3L until 10L).toList(), log.query(0, 100).map { it.timestamp })
+        assertFalse(log.removeSegment(entries[0].clip.file))
+
+        for (file in log.segmentSizes().keys) {
+            assertTrue(log.removeSegment(File(file)))
+        }
+        assertEquals(0L, log.totalBytes)
+        assertTrue(log.query(0, 100).isEmpty())
+    }
+
+    @Test
+    fun markDeletedHidesEntry() {
+        val log = EventLog(temporaryFolder.newFolder())
+        val entries = (0L until 5L).map { log.appendAt(it) }
+
+        assertTrue(log.markDeleted(entries[2].clip))
+        assertEquals(listOf(0L, 1L, 3L, 4L), log.query(0, 10).map { it.timestamp })
+    }
+
+    @Test
+    fun recoversFromTornTail() {
+        val directory = temporaryFolder.newFolder()
+        val log = EventLog(directory)
+        val entries = (0L until 3L).map { log.appendAt(it) }
+        val sizeBefore = log.totalBytes
+        log.close()
+
+        // 模拟崩溃：数据写了一半，索引记录写了一半
+        val segment = entries.last().clip.file
+        FileOutputStream(segment, true).use { it.write(ByteArray(30)) }
+        FileOutputStream(File(segment.path.replace(".seg", ".idx")), true).use { it.write(ByteArray(20)) }
+
+        val reopened = EventLog(directory)
+        assertEquals(sizeBefore, reopened.totalBytes)
+        assertEquals(sizeBefore - 3 * EventLog.RECORD_SIZE, segment.length())
+        assertEquals(listOf(0L, 1L, 2L), reopened.query(0, 10).map { it.timestamp })
+        assertArrayEquals(clip(2), reopened.readClip(entries[2].clip))
+
+        // 恢复后继续追加到同一段
+        val next = reopened.appendAt(3)
+        assertEquals(segment, next.clip.file)
+        assertEquals(entries[2].clip.offset + 64, next.clip.offset)
+    }
+
+    @Test
+    fun backgroundAppendsKeepAllocationOrder() {
+        val log = EventLog(temporaryFolder.newFolder())
+        // 不等落盘连续追加，片段和索引都在 I/O 线程上按分配顺序写入
+        val futures = (0L until 50L).map { t ->
+            log.append(t, 1000, 0.8f, 0.3f, AudioEventType.COUGH.ordinal, clip(t.toInt(), 100 + t.toInt()))
+        }
+        val entries = futures.map { it.get() }
+
+        assertEquals((0L until 50L).toList(), log.query(0, 100).map { it.timestamp })
+        assertEquals(entries.map { it.clip.offset }.sorted(), entries.map { it.clip.offset })
+        for (t in 0 until 50) {
+            assertArrayEquals(clip(t, 100 + t), log.readClip(entries[t].clip))
+        }
+    }
+
+    @Test
+    fun clipRefRoundTrip() {
+        val log = EventLog(temporaryFolder.newFolder())
+        val entry = log.appendAt(42)
+        val path = entry.clip.toString()
+
+        assertTrue(EventLog.isClipRef(path))
+        assertEquals(entry.clip, EventLog.ClipRef.parse(path))
+        assertNull(EventLog.ClipRef.parse("/data/audio_events/cough_20240101_120000_000.wav"))
+    }
+}
@@ -0,0 +1,132 @@
+package org.voiddog.coughdetect.engine
+
+import android.content.Context
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.testing.PushAudioSource
+import java.util.Random
+import java.util.concurrent.CopyOnWriteArrayList
+import kotlin.math.PI
+import kotlin.math.sin
+
+/**
+ * 自适应步长：安静时按粗步长切窗口，检测到声音起始后按细步长切，安静一段时间后退回粗步长
+ */
+class AdaptiveHopTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val WINDOW_SIZE = SAMPLE_RATE
+        // 每块 100ms，正好一个细步长
+        private const val CHUNK_SIZE = SAMPLE_RATE / 10
+        private const val TIMEOUT_NS = 5_000_000_000L
+    }
+
+    private val random = Random(7)
+    private val quiet = FloatArray(CHUNK_SIZE)
+    private val tone = FloatArray(CHUNK_SIZE) { i -> 0.5f * sin(2 * PI * 700 * i / SAMPLE_RATE).toFloat() }
+
+    private lateinit var source: PushAudioSource
+    private lateinit var engine: CoughDetectEngine
+
+    @Before
+    fun setUp() {
+        source = PushAudioSource(SAMPLE_RATE, CHUNK_SIZE)
+        engine = CoughDetectEngine(mock(Context::class.java), source)
+        check(engine.initialize())
+        check(engine.start())
+    }
+
+    @After
+    fun tearDown() {
+        engine.release()
+    }
+
+    private fun framed(): Long = engine.getPipelineStats().stage(PipelineStats.Stage.FRAMING).count
+
+    private fun await(condition: () -> Boolean) {
+        val start = System.nanoTime()
+        while (!condition()) {
+            check(System.nanoTime() - start < TIMEOUT_NS) { "pipeline timed out" }
+            Thread.yield()
+        }
+    }
+
+    private fun pushQuiet() {
+        for (i in quiet.indices) {
+            quiet[i] = (random.nextGaussian() * 0.005).toFloat()
+        }
+        source.push(quiet, 0, CHUNK_SIZE)
+    }
+
+    @Test
+    fun quietAudioUsesCoarseHop() {
+        var pushed = 0L
+        repeat(100) {
+            pushQuiet()
+            pushed += CHUNK_SIZE
+            val expected = if (pushed < WINDOW_SIZE) 0L else (pushed - WINDOW_SIZE) / WINDOW_SIZE + 1
+            await { framed() >= expected }
+        }
+        Thread.sleep(50)
+
+        // 10 秒安静音频只切 10 个窗口（固定 800ms 步长是 12 个）
+        assertEquals(10L, framed())
+    }
+
+    @Test
+    fun onsetSwitchesToFineHopUntilQuietAgain() {
+        repeat(50) { pushQuiet() }
+        await { framed() >= 5L }
+        Thread.sleep(50)
+        assertEquals(5L, framed())
+
+        // 300ms 的声音加上之后的 900ms 仍在活动保持期内：每个细步长一个窗口
+        val base = framed()
+        for (k in 1..12) {
+            if (k <= 3) source.push(tone, 0, CHUNK_SIZE) else pushQuiet()
+            await { framed() >= base + k }
+        }
+
+        // 安静满 1 秒后退回粗步长：接下来的 1 秒只有一个窗口
+        repeat(10) { pushQuiet() }
+        await { framed() >= base + 13 }
+        Thread.sleep(50)
+        assertEquals(base + 13, framed())
+    }
+
+    @Test
+    fun oneCoughIsOneEvent() {
+        val events = CopyOnWriteArrayList<CoughDetectEngine.AudioEvent>()
+        engine.setAudioEventListener { event ->
+            if (event.type == CoughDetectEngine.AudioEventType.COUGH_DETECTED) events.add(event)
+        }
+        repeat(50) { pushQuiet() }
+        await { framed() >= 5L }
+
+        // 300ms 的咳嗽：之后约 1 秒内按细步长切出的窗口都包含它，都判为咳嗽
+        val onset = 50L * CHUNK_SIZE
+        repeat(3) { source.push(tone, 0, CHUNK_SIZE) }
+        repeat(30) { pushQuiet() }
+        await { engine.getTelemetry().getWindowsProcessed() == framed() && framed() >= 5L + 13 }
+        await { events.isNotEmpty() }
+        Thread.sleep(50)
+
+        // 重叠的阳性窗口合并成一个事件，它所在的窗口覆盖咳嗽起点
+        assertEquals(1, events.size)
+        assertTrue(events[0].startSample <= onset && events[0].endSample >= onset)
+        assertEquals(1L, engine.getTelemetry().snapshot().eventsEmitted)
+    }
+
+    @Test
+    fun hopsAreValidated() {
+        assertTrue(EngineConfig(fineHopMs = 0).validate().isNotEmpty())
+        assertTrue(EngineConfig(fineHopMs = 200, coarseHopMs = 100).validate().isNotEmpty())
+        assertTrue(EngineConfig(fineHopMs = 2000).validate().isNotEmpty())
+        assertTrue(EngineConfig(fineHopMs = 50, coarseHopMs = 500).validate().isEmpty())
+    }
+}
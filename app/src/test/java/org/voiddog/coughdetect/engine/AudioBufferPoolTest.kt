@@ -0,0 +1,40 @@
+package org.voiddog.coughdetect.engine
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotSame
+import org.junit.Assert.assertSame
+import org.junit.Test
+
+class AudioBufferPoolTest {
+
+    @Test
+    fun reusesReleasedBuffers() {
+        val pool = AudioBufferPool(bufferSize = 16, capacity = 2)
+        val first = pool.acquire()
+        pool.release(first)
+
+        assertSame(first, pool.acquire())
+        assertEquals(1, pool.misses)
+    }
+
+    @Test
+    fun boundsCapacityAndIgnoresForeignBuffers() {
+        val pool = AudioBufferPool(bufferSize = 16, capacity = 2)
+        val buffers = List(3) { pool.acquire() }
+        buffers.forEach { pool.release(it) }
+        pool.release(FloatArray(8))
+
+        assertEquals(2, pool.available)
+        assertEquals(3, pool.misses)
+    }
+
+    @Test
+    fun doubleReleaseDoesNotShareBuffer() {
+        val pool = AudioBufferPool(bufferSize = 16, capacity = 4)
+        val buffer = pool.acquire()
+        pool.release(buffer)
+        pool.release(buffer)
+
+        assertNotSame(pool.acquire(), pool.acquire())
+    }
+}
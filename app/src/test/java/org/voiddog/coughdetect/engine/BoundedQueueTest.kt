@@ -0,0 +1,75 @@
+package org.voiddog.coughdetect.engine
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.util.concurrent.atomic.AtomicInteger
+
+class BoundedQueueTest {
+
+    @Test
+    fun offersUntilFullAndPollsInOrder() {
+        val queue = BoundedQueue<Int>(3)
+        assertTrue(queue.offer(1))
+        assertTrue(queue.offer(2))
+        assertTrue(queue.offer(3))
+        assertTrue(queue.isFull)
+        assertFalse(queue.offer(4))
+
+        assertEquals(1, queue.poll())
+        assertTrue(queue.offer(4))
+        assertEquals(listOf(2, 3, 4), List(3) { queue.poll() })
+        assertNull(queue.poll())
+        assertEquals(3, queue.highWaterMark)
+    }
+
+    @Test
+    fun evictsOnlyWhenFull() {
+        val queue = BoundedQueue<String>(2)
+        queue.offer("a")
+        assertNull(queue.evictIfFull())
+        queue.offer("b")
+        assertEquals("a", queue.evictIfFull())
+        assertEquals(1, queue.size)
+
+        queue.clear()
+        assertEquals(0, queue.size)
+        assertEquals(0, queue.highWaterMark)
+        assertNull(queue.poll())
+    }
+
+    @Test
+    fun consumerAndEvictingProducerNeverShareAnItem() {
+        val queue = BoundedQueue<IntArray>(4)
+        val total = 200_000
+        val seen = IntArray(total)
+        val consumed = AtomicInteger()
+
+        val consumer = Thread {
+            while (consumed.get() < total) {
+                val item = queue.poll() ?: continue
+                seen[item[0]]++
+                consumed.incrementAndGet()
+            }
+        }
+        consumer.start()
+
+        // 生产者在队列满时丢掉最旧的元素，和 DROP_OLDEST 的分帧阶段一样
+        for (i in 0 until total) {
+            val item = intArrayOf(i)
+            while (!queue.offer(item)) {
+                val evicted = queue.evictIfFull() ?: continue
+                seen[evicted[0]]++
+                consumed.incrementAndGet()
+            }
+        }
+        consumer.join(10_000)
+
+        assertFalse(consumer.isAlive)
+        assertEquals(total, consumed.get())
+        assertTrue(seen.all { it == 1 })
+        assertNull(queue.poll())
+    }
+}
@@ -0,0 +1,89 @@
+package org.voiddog.coughdetect.engine
+
+import android.content.Context
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.testing.PushAudioSource
+import java.util.concurrent.CountDownLatch
+import kotlin.math.PI
+import kotlin.math.sin
+
+/**
+ * 积压的窗口过了截止时间只做粗略判定，最新的窗口完整打分，积压消化后不再错过截止时间
+ */
+class DeadlineSchedulingTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val WINDOW_SIZE = SAMPLE_RATE
+        private const val HOP_SIZE = WINDOW_SIZE - SAMPLE_RATE * 200 / 1000
+        private const val DEADLINE_MS = 200
+        private const val TIMEOUT_NS = 5_000_000_000L
+    }
+
+    // 持续的响亮音调，每个窗口都判为咳嗽
+    private val tone = FloatArray(HOP_SIZE) { i -> 0.5f * sin(2 * PI * 700 * i / SAMPLE_RATE).toFloat() }
+
+    private fun framed(engine: CoughDetectEngine): Long =
+        engine.getPipelineStats().stage(PipelineStats.Stage.FRAMING).count
+
+    private fun await(condition: () -> Boolean) {
+        val start = System.nanoTime()
+        while (!condition()) {
+            check(System.nanoTime() - start < TIMEOUT_NS) { "pipeline timed out" }
+            Thread.yield()
+        }
+    }
+
+    @Test
+    fun staleBacklogIsCoveredCoarselyAndNewestWindowIsScored() {
+        val source = PushAudioSource(SAMPLE_RATE, HOP_SIZE)
+        val engine = CoughDetectEngine(mock(Context::class.java), source)
+        val telemetry = engine.getTelemetry()
+        // 分发卡住期间打分停下，窗口在队列里积压
+        val stall = CountDownLatch(1)
+        engine.setAudioEventListener { stall.await() }
+        try {
+            // 固定步长，按步长推算窗口数
+            check(engine.setConfig(EngineConfig(deadlineMs = DEADLINE_MS, adaptiveHop = false)))
+            check(engine.initialize())
+            check(engine.start())
+
+            val windowsQueued = { engine.getPipelineStats().queue(PipelineStats.Queue.WINDOWS).blocked > 0 }
+            var pushed = 0L
+            while (!windowsQueued()) {
+                source.push(tone, 0, HOP_SIZE)
+                pushed += HOP_SIZE
+                val expected = if (pushed < WINDOW_SIZE) 0L else (pushed - WINDOW_SIZE) / HOP_SIZE + 1
+                await { framed(engine) >= expected || windowsQueued() }
+            }
+            assertEquals(0L, telemetry.getDeadlineMisses())
+
+            Thread.sleep(DEADLINE_MS * 2L)
+            stall.countDown()
+            await { framed(engine) > 0 && telemetry.getWindowsProcessed() == framed(engine) }
+
+            // 有更新的窗口在排队时过期窗口只做粗略判定；最后一个仍然完整打分，只是超时了
+            val skipped = telemetry.getWindowsSkipped()
+            val misses = telemetry.getDeadlineMisses()
+            assertTrue("stale windows skipped", skipped > 0)
+            assertTrue("newest stale window scored in full", misses > skipped)
+            assertEquals(skipped, engine.getPipelineStats().stage(PipelineStats.Stage.COARSE_SCORING).count)
+
+            // 粗略判定照样覆盖了这些窗口里的咳嗽
+            await { telemetry.snapshot().eventsEmitted == telemetry.getWindowsProcessed() }
+
+            // 积压消化后，新的窗口在截止时间内完整打分
+            val processed = telemetry.getWindowsProcessed()
+            source.push(tone, 0, HOP_SIZE)
+            await { telemetry.getWindowsProcessed() > processed }
+            assertEquals(misses, telemetry.getDeadlineMisses())
+            assertEquals(skipped, telemetry.getWindowsSkipped())
+        } finally {
+            stall.countDown()
+            engine.release()
+        }
+    }
+}
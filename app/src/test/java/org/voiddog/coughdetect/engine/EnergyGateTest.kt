@@ -0,0 +1,76 @@
+package org.voiddog.coughdetect.engine
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.util.Random
+import kotlin.math.PI
+import kotlin.math.sin
+
+class EnergyGateTest {
+
+    companion object {
+        private const val RATE = 16000
+        private const val CHUNK = 1600 // 100ms
+    }
+
+    private val random = Random(11L)
+
+    private fun noise(level: Double) = FloatArray(CHUNK) { (random.nextGaussian() * level).toFloat() }
+
+    private fun burst() = FloatArray(CHUNK) { i -> 0.4f * sin(2 * PI * 700 * i / RATE).toFloat() }
+
+    @Test
+    fun wakesOnBurstAndSleepsAfterQuietPeriod() {
+        val gate = EnergyGate(RATE, EnergyGate.Config(quietPeriodMs = 1000L))
+        repeat(50) { assertFalse(gate.process(noise(0.005), 0, CHUNK)) }
+
+        assertTrue(gate.process(burst(), 0, CHUNK))
+        // 安静 900ms 仍保持激活，满 1 秒后回到监听
+        repeat(9) { assertTrue(gate.process(noise(0.005), 0, CHUNK)) }
+        assertFalse(gate.process(noise(0.005), 0, CHUNK))
+    }
+
+    @Test
+    fun ignoresQuietSoundsBelowAbsoluteThreshold() {
+        val gate = EnergyGate(RATE)
+        repeat(20) { gate.process(noise(0.0005), 0, CHUNK) }
+        // 相对背景噪声很响，但绝对电平仍低于 minRms
+        assertFalse(gate.process(noise(0.01), 0, CHUNK))
+    }
+
+    @Test
+    fun pcm16MatchesFloat() {
+        val floatGate = EnergyGate(RATE)
+        val pcmGate = EnergyGate(RATE)
+        val chunks = List(30) { if (it == 20) burst() else noise(0.005) }
+        for (chunk in chunks) {
+            val pcm = ShortArray(CHUNK) { (chunk[it] * 32768f).toInt().toShort() }
+            assertEquals(floatGate.process(chunk, 0, CHUNK), pcmGate.process(pcm, 0, CHUNK))
+            assertEquals(floatGate.lastRms, pcmGate.lastRms, 1e-4f)
+        }
+        assertTrue(pcmGate.isActive)
+    }
+
+    @Test
+    fun powerMeterSplitsTimeByMode() {
+        val meter = PowerMeter()
+        meter.addCpu(5L) // 没有在计时，忽略
+        meter.switchTo(PowerMeter.Mode.LISTENING, 0L)
+        meter.addCpu(1_000_000L)
+        meter.switchTo(PowerMeter.Mode.FULL, 1_000_000_000L)
+        meter.addCpu(50_000_000L)
+
+        val usage = meter.usage(2_000_000_000L)
+        assertEquals(PowerMeter.Mode.FULL, usage.mode)
+        assertEquals(1_000_000_000L, usage.wallNanos[PowerMeter.Mode.LISTENING.ordinal])
+        assertEquals(1_000_000_000L, usage.wallNanos[PowerMeter.Mode.FULL.ordinal])
+        // 1 秒墙钟里 1ms / 50ms CPU，折算到每小时
+        assertEquals(3.6, usage.cpuSecondsPerHour(PowerMeter.Mode.LISTENING), 1e-9)
+        assertEquals(180.0, usage.cpuSecondsPerHour(PowerMeter.Mode.FULL), 1e-9)
+
+        meter.switchTo(null, 3_000_000_000L)
+        assertEquals(2_000_000_000L, meter.usage(9_000_000_000L).wallNanos[PowerMeter.Mode.FULL.ordinal])
+    }
+}
@@ -0,0 +1,87 @@
+package org.voiddog.coughdetect.engine
+
+import android.content.Context
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.testing.PushAudioSource
+
+class EngineConfigTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val CHUNK_SIZE = 1600
+        private const val TIMEOUT_NS = 5_000_000_000L
+    }
+
+    @Test
+    fun defaultsAreValid() {
+        assertTrue(EngineConfig().validate().isEmpty())
+        assertTrue(EngineConfig.forSensitivity(0f).validate().isEmpty())
+        assertTrue(EngineConfig.forSensitivity(1f).validate().isEmpty())
+    }
+
+    @Test
+    fun rejectsInvalidValues() {
+        assertEquals(1, EngineConfig(windowMs = 5000).validate().size)
+        assertEquals(1, EngineConfig(overlapMs = 1000).validate().size)
+        assertEquals(1, EngineConfig(minConfidence = 1.5f).validate().size)
+        assertEquals(1, EngineConfig(preRollMs = -1).validate().size)
+        assertEquals(1, EngineConfig(governor = LoadGovernor.Config(degradeLoad = 0.3f, upgradeLoad = 0.5f)).validate().size)
+    }
+
+    @Test
+    fun sensitivityIsMonotonic() {
+        val low = EngineConfig.forSensitivity(0.1f)
+        val normal = EngineConfig.forSensitivity(0.5f)
+        val high = EngineConfig.forSensitivity(0.9f)
+
+        assertEquals(EngineConfig(), normal)
+        assertTrue(low.minConfidence > normal.minConfidence && normal.minConfidence > high.minConfidence)
+        assertTrue(low.rules.loudRmsThreshold > high.rules.loudRmsThreshold)
+    }
+
+    @Test
+    fun windowChangeAppliesAtBoundaryWithoutLosingAudio() {
+        val source = PushAudioSource(SAMPLE_RATE, CHUNK_SIZE)
+        val engine = CoughDetectEngine(mock(Context::class.java), source)
+        val telemetry = engine.getTelemetry()
+        val chunk = FloatArray(CHUNK_SIZE)
+        try {
+            check(engine.initialize())
+            check(engine.setConfig(EngineConfig(adaptiveHop = false)))
+            check(engine.start())
+
+            // 1 秒窗口、0.8 秒步长：1.0 秒时出第一个窗口
+            repeat(10) { source.push(chunk, 0, CHUNK_SIZE) }
+            awaitWindows(telemetry, 1)
+
+            // 改成 0.5 秒窗口、0.4 秒步长；剩下的 0.2 秒重叠保留，再送 0.3 秒就能凑满
+            assertTrue(engine.setConfig(EngineConfig(windowMs = 500, overlapMs = 100, adaptiveHop = false)))
+            repeat(3) { source.push(chunk, 0, CHUNK_SIZE) }
+            awaitWindows(telemetry, 2)
+
+            assertEquals(500, engine.getConfig().windowMs)
+            assertEquals(0L, telemetry.getSamplesDropped())
+
+            // 录音中提交无效配置：被拒绝，但不算引擎错误，录音和当前配置都不受影响
+            assertFalse(engine.setConfig(EngineConfig(windowMs = 10)))
+            assertNull(engine.error.value)
+            assertTrue(engine.isRecording() || engine.isProcessing())
+            assertEquals(500, engine.getConfig().windowMs)
+        } finally {
+            engine.release()
+        }
+    }
+
+    private fun awaitWindows(telemetry: EngineTelemetry, expected: Long) {
+        val start = System.nanoTime()
+        while (telemetry.getWindowsProcessed() < expected) {
+            check(System.nanoTime() - start < TIMEOUT_NS) { "window processing timed out" }
+            Thread.yield()
+        }
+    }
+}
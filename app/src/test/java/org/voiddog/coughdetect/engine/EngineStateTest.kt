@@ -0,0 +1,51 @@
+package org.voiddog.coughdetect.engine
+
+import android.content.Context
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.testing.PushAudioSource
+
+class EngineStateTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val CHUNK_SIZE = 1600
+        private const val TIMEOUT_NS = 5_000_000_000L
+    }
+
+    @Test
+    fun scoringNeverOverwritesPause() {
+        val source = PushAudioSource(SAMPLE_RATE, CHUNK_SIZE)
+        val engine = CoughDetectEngine(mock(Context::class.java), source)
+        val telemetry = engine.getTelemetry()
+        val chunk = FloatArray(CHUNK_SIZE)
+        try {
+            check(engine.initialize())
+            check(engine.setConfig(EngineConfig(adaptiveHop = false)))
+            check(engine.start())
+
+            // 评分线程还在处理窗口时暂停；之后处理完的窗口都不能把状态改回 RECORDING
+            repeat(10) { source.push(chunk, 0, CHUNK_SIZE) }
+            engine.pause()
+            repeat(40) { source.push(chunk, 0, CHUNK_SIZE) }
+            awaitWindows(telemetry, 5)
+            assertEquals(CoughDetectEngine.EngineState.PAUSED, engine.getState())
+            assertEquals(CoughDetectEngine.EngineState.PAUSED, engine.engineState.value)
+
+            engine.resume()
+            assertTrue(engine.isRecording() || engine.isProcessing())
+        } finally {
+            engine.release()
+        }
+    }
+
+    private fun awaitWindows(telemetry: EngineTelemetry, expected: Long) {
+        val start = System.nanoTime()
+        while (telemetry.getWindowsProcessed() < expected) {
+            check(System.nanoTime() - start < TIMEOUT_NS) { "window processing timed out" }
+            Thread.yield()
+        }
+    }
+}
@@ -0,0 +1,99 @@
+package org.voiddog.coughdetect.engine
+
+import android.content.Context
+import kotlinx.coroutines.flow.take
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.testing.PushAudioSource
+import java.util.concurrent.LinkedBlockingQueue
+import java.util.concurrent.TimeUnit
+import kotlin.math.PI
+import kotlin.math.sin
+
+/**
+ * 事件带着所在窗口的样本范围和按采样时钟换算的采集时刻，流水线记录采集 → 检测 → 分发的延迟
+ */
+class EventTimingTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val WINDOW_SIZE = SAMPLE_RATE
+        private const val CHUNK_SIZE = SAMPLE_RATE / 10
+    }
+
+    // 持续的响亮音调，每个窗口都判为咳嗽
+    private val tone = FloatArray(CHUNK_SIZE) { i -> 0.5f * sin(2 * PI * 700 * i / SAMPLE_RATE).toFloat() }
+
+    @Test
+    fun eventCarriesSampleRangeAndCaptureTimes() {
+        val source = PushAudioSource(SAMPLE_RATE, CHUNK_SIZE)
+        val engine = CoughDetectEngine(mock(Context::class.java), source)
+        val events = LinkedBlockingQueue<CoughDetectEngine.AudioEvent>()
+        engine.setAudioEventListener { event ->
+            if (event.type == CoughDetectEngine.AudioEventType.COUGH_DETECTED) {
+                events.add(event)
+            }
+        }
+        try {
+            check(engine.setConfig(EngineConfig(adaptiveHop = false)))
+            check(engine.initialize())
+            check(engine.start())
+
+            val wallBefore = System.currentTimeMillis()
+            val before = System.nanoTime()
+            repeat(WINDOW_SIZE / CHUNK_SIZE) { source.push(tone, 0, CHUNK_SIZE) }
+            val after = System.nanoTime()
+
+            val event = events.poll(5, TimeUnit.SECONDS) ?: throw AssertionError("no event")
+            assertEquals(0L, event.startSample)
+            assertEquals(WINDOW_SIZE - 1L, event.endSample)
+
+            // 最后一个样本在最后一块到达时采集（测试音频源没有输入延迟），第一个样本按采样率往前推
+            assertTrue(event.endNanos in before..after)
+            val spanNanos = (WINDOW_SIZE - 1L) * 1_000_000_000L / SAMPLE_RATE
+            assertTrue(kotlin.math.abs(event.endNanos - event.startNanos - spanNanos) < 1_000L)
+            assertTrue(event.detectedNanos >= event.endNanos)
+            // 事件时间是第一个样本的采集时间，比推送开始还早将近一个窗口
+            assertTrue(event.timestamp <= wallBefore)
+            assertTrue(event.timestamp >= wallBefore - 2_000L)
+
+            val stats = engine.getPipelineStats()
+            assertEquals(1L, stats.eventDetectLatencyHistogram.sum())
+            assertEquals(1L, stats.eventDispatchLatencyHistogram.sum())
+            assertTrue(stats.maxEventDispatchLatencyNanos >= event.detectedNanos - event.endNanos)
+        } finally {
+            engine.release()
+        }
+    }
+
+    @Test
+    fun everyEventReachesTheConsumerOnce() {
+        val source = PushAudioSource(SAMPLE_RATE, CHUNK_SIZE)
+        val engine = CoughDetectEngine(mock(Context::class.java), source)
+        try {
+            check(engine.setConfig(EngineConfig(adaptiveHop = false)))
+            check(engine.initialize())
+            check(engine.start())
+
+            // 固定 800ms 步长：2.6 秒音频切出 3 个窗口，连续分发的事件一个都不会被合并掉
+            repeat(26) { source.push(tone, 0, CHUNK_SIZE) }
+            val events = runBlocking { withTimeout(5_000L) { engine.audioEvents.take(3).toList() } }
+            assertEquals(listOf(0L, 12_800L, 25_600L), events.map { it.startSample })
+            assertTrue(events.all { it.audioData?.size == WINDOW_SIZE })
+            events.forEach { engine.releaseAudioEvent(it) }
+
+            // 状态流里的事件不带音频，归还的缓冲区被复用后也不会被读到
+            val last = engine.lastAudioEvent.value ?: throw AssertionError("no last event")
+            assertEquals(25_600L, last.startSample)
+            assertNull(last.audioData)
+        } finally {
+            engine.release()
+        }
+    }
+}
@@ -0,0 +1,52 @@
+package org.voiddog.coughdetect.engine
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Test
+
+class FloatRingBufferTest {
+
+    private fun ramp(from: Int, count: Int) = FloatArray(count) { (from + it).toFloat() }
+
+    private fun contents(buffer: FloatRingBuffer): FloatArray {
+        val out = FloatArray(buffer.size)
+        buffer.peek(out)
+        return out
+    }
+
+    @Test
+    fun wrapsAroundWithoutLosingOrder() {
+        val buffer = FloatRingBuffer(8)
+        assertEquals(0, buffer.write(ramp(0, 6)))
+        buffer.discard(4)
+        assertEquals(0, buffer.write(ramp(6, 5)))
+
+        assertEquals(7, buffer.size)
+        assertArrayEquals(ramp(4, 7), contents(buffer), 0f)
+    }
+
+    @Test
+    fun overflowDropsOldestSamples() {
+        val buffer = FloatRingBuffer(8)
+        buffer.write(ramp(0, 6))
+        assertEquals(3, buffer.write(ramp(6, 5)))
+        assertArrayEquals(ramp(3, 8), contents(buffer), 0f)
+
+        // 一次写入超过容量时只保留最后 capacity 个样本
+        assertEquals(8 + 12, buffer.write(ramp(100, 20), 0, 20))
+        assertArrayEquals(ramp(112, 8), contents(buffer), 0f)
+    }
+
+    @Test
+    fun peekLeavesSamplesInPlace() {
+        val buffer = FloatRingBuffer(16)
+        buffer.write(ramp(0, 10), 2, 6)
+        val window = FloatArray(4)
+        buffer.peek(window, 0, 4)
+
+        assertArrayEquals(ramp(2, 4), window, 0f)
+        assertEquals(6, buffer.size)
+        buffer.clear()
+        assertEquals(0, buffer.size)
+    }
+}
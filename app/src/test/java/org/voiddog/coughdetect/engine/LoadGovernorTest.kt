@@ -0,0 +1,117 @@
+package org.voiddog.coughdetect.engine
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class LoadGovernorTest {
+
+    companion object {
+        // 800ms 步长的实时预算
+        private const val BUDGET_NS = 800_000_000L
+    }
+
+    // 按给定负载（耗时 / 预算）打分 [windows] 个窗口，返回档位切换次数
+    private fun run(governor: LoadGovernor, windows: Int, load: (LoadGovernor.Tier) -> Float): Int {
+        var switches = 0
+        repeat(windows) {
+            val tier = governor.nextTier()
+            if (governor.onWindow(tier, (load(tier) * BUDGET_NS).toLong(), BUDGET_NS)) {
+                switches++
+            }
+        }
+        return switches
+    }
+
+    @Test
+    fun staysOnFullTierWithHeadroom() {
+        val governor = LoadGovernor()
+        assertEquals(0, run(governor, 200) { 0.2f })
+        assertEquals(LoadGovernor.Tier.FULL, governor.tier)
+    }
+
+    @Test
+    fun singleSlowWindowDoesNotDegrade() {
+        val governor = LoadGovernor()
+        // 首次推理的预热
+        governor.onWindow(governor.nextTier(), 3 * BUDGET_NS, BUDGET_NS)
+        assertEquals(0, run(governor, 20) { 0.1f })
+        assertEquals(LoadGovernor.Tier.FULL, governor.tier)
+    }
+
+    @Test
+    fun sustainedOverloadStepsDownOneTierAtATime() {
+        val governor = LoadGovernor()
+        // 模型跟不上，规则检测够用
+        val costs = mapOf(LoadGovernor.Tier.FULL to 1.5f, LoadGovernor.Tier.RULES to 0.3f, LoadGovernor.Tier.ENERGY to 0.05f)
+        run(governor, 10) { costs.getValue(it) }
+        assertEquals(LoadGovernor.Tier.RULES, governor.tier)
+
+        // 规则检测也跟不上时再降一档
+        run(governor, 20) { if (it == LoadGovernor.Tier.RULES) 1.5f else costs.getValue(it) }
+        assertEquals(LoadGovernor.Tier.ENERGY, governor.tier)
+    }
+
+    @Test
+    fun withoutModelSkipsRulesTier() {
+        val governor = LoadGovernor(LoadGovernor.Config(probeWindows = 10), rulesTier = false)
+        val used = mutableSetOf<LoadGovernor.Tier>()
+        var overloaded = true
+        // 没有模型时完整检测就是规则检测，超载直接降到能量筛查
+        run(governor, 10) { used.add(it); if (overloaded && it == LoadGovernor.Tier.FULL) 1.5f else 0.1f }
+        assertEquals(LoadGovernor.Tier.ENERGY, governor.tier)
+
+        // 试探的上一档是完整检测
+        overloaded = false
+        assertEquals(1, run(governor, 20) { used.add(it); 0.1f })
+        assertEquals(LoadGovernor.Tier.FULL, governor.tier)
+        assertFalse(LoadGovernor.Tier.RULES in used)
+    }
+
+    @Test
+    fun loadBetweenThresholdsDoesNotOscillate() {
+        val governor = LoadGovernor()
+        // 完整检测超载，规则检测的负载落在升降档阈值之间
+        val switches = run(governor, 2000) { if (it == LoadGovernor.Tier.FULL) 1.5f else 0.5f }
+        assertEquals(1, switches)
+        assertEquals(LoadGovernor.Tier.RULES, governor.tier)
+    }
+
+    @Test
+    fun failedProbesBackOff() {
+        val config = LoadGovernor.Config(probeWindows = 10, maxProbeWindows = 80)
+        val governor = LoadGovernor(config)
+        var probes = 0
+        repeat(1000) {
+            val tier = governor.nextTier()
+            if (tier == LoadGovernor.Tier.FULL && governor.tier == LoadGovernor.Tier.RULES) {
+                probes++
+            }
+            governor.onWindow(tier, ((if (tier == LoadGovernor.Tier.FULL) 1.5f else 0.2f) * BUDGET_NS).toLong(), BUDGET_NS)
+        }
+        // 间隔 10, 20, 40, 80, 80, ... 个窗口
+        assertTrue("probes $probes", probes in 10..16)
+        assertEquals(LoadGovernor.Tier.RULES, governor.tier)
+    }
+
+    @Test
+    fun recoversWhenHeadroomReturns() {
+        val governor = LoadGovernor(LoadGovernor.Config(probeWindows = 10))
+        var overloaded = true
+        run(governor, 10) { if (overloaded && it == LoadGovernor.Tier.FULL) 1.5f else 0.1f }
+        assertEquals(LoadGovernor.Tier.RULES, governor.tier)
+
+        overloaded = false
+        assertEquals(1, run(governor, 20) { 0.1f })
+        assertEquals(LoadGovernor.Tier.FULL, governor.tier)
+    }
+
+    @Test
+    fun disabledGovernorNeverSwitches() {
+        val governor = LoadGovernor(LoadGovernor.Config(enabled = false))
+        assertEquals(0, run(governor, 100) { 5f })
+        assertEquals(LoadGovernor.Tier.FULL, governor.tier)
+        assertFalse(governor.loadOf(LoadGovernor.Tier.FULL) >= 0f)
+    }
+}
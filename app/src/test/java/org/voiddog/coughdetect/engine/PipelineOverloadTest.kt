@@ -0,0 +1,103 @@
+package org.voiddog.coughdetect.engine
+
+import android.content.Context
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.testing.PushAudioSource
+import java.util.concurrent.CountDownLatch
+import kotlin.math.PI
+import kotlin.math.sin
+
+/**
+ * 分发阶段卡住时，过载按配置的策略退化，音频线程始终不被阻塞
+ */
+class PipelineOverloadTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val WINDOW_SIZE = SAMPLE_RATE
+        private const val HOP_SIZE = WINDOW_SIZE - SAMPLE_RATE * 200 / 1000
+        private const val TIMEOUT_NS = 5_000_000_000L
+    }
+
+    // 持续的响亮音调，每个窗口都判为咳嗽
+    private val tone = FloatArray(HOP_SIZE) { i -> 0.5f * sin(2 * PI * 700 * i / SAMPLE_RATE).toFloat() }
+
+    private fun framed(engine: CoughDetectEngine): Long =
+        engine.getPipelineStats().stage(PipelineStats.Stage.FRAMING).count
+
+    private fun await(condition: () -> Boolean) {
+        val start = System.nanoTime()
+        while (!condition()) {
+            check(System.nanoTime() - start < TIMEOUT_NS) { "pipeline timed out" }
+            Thread.yield()
+        }
+    }
+
+    private fun stalledEngine(policy: EngineConfig.OverloadPolicy, stall: CountDownLatch): Pair<CoughDetectEngine, PushAudioSource> {
+        val source = PushAudioSource(SAMPLE_RATE, HOP_SIZE)
+        val engine = CoughDetectEngine(mock(Context::class.java), source)
+        engine.setAudioEventListener { stall.await() }
+        check(engine.setConfig(EngineConfig(overloadPolicy = policy, adaptiveHop = false)))
+        check(engine.initialize())
+        check(engine.start())
+        return engine to source
+    }
+
+    @Test
+    fun dropOldestDropsWindowsInsteadOfAudio() {
+        val stall = CountDownLatch(1)
+        val (engine, source) = stalledEngine(EngineConfig.OverloadPolicy.DROP_OLDEST, stall)
+        try {
+            // 每送一个步长等分帧切完，历史缓冲区不会溢出
+            var pushed = 0L
+            repeat(40) {
+                source.push(tone, 0, HOP_SIZE)
+                pushed += HOP_SIZE
+                val expected = if (pushed < WINDOW_SIZE) 0L else (pushed - WINDOW_SIZE) / HOP_SIZE + 1
+                await { framed(engine) >= expected }
+            }
+
+            val stats = engine.getPipelineStats()
+            val windows = stats.queue(PipelineStats.Queue.WINDOWS)
+            assertTrue("windows dropped", windows.dropped > 0)
+            assertTrue(windows.highWater <= windows.capacity)
+            assertEquals(0L, windows.blocked)
+            assertEquals(0L, engine.getTelemetry().getSamplesDropped())
+            assertTrue(stats.queue(PipelineStats.Queue.EVENTS).blocked > 0)
+        } finally {
+            stall.countDown()
+            engine.release()
+        }
+    }
+
+    @Test
+    fun blockBackpressuresIntoHistoryRing() {
+        val stall = CountDownLatch(1)
+        val (engine, source) = stalledEngine(EngineConfig.OverloadPolicy.BLOCK, stall)
+        val stats = { engine.getPipelineStats().queue(PipelineStats.Queue.WINDOWS) }
+        try {
+            var pushed = 0L
+            while (stats().blocked == 0L) {
+                source.push(tone, 0, HOP_SIZE)
+                pushed += HOP_SIZE
+                val expected = if (pushed < WINDOW_SIZE) 0L else (pushed - WINDOW_SIZE) / HOP_SIZE + 1
+                await { framed(engine) >= expected || stats().blocked > 0 }
+            }
+
+            // 分帧停下后继续送音频：推送照常返回，历史缓冲区满了丢弃最旧的样本
+            val framedWhenBlocked = framed(engine)
+            repeat(10) { source.push(tone, 0, HOP_SIZE) }
+
+            assertTrue(engine.getTelemetry().getSamplesDropped() > 0)
+            assertEquals(0L, stats().dropped)
+            assertEquals(stats().capacity, stats().depth)
+            assertEquals(framedWhenBlocked, framed(engine))
+        } finally {
+            stall.countDown()
+            engine.release()
+        }
+    }
+}
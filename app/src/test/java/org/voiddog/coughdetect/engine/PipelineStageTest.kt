@@ -0,0 +1,43 @@
+package org.voiddog.coughdetect.engine
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import org.voiddog.coughdetect.utils.ThreadPlacement
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicInteger
+
+class PipelineStageTest {
+
+    @Test
+    fun stageStuckInWorkIsNotRestartedUntilItExits() {
+        val entered = CountDownLatch(1)
+        val release = CountDownLatch(1)
+        val concurrent = AtomicInteger(0)
+        val maxConcurrent = AtomicInteger(0)
+        val stage = PipelineStage("test-stage", ThreadPlacement.Role.ANALYSIS, null, { throw it }) {
+            maxConcurrent.accumulateAndGet(concurrent.incrementAndGet()) { a, b -> maxOf(a, b) }
+            entered.countDown()
+            release.await()
+            concurrent.decrementAndGet()
+            1_000_000L
+        }
+
+        assertTrue(stage.start())
+        assertTrue(entered.await(5, TimeUnit.SECONDS))
+
+        // 这次 work 还没返回：停止超时，线程仍在退出中，不能再起一个循环
+        assertFalse(stage.stop(50L))
+        assertTrue(stage.isStopping)
+        assertFalse(stage.start())
+
+        release.countDown()
+        stage.getThread()!!.join(5_000L)
+        assertFalse(stage.isStopping)
+        assertTrue(stage.start())
+        assertTrue(stage.stop(5_000L))
+        assertEquals(1, maxConcurrent.get())
+    }
+}
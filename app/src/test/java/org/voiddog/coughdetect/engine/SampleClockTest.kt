@@ -0,0 +1,91 @@
+package org.voiddog.coughdetect.engine
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.util.Random
+
+class SampleClockTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val CHUNK = 1600
+        private const val CHUNK_NANOS = 100_000_000L
+        private const val T0 = 5_000_000_000L
+    }
+
+    // 第 [index] 个样本的真实采集时刻
+    private fun trueNanos(index: Long): Long = T0 + index * 1_000_000_000L / SAMPLE_RATE
+
+    @Test
+    fun callbackJitterDoesNotMoveTimestamps() {
+        val clock = SampleClock(SAMPLE_RATE)
+        val random = Random(3)
+        var end = 0L
+        repeat(100) {
+            end += CHUNK
+            // 回调总是在采集之后 2~10ms 到达
+            clock.onChunk(end, CHUNK, trueNanos(end - 1) + 2_000_000L + random.nextInt(8_000_000))
+        }
+
+        // 跟踪的是最早的到达，误差不超过最小的回调延迟加一点余量
+        for (index in listOf(0L, 12_345L, end - 1)) {
+            val error = clock.captureNanosAt(index) - trueNanos(index)
+            assertTrue("error $error", error in 0L..3_000_000L)
+        }
+        assertTrue("segments ${clock.segmentCount}", clock.segmentCount < 16)
+    }
+
+    @Test
+    fun timestampsIncreaseWithSampleIndex() {
+        val clock = SampleClock(SAMPLE_RATE)
+        val random = Random(5)
+        var end = 0L
+        var gap = 0L
+        repeat(200) { chunk ->
+            end += CHUNK
+            // 回调延迟 0~40ms，不时有 300ms 的采集中断
+            if (chunk % 37 == 36) gap += 300_000_000L
+            clock.onChunk(end, CHUNK, trueNanos(end - 1) + gap + random.nextInt(40_000_000))
+
+            // 最近一秒的样本按序号换算出的时刻严格递增，跨段处也一样
+            var previous = Long.MIN_VALUE
+            for (index in maxOf(0L, end - SAMPLE_RATE) until end step 400L) {
+                val nanos = clock.captureNanosAt(index)
+                assertTrue("index $index", nanos > previous)
+                previous = nanos
+            }
+        }
+    }
+
+    @Test
+    fun captureGapReanchorsWithoutMovingEarlierSamples() {
+        val clock = SampleClock(SAMPLE_RATE)
+        var end = 0L
+        repeat(10) {
+            end += CHUNK
+            clock.onChunk(end, CHUNK, trueNanos(end - 1))
+        }
+        val beforeGap = end - 1
+        assertEquals(trueNanos(beforeGap), clock.captureNanosAt(beforeGap))
+
+        // 中断 500ms：之后的样本序号连续，采集时刻晚了 500ms
+        val gapNanos = 500_000_000L
+        repeat(10) {
+            end += CHUNK
+            clock.onChunk(end, CHUNK, trueNanos(end - 1) + gapNanos)
+        }
+        assertEquals(trueNanos(beforeGap), clock.captureNanosAt(beforeGap))
+        assertEquals(trueNanos(beforeGap + 1) + gapNanos, clock.captureNanosAt(beforeGap + 1))
+        assertEquals(trueNanos(end - 1) + gapNanos, clock.captureNanosAt(end - 1))
+    }
+
+    @Test
+    fun noAnchorYet() {
+        val clock = SampleClock(SAMPLE_RATE)
+        assertEquals(0L, clock.captureNanosAt(100L))
+        clock.onChunk(CHUNK.toLong(), CHUNK, T0 + CHUNK_NANOS)
+        clock.reset()
+        assertEquals(0, clock.segmentCount)
+    }
+}
@@ -0,0 +1,69 @@
+package org.voiddog.coughdetect.engine
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Test
+
+class ShortRingBufferTest {
+
+    private fun ramp(from: Int, count: Int) = ShortArray(count) { (from + it).toShort() }
+
+    private fun contents(buffer: ShortRingBuffer): ShortArray {
+        val out = ShortArray(buffer.size)
+        buffer.peekPcm16(out)
+        return out
+    }
+
+    @Test
+    fun wrapsAroundWithoutLosingOrder() {
+        val buffer = ShortRingBuffer(8)
+        assertEquals(0, buffer.writePcm16(ramp(0, 6)))
+        buffer.discard(4)
+        assertEquals(0, buffer.writePcm16(ramp(6, 5)))
+
+        assertEquals(7, buffer.size)
+        assertArrayEquals(ramp(4, 7), contents(buffer))
+    }
+
+    @Test
+    fun overflowDropsOldestSamples() {
+        val buffer = ShortRingBuffer(8)
+        buffer.writePcm16(ramp(0, 6))
+        assertEquals(3, buffer.writePcm16(ramp(6, 5)))
+        assertArrayEquals(ramp(3, 8), contents(buffer))
+
+        assertEquals(8 + 12, buffer.writePcm16(ramp(100, 20), 0, 20))
+        assertArrayEquals(ramp(112, 8), contents(buffer))
+    }
+
+    @Test
+    fun convertsAtTheFloatBoundary() {
+        val buffer = ShortRingBuffer(8)
+        buffer.writePcm16(shortArrayOf(0, 16384, -16384, Short.MIN_VALUE))
+        buffer.discard(2)
+        // 越界的 float 写入时截断
+        buffer.write(floatArrayOf(0.5f, 2f, -2f, 0.25f, -0.25f, 0f), 0, 6)
+
+        val window = FloatArray(buffer.size)
+        buffer.peek(window, 0, buffer.size)
+        val expected = floatArrayOf(-0.5f, -1f, 16383 / 32768f, 32767 / 32768f, -32767 / 32768f, 8191 / 32768f, -8191 / 32768f, 0f)
+        assertArrayEquals(expected, window, 0f)
+    }
+
+    @Test
+    fun floatHistoryMatchesPcm16SourceWithinQuantization() {
+        val floats = FloatRingBuffer(16)
+        val shorts = ShortRingBuffer(16)
+        val samples = FloatArray(24) { i -> (i - 12) / 13f }
+        floats.write(samples, 0, samples.size)
+        shorts.write(samples, 0, samples.size)
+
+        val a = FloatArray(16)
+        val b = FloatArray(16)
+        floats.peek(a, 0, 16)
+        shorts.peek(b, 0, 16)
+        assertArrayEquals(a, b, 1f / 16384)
+        assertEquals(2, shorts.bytesPerSample)
+        assertEquals(4, floats.bytesPerSample)
+    }
+}
@@ -0,0 +1,122 @@
+package org.voiddog.coughdetect.engine
+
+import android.content.Context
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotNull
+import org.junit.Assume.assumeTrue
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.audio.SampleFormat
+import org.voiddog.coughdetect.testing.AllocationCounter
+import org.voiddog.coughdetect.testing.PushAudioSource
+import java.util.Random
+import java.util.concurrent.atomic.AtomicReference
+import kotlin.math.PI
+import kotlin.math.sin
+
+/**
+ * 预热之后，录音回调（音频线程）和检测流水线的各阶段线程都不应再分配堆内存
+ */
+class SteadyStateAllocationTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val CHUNK_SIZE = 2560
+        private const val WINDOW_SIZE = SAMPLE_RATE
+        private const val HOP_SIZE = WINDOW_SIZE - SAMPLE_RATE * 200 / 1000
+        private const val TIMEOUT_NS = 5_000_000_000L
+    }
+
+    private var pushed = 0L
+
+    private fun signal(seconds: Int, withCoughs: Boolean): FloatArray {
+        val random = Random(7L)
+        val samples = FloatArray(seconds * SAMPLE_RATE) { (random.nextGaussian() * 0.01).toFloat() }
+        if (withCoughs) {
+            var onset = SAMPLE_RATE
+            while (onset + SAMPLE_RATE / 4 < samples.size) {
+                for (i in 0 until SAMPLE_RATE / 4) {
+                    samples[onset + i] += 0.5f * sin(2 * PI * 700 * i / SAMPLE_RATE).toFloat()
+                }
+                onset += SAMPLE_RATE * 3
+            }
+        }
+        return samples
+    }
+
+    // 逐块送入并等待由此凑满的窗口处理完，保证没有样本被丢弃
+    private fun feed(source: PushAudioSource, telemetry: EngineTelemetry, samples: FloatArray) {
+        var offset = 0
+        while (offset < samples.size) {
+            val length = minOf(CHUNK_SIZE, samples.size - offset)
+            source.push(samples, offset, length)
+            offset += length
+            pushed += length
+
+            val expected = if (pushed < WINDOW_SIZE) 0L else (pushed - WINDOW_SIZE) / HOP_SIZE + 1
+            val start = System.nanoTime()
+            while (telemetry.getWindowsProcessed() < expected) {
+                check(System.nanoTime() - start < TIMEOUT_NS) { "window processing timed out" }
+                Thread.yield()
+            }
+        }
+    }
+
+    @Test
+    fun recordingPathDoesNotAllocateAfterWarmup() {
+        assertAllocationFree(SampleFormat.FLOAT, pcm16Source = false)
+    }
+
+    @Test
+    fun pcm16HistoryDoesNotAllocateAfterWarmup() {
+        assertAllocationFree(SampleFormat.PCM16, pcm16Source = true)
+        // float 音频源写入 PCM16 历史时在写入处转换
+        assertAllocationFree(SampleFormat.PCM16, pcm16Source = false)
+    }
+
+    private fun assertAllocationFree(format: SampleFormat, pcm16Source: Boolean) {
+        assumeTrue("JVM does not report per-thread allocations", AllocationCounter.isSupported)
+
+        pushed = 0L
+        val source = PushAudioSource(SAMPLE_RATE, CHUNK_SIZE, pcm16Source)
+        val engine = CoughDetectEngine(mock(Context::class.java), source, format)
+        val telemetry = engine.getTelemetry()
+
+        val dispatchThread = AtomicReference<Thread>()
+        engine.setAudioEventListener { dispatchThread.set(Thread.currentThread()) }
+
+        try {
+            // 固定步长，按步长推算窗口数；自适应步长的活动检测在 AdaptiveHopTest 中覆盖
+            check(engine.setConfig(EngineConfig(adaptiveHop = false)))
+            check(engine.initialize())
+            check(engine.start())
+
+            // 预热：包括咳嗽事件路径，让类加载和 JIT 编译都在测量之前完成
+            feed(source, telemetry, signal(30, withCoughs = true))
+            assertNotNull("warm-up should have produced cough events", dispatchThread.get())
+
+            // 流水线每个阶段一个线程，都要测量
+            val pipeline = Thread.getAllStackTraces().keys.filter {
+                it.isAlive && it.name.startsWith(CoughDetectEngine.PIPELINE_THREAD_PREFIX)
+            }
+            assertEquals(3, pipeline.size)
+
+            val steadyState = signal(30, withCoughs = false)
+            val audio = Thread.currentThread()
+            // 对音频线程的两次查询紧贴测量区间，区间内只多出一次查询自身的开销
+            val pipelineBefore = pipeline.map { AllocationCounter.allocatedBytes(it) }
+            val audioBefore = AllocationCounter.allocatedBytes(audio)
+            feed(source, telemetry, steadyState)
+            val audioAfter = AllocationCounter.allocatedBytes(audio)
+            val pipelineAfter = pipeline.map { AllocationCounter.allocatedBytes(it) }
+
+            assertEquals(0L, telemetry.getSamplesDropped())
+            assertEquals("audio thread bytes", 0L, audioAfter - audioBefore - AllocationCounter.selfOverhead)
+            for (i in pipeline.indices) {
+                assertEquals("${pipeline[i].name} bytes", 0L, pipelineAfter[i] - pipelineBefore[i])
+            }
+        } finally {
+            engine.release()
+        }
+    }
+}
@@ -0,0 +1,56 @@
+package org.voiddog.coughdetect.engine
+
+import android.content.Context
+import org.junit.Assert.assertEquals
+import org.junit.Test
+import org.mockito.Mockito.mock
+import org.voiddog.coughdetect.testing.PushAudioSource
+
+class StreamGapTest {
+
+    companion object {
+        private const val SAMPLE_RATE = 16000
+        private const val CHUNK_SIZE = 1600
+        private const val TIMEOUT_NS = 5_000_000_000L
+    }
+
+    private fun feed(source: PushAudioSource, chunks: Int) {
+        val chunk = FloatArray(CHUNK_SIZE)
+        repeat(chunks) { source.push(chunk, 0, CHUNK_SIZE) }
+    }
+
+    private fun awaitWindows(telemetry: EngineTelemetry, expected: Long) {
+        val start = System.nanoTime()
+        while (telemetry.getWindowsProcessed() < expected) {
+            check(System.nanoTime() - start < TIMEOUT_NS) { "window processing timed out" }
+            Thread.yield()
+        }
+    }
+
+    @Test
+    fun gapKeepsWindowingStateAndIsAccounted() {
+        val source = PushAudioSource(SAMPLE_RATE, CHUNK_SIZE)
+        val engine = CoughDetectEngine(mock(Context::class.java), source)
+        val telemetry = engine.getTelemetry()
+        try {
+            check(engine.initialize())
+            check(engine.start())
+
+            // 0.6 秒后断开 250ms，重连后再送 0.4 秒：两段拼起来正好凑满一个窗口
+            feed(source, 6)
+            source.gap(SAMPLE_RATE / 4L)
+            feed(source, 4)
+            awaitWindows(telemetry, 1)
+
+            assertEquals(250L, engine.getLostAudioMs())
+            assertEquals(1L, telemetry.getGapCount())
+            assertEquals(
+                listOf(CoughDetectEngine.GapMarker(6L * CHUNK_SIZE, SAMPLE_RATE / 4L)),
+                engine.getGapMarkers()
+            )
+            assertEquals(0L, telemetry.getSamplesDropped())
+        } finally {
+            engine.release()
+        }
+    }
+}
@@ -0,0 +1,54 @@
+package org.voiddog.coughdetect.ml
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import java.util.Random
+import kotlin.math.PI
+import kotlin.math.sin
+
+class MfccFrontEndTest {
+
+    private fun tone(hz: Double, size: Int = 16000) =
+        FloatArray(size) { i -> 0.5f * sin(2 * PI * hz * i / 16000).toFloat() }
+
+    @Test
+    fun productionMatchesGenericFrontEnd() {
+        val random = Random(3L)
+        val samples = FloatArray(16000) { (random.nextGaussian() * 0.1).toFloat() }
+        val generic = MfccFrontEnd()
+        val production = ProductionMfccFrontEnd()
+        val frames = generic.frameCount(samples.size)
+        val expected = FloatArray(frames * 13)
+        val actual = FloatArray(frames * 13)
+
+        assertEquals(frames, generic.process(samples, 0, samples.size, expected))
+        assertEquals(frames, production.process(samples, 0, samples.size, actual))
+        assertEquals(97, frames)
+        for (i in expected.indices) {
+            assertEquals("coefficient $i", expected[i], actual[i], 1e-4f)
+        }
+    }
+
+    @Test
+    fun firstCepstrumTracksSpectralTilt() {
+        val frontEnd = ProductionMfccFrontEnd()
+        val low = FloatArray(13)
+        val high = FloatArray(13)
+        frontEnd.process(tone(500.0), 0, 512, low)
+        frontEnd.process(tone(5000.0), 0, 512, high)
+
+        // c1 以正权重加总低频带、负权重加总高频带
+        assertTrue("c1 low ${low[1]} high ${high[1]}", low[1] > high[1])
+    }
+
+    @Test
+    fun genericConfigurationsProduceFrames() {
+        val frontEnd = MfccFrontEnd(MfccFrontEnd.Config(sampleRate = 8000, frameSize = 256, hopSize = 80, melBands = 24, cepstra = 12))
+        val out = FloatArray(frontEnd.frameCount(8000) * 12)
+
+        assertEquals(97, frontEnd.process(tone(440.0, 8000), 0, 8000, out))
+        assertTrue(out.all { it.isFinite() })
+        assertEquals(0, frontEnd.frameCount(100))
+    }
+}
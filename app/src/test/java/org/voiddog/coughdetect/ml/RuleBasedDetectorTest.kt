@@ -0,0 +1,60 @@
+package org.voiddog.coughdetect.ml
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import kotlin.math.PI
+import kotlin.math.sin
+
+class RuleBasedDetectorTest {
+
+    private val detector = RuleBasedDetector()
+
+    @Test
+    fun featuresRespectOffsetAndLength() {
+        val data = FloatArray(300)
+        for (i in 100 until 200) {
+            data[i] = if (i % 2 == 0) 0.5f else -0.5f
+        }
+
+        assertEquals(0.5f, AudioFeatures.rms(data, 100, 100), 1e-6f)
+        assertEquals(0.99f, AudioFeatures.zeroCrossingRate(data, 100, 100), 1e-6f)
+        assertEquals(0f, AudioFeatures.rms(data, 0, 100), 0f)
+        assertEquals(49.5f, AudioFeatures.spectralCentroid(data, 100, 100), 1e-3f)
+    }
+
+    @Test
+    fun pcm16ConversionIsNormalized() {
+        val target = FloatArray(3)
+        AudioFeatures.pcm16ToFloat(shortArrayOf(Short.MIN_VALUE, 0, 16384), target, 3)
+
+        assertEquals(-1f, target[0], 0f)
+        assertEquals(0f, target[1], 0f)
+        assertEquals(0.5f, target[2], 0f)
+    }
+
+    @Test
+    fun loudBurstIsCoughAndSilenceIsNot() {
+        val burst = FloatArray(16000) { i -> 0.4f * sin(2 * PI * 900 * i / 16000).toFloat() }
+        val result = detector.detect(burst)
+        assertTrue(result.isCough)
+        assertEquals(result.confidence, result.coughProbability, 0f)
+
+        val silence = detector.detect(FloatArray(16000))
+        assertFalse(silence.isCough)
+        assertEquals(1f, silence.confidence, 0f)
+    }
+
+    @Test
+    fun coarsePassScreensQuietWindowsAndMatchesDetectOtherwise() {
+        val burst = FloatArray(16000) { i -> 0.4f * sin(2 * PI * 900 * i / 16000).toFloat() }
+        assertEquals(detector.detect(burst), detector.detectCoarse(burst, 0, burst.size, 4))
+
+        // 能量远低于规则阈值：直接判为非咳嗽，置信度和完整检测一致
+        val quiet = FloatArray(16000) { i -> 0.01f * sin(2 * PI * 900 * i / 16000).toFloat() }
+        val coarse = detector.detectCoarse(quiet, 0, quiet.size, 4)
+        assertFalse(coarse.isCough)
+        assertEquals(detector.detect(quiet).confidence, coarse.confidence, 1e-3f)
+    }
+}
@@ -0,0 +1,55 @@
+package org.voiddog.coughdetect.ml
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+import kotlin.math.PI
+import kotlin.math.sin
+
+class SpectralAnalyzerTest {
+
+    private fun sine(hz: Double, size: Int = 16000) =
+        FloatArray(size) { i -> 0.5f * sin(2 * PI * hz * i / 16000).toFloat() }
+
+    @Test
+    fun centroidFollowsToneFrequency() {
+        val analyzer = SpectralAnalyzer()
+        val arena = ScratchArena(analyzer.scratchSize)
+
+        for (hz in doubleArrayOf(500.0, 1000.0, 3000.0)) {
+            val spectrum = analyzer.meanMagnitudeSpectrum(sine(hz), 0, 16000, arena)
+            val centroid = analyzer.centroidHz(arena.buffer, spectrum)
+            assertEquals("tone $hz Hz", hz, centroid.toDouble(), 100.0)
+            arena.reset()
+        }
+        assertEquals(0, arena.used)
+        assertEquals(analyzer.scratchSize, arena.highWaterMark)
+    }
+
+    @Test(expected = IllegalStateException::class)
+    fun arenaRejectsOverflow() {
+        val arena = ScratchArena(16)
+        arena.allocate(10)
+        arena.allocate(10)
+    }
+
+    @Test
+    fun arenaMarkReleasesNestedScratch() {
+        val arena = ScratchArena(64)
+        val outer = arena.allocate(8)
+        val mark = arena.mark()
+        arena.allocate(32)
+        arena.release(mark)
+        assertEquals(8, arena.allocate(4) - outer)
+    }
+
+    @Test
+    fun spectralDetectorUsesHertz() {
+        val detector = RuleBasedDetector(RuleBasedDetector.Config(spectralCentroid = true))
+        val low = detector.extractFeatures(sine(300.0))
+        val high = detector.extractFeatures(sine(4000.0))
+
+        assertTrue(low.spectralCentroid < 2000f)
+        assertTrue(high.spectralCentroid > 2000f)
+    }
+}
@@ -0,0 +1,79 @@
+package org.voiddog.coughdetect.testing
+
+import java.lang.reflect.Method
+
+/**
+ * 按线程统计堆分配字节数
+ *
+ * 基于 HotSpot 的 com.sun.management.ThreadMXBean.getThreadAllocatedBytes，JVM 在 TLAB
+ * 层面精确计数，可以统计任意线程（包括协程工作线程）。android.jar 中没有
+ * java.lang.management，只能反射调用；JVM 不支持时 [isSupported] 为 false。
+ */
+object AllocationCounter {
+
+    private val threadMXBean: Any? = try {
+        Class.forName("java.lang.management.ManagementFactory")
+            .getMethod("getThreadMXBean")
+            .invoke(null)
+    } catch (e: Throwable) {
+        null
+    }
+
+    private val allocatedBytesMethod: Method? = try {
+        Class.forName("com.sun.management.ThreadMXBean")
+            .getMethod("getThreadAllocatedBytes", Long::class.javaPrimitiveType)
+            .takeIf { threadMXBean != null }
+    } catch (e: Throwable) {
+        null
+    }
+
+    private val cpuTimeMethod: Method? = try {
+        Class.forName("java.lang.management.ThreadMXBean")
+            .getMethod("getCurrentThreadCpuTime")
+            .takeIf { threadMXBean != null }
+    } catch (e: Throwable) {
+        null
+    }
+
+    val isSupported: Boolean
+        get() = allocatedBytes(Thread.currentThread()) >= 0
+
+    /**
+     * [thread] 从启动到现在分配的总字节数，不支持时返回 -1
+     */
+    fun allocatedBytes(thread: Thread): Long {
+        val method = allocatedBytesMethod ?: return -1L
+        return try {
+            method.invoke(threadMXBean, thread.id) as Long
+        } catch (e: Throwable) {
+            -1L
+        }
+    }
+
+    /**
+     * 在当前线程上调用一次 [allocatedBytes] 本身产生的分配（反射的参数数组和装箱），
+     * 统计当前线程时需要扣除
+     */
+    val selfOverhead: Long by lazy {
+        val thread = Thread.currentThread()
+        var minimum = Long.MAX_VALUE
+        repeat(16) {
+            val before = allocatedBytes(thread)
+            val after = allocatedBytes(thread)
+            minimum = minOf(minimum, after - before)
+        }
+        minimum.coerceAtLeast(0L)
+    }
+
+    /**
+     * 当前线程的 CPU 时间（纳秒）；JVM 不支持时退回墙钟时间
+     */
+    fun currentThreadCpuNanos(): Long {
+        val method = cpuTimeMethod ?: return System.nanoTime()
+        return try {
+            (method.invoke(threadMXBean) as Long).takeIf { it >= 0 } ?: System.nanoTime()
+        } catch (e: Throwable) {
+            System.nanoTime()
+        }
+    }
+}
@@ -0,0 +1,62 @@
+package org.voiddog.coughdetect.testing
+
+import org.voiddog.coughdetect.audio.AudioDataCallback
+import org.voiddog.coughdetect.audio.AudioSource
+import org.voiddog.coughdetect.audio.Pcm16DataCallback
+import org.voiddog.coughdetect.audio.StreamGapCallback
+import org.voiddog.coughdetect.ml.AudioFeatures
+
+/**
+ * 由测试线程推送数据的音频源，回调在调用 [push] 的线程上同步执行，
+ * 和 AudioRecorder 一样复用同一个块缓冲区。
+ * [pcm16] 为 true 时和 16kHz 的 AudioRecorder 一样以 16-bit PCM 交付。
+ */
+class PushAudioSource(
+    private val sampleRate: Int = 16000,
+    maxChunkSize: Int = 4096,
+    private val pcm16: Boolean = false
+) : AudioSource {
+
+    private var callback: AudioDataCallback? = null
+    private var pcm16Callback: Pcm16DataCallback? = null
+    private var gapCallback: StreamGapCallback? = null
+    private val chunk = FloatArray(maxChunkSize)
+    private val pcmChunk = ShortArray(maxChunkSize)
+
+    fun push(samples: FloatArray, offset: Int, length: Int) {
+        val pcmCallback = pcm16Callback
+        if (pcmCallback != null) {
+            AudioFeatures.floatToPcm16(samples, offset, pcmChunk, 0, length)
+            pcmCallback.onPcm16Data(pcmChunk, length, AudioFeatures.rmsPcm16(pcmChunk, 0, length))
+            return
+        }
+        samples.copyInto(chunk, 0, offset, offset + length)
+        callback?.onAudioData(chunk, length, AudioFeatures.rms(chunk, 0, length))
+    }
+
+    /**
+     * 模拟流断开后重新打开：报告中断期间丢失的 [lostSamples] 个样本
+     */
+    fun gap(lostSamples: Long) {
+        gapCallback?.onStreamGap(lostSamples, lostSamples * 1_000_000_000L / sampleRate)
+    }
+
+    override fun initialize(): Boolean = true
+    override fun start(): Boolean = true
+    override fun stop() {}
+    override fun pause() {}
+    override fun resume() {}
+    override fun release() {}
+    override fun getSampleRate(): Int = sampleRate
+    override fun setAudioDataCallback(callback: AudioDataCallback) {
+        this.callback = callback
+    }
+    override fun supportsPcm16(): Boolean = pcm16
+    override fun setPcm16DataCallback(callback: Pcm16DataCallback?) {
+        if (pcm16) pcm16Callback = callback
+    }
+    override fun setStreamGapCallback(callback: StreamGapCallback?) {
+        gapCallback = callback
+    }
+    override fun clearError() {}
+}
@@ -0,0 +1,85 @@
+package org.voiddog.coughdetect.utils
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+import java.io.File
+
+class ThreadPlacementTest {
+
+    @get:Rule
+    val folder = TemporaryFolder()
+
+    private fun cpu(root: File, index: Int, file: String, value: Long) {
+        File(root, "cpu$index/$file").apply {
+            parentFile!!.mkdirs()
+            writeText("$value\n")
+        }
+    }
+
+    @Test
+    fun bigLittleCapacitiesMarkEfficientCores() {
+        val root = folder.newFolder("cpu")
+        for (i in 0..3) cpu(root, i, "cpu_capacity", 410)
+        for (i in 4..6) cpu(root, i, "cpu_capacity", 870)
+        cpu(root, 7, "cpu_capacity", 1024)
+        // 不是核心的目录被忽略
+        File(root, "cpufreq").mkdirs()
+
+        val cores = ThreadPlacement.readCores(root)
+        assertEquals((0..7).toList(), cores.map { it.cpu })
+        assertEquals(listOf(true, true, true, true, true, true, true, false), cores.map { it.efficient })
+        // 有更快的核，推理时提升优先级
+        assertTrue(ThreadPlacement.hasFasterCores(cores))
+    }
+
+    @Test
+    fun fallsBackToMaxFrequency() {
+        val root = folder.newFolder("cpu")
+        cpu(root, 0, "cpufreq/cpuinfo_max_freq", 1_800_000)
+        cpu(root, 1, "cpufreq/cpuinfo_max_freq", 2_400_000)
+
+        val cores = ThreadPlacement.readCores(root)
+        assertEquals(listOf(1_800_000L, 2_400_000L), cores.map { it.capacity })
+        assertEquals(listOf(true, false), cores.map { it.efficient })
+    }
+
+    @Test
+    fun homogeneousCoresAreNotEfficient() {
+        val root = folder.newFolder("cpu")
+        for (i in 0..3) cpu(root, i, "cpu_capacity", 1024)
+        val cores = ThreadPlacement.readCores(root)
+        assertTrue(cores.none { it.efficient })
+        // 没有更快的核可迁，推理时不提升优先级；读不到 sysfs 时同样
+        assertFalse(ThreadPlacement.hasFasterCores(cores))
+        assertTrue(ThreadPlacement.readCores(File(root, "missing")).isEmpty())
+        assertFalse(ThreadPlacement.hasFasterCores(emptyList()))
+    }
+
+    @Test
+    fun parsesSchedCounters() {
+        val sched = """
+            CoughPipeline-s (12345, #threads: 30)
+            -------------------------------------------------------------------
+            se.exec_start                                :      81234567.123456
+            se.nr_migrations                             :                   17
+            nr_switches                                  :                  240
+            nr_wakeups                                   :                  231
+        """.trimIndent()
+        assertArrayEquals(longArrayOf(231L, 17L), ThreadPlacement.parseSchedCounters(sched))
+        assertArrayEquals(longArrayOf(-1L, -1L), ThreadPlacement.parseSchedCounters(null))
+    }
+
+    @Test
+    fun parsesLastCpuAfterThreadName() {
+        // 线程名里有空格和括号
+        val fields = (3..52).map { if (it == 39) "6" else "0" }
+        val stat = "12345 (Audio (x) 1) " + fields.joinToString(" ")
+        assertEquals(6, ThreadPlacement.parseLastCpu(stat))
+        assertEquals(-1, ThreadPlacement.parseLastCpu("12345 (short) S 1"))
+    }
+}